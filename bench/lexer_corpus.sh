@@ -0,0 +1,16 @@
+#!/bin/sh
+# Writes generated script for frontend benchmark to standard output.
+# Every function is 7 lines with identifiers, numbers, operators and
+# string literals with escape sequences.
+# Usage: lexer_corpus.sh [count of functions]
+COUNT=${1:-6000}
+
+for i in $(seq 0 $((COUNT - 1))); do
+  printf 'fn func_%d(alpha, beta)\n' "$i"
+  printf "  local value_%d = alpha * %d + beta / 3.5 - 'text\\\\n %d'.size()\n" "$i" "$i" "$i"
+  printf "  if value_%d >= %d && beta != 'x'\n" "$i" "$i"
+  printf '    return [alpha, beta, %d]\n' "$i"
+  printf '  end\n'
+  printf '  return value_%d\n' "$i"
+  printf 'end\n'
+done
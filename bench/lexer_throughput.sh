@@ -0,0 +1,40 @@
+#!/bin/sh
+# Measures frontend(lexing and parsing) throughput in MB/s.
+# Runs on generated corpus are timed without .kgc cache and with warm
+# cache. The difference is the time spent in frontend, including writing
+# the cache file. Best of 5 runs.
+# Usage: lexer_throughput.sh [path of kagami executable] [count of functions]
+KAGAMI=$(command -v "${1:-kagami}" || echo "${1:-kagami}")
+DIR=$(cd "$(dirname "$0")" && pwd)
+WORK=${TMPDIR:-/tmp}/kagami_lexer_throughput.$$
+SCRIPT=$WORK/corpus.kagami
+CACHE=$WORK/corpus.kgc
+
+mkdir -p "$WORK" || exit 1
+"$DIR/lexer_corpus.sh" "${2:-6000}" > "$SCRIPT"
+bytes=$(wc -c < "$SCRIPT")
+
+best_run() {
+  best=0
+  for run in 1 2 3 4 5; do
+    [ "$1" = cold ] && rm -f "$CACHE"
+    start=$(date +%s%N)
+    "$KAGAMI" -script="$SCRIPT" -frontend_threads=1 > /dev/null 2>&1
+    end=$(date +%s%N)
+    elapsed=$(( (end - start) / 1000 ))
+    if [ "$best" -eq 0 ] || [ "$elapsed" -lt "$best" ]; then best=$elapsed; fi
+  done
+  echo "$best"
+}
+
+cold=$(best_run cold)
+warm=$(best_run warm)
+frontend=$((cold - warm))
+
+echo "corpus $bytes bytes"
+echo "without cache $cold us, with cache $warm us"
+if [ "$frontend" -gt 0 ]; then
+  #bytes per microsecond equals MB/s
+  echo "frontend $(echo "$bytes $frontend" | awk '{ printf "%.1f", $1 / $2 }') MB/s"
+fi
+rm -rf "$WORK"
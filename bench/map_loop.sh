@@ -0,0 +1,15 @@
+#!/bin/sh
+# Times map() with a script callback against a hand-written loop.
+# Usage: map_loop.sh [path of kagami executable]
+KAGAMI=${1:-kagami}
+DIR=$(dirname "$0")
+
+for kind in array int_array; do
+  for mode in none map loop; do
+    start=$(date +%s%N)
+    printf '%s\n%s\n' "$mode" "$kind" |
+      "$KAGAMI" -script="$DIR/map_loop.kagami" > /dev/null 2>&1
+    end=$(date +%s%N)
+    echo "$kind $mode $(( (end - start) / 1000000 )) ms"
+  done
+done
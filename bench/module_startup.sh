@@ -0,0 +1,44 @@
+#!/bin/sh
+# Times startup of a script which imports a tree of 50 modules.
+# Module i imports modules 2i+1 and 2i+2, every module imports a shared
+# common module. Each module defines 22 functions.
+# Usage: module_startup.sh [path of kagami executable] [runs]
+KAGAMI=$(command -v "${1:-kagami}" || echo "${1:-kagami}")
+RUNS=${2:-100}
+MODULES=50
+DIR=${TMPDIR:-/tmp}/kagami_module_startup.$$
+
+mkdir -p "$DIR" && cd "$DIR" || exit 1
+
+{
+  for f in $(seq 0 19); do
+    printf 'fn common_f%d(a)\n  return a + %d\nend\n' "$f" "$f"
+  done
+} > common.kagami
+
+for m in $(seq 0 $((MODULES - 1))); do
+  {
+    for child in $((m * 2 + 1)) $((m * 2 + 2)); do
+      [ "$child" -lt "$MODULES" ] && printf "using 'm%d.kagami'\n" "$child"
+    done
+    printf "using 'common.kagami'\n"
+    for f in $(seq 0 21); do
+      printf 'fn m%d_f%d(a, b)\n  return a + b * %d\nend\n' "$m" "$f" "$f"
+    done
+  } > "m$m.kagami"
+done
+
+printf "using 'm0.kagami'\nusing 'common.kagami'\nprint(m%d_f3(1, 2))\n" \
+  $((MODULES - 1)) > main.kagami
+
+#First run writes .kgc cache of every module
+"$KAGAMI" -script=main.kagami > /dev/null 2>&1
+
+start=$(date +%s%N)
+for run in $(seq "$RUNS"); do
+  "$KAGAMI" -script=main.kagami > /dev/null 2>&1
+done
+end=$(date +%s%N)
+
+echo "$MODULES modules, $RUNS runs: $(( (end - start) / RUNS / 1000 )) us per run"
+cd / && rm -rf "$DIR"
@@ -0,0 +1,15 @@
+#!/bin/sh
+# Times numeric array kernels against interpreted loops.
+# Usage: numeric_kernels.sh [path of kagami executable]
+KAGAMI=${1:-kagami}
+DIR=$(dirname "$0")
+
+for kernel in none sum min max dot add mul div fill iota count_if prefix_sum; do
+  for mode in native loop; do
+    start=$(date +%s%N)
+    printf '%s\n%s\n' "$kernel" "$mode" |
+      "$KAGAMI" -script="$DIR/numeric_kernels.kagami" > /dev/null 2>&1
+    end=$(date +%s%N)
+    echo "$kernel $mode $(( (end - start) / 1000000 )) ms"
+  done
+done
@@ -0,0 +1,18 @@
+#!/bin/sh
+# Times array push/pop intrinsics against the same loops without method
+# calls. Best of 5 runs.
+# Usage: push_pop.sh [path of kagami executable]
+KAGAMI=${1:-kagami}
+DIR=$(dirname "$0")
+
+for mode in method loop; do
+  best=0
+  for run in 1 2 3 4 5; do
+    start=$(date +%s%N)
+    echo "$mode" | "$KAGAMI" -script="$DIR/push_pop.kagami" > /dev/null 2>&1
+    end=$(date +%s%N)
+    elapsed=$(( (end - start) / 1000000 ))
+    if [ "$best" -eq 0 ] || [ "$elapsed" -lt "$best" ]; then best=$elapsed; fi
+  done
+  echo "$mode $best ms"
+done
@@ -0,0 +1,92 @@
+/*
+  Byte string search kernels against std::string_view on a log-sized
+  buffer, see string_search.sh. Prints best time per pass in ms.
+*/
+#include "kernels.h"
+#include <chrono>
+
+using namespace kagami;
+using Clock = std::chrono::steady_clock;
+
+string BuildLog(size_t lines) {
+  string result;
+  char buffer[128];
+
+  for (size_t idx = 0; idx < lines; ++idx) {
+    snprintf(buffer, sizeof(buffer),
+      "2024-05-%02zu 12:%02zu:%02zu INFO [worker-%zu] GET /api/v1/items/%zu 200 %zums\n",
+      idx % 28 + 1, idx % 60, idx % 59, idx % 16, idx, idx % 997);
+    result.append(buffer);
+  }
+
+  return result;
+}
+
+template <typename Func>
+double BestOf(size_t passes, Func func) {
+  double best = 0;
+  size_t sink = 0;
+
+  for (size_t pass = 0; pass < passes; ++pass) {
+    auto start = Clock::now();
+    sink += func();
+    std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+    if (pass == 0 || elapsed.count() < best) best = elapsed.count();
+  }
+
+  if (sink == 1) puts("");
+  return best;
+}
+
+size_t CountStdFind(string_view log, string_view target) {
+  size_t count = 0;
+  for (auto pos = log.find(target); pos != string_view::npos;
+    pos = log.find(target, pos + target.size())) {
+    ++count;
+  }
+  return count;
+}
+
+size_t CountKernelFind(string_view log, string_view target) {
+  size_t count = 0, begin = 0;
+
+  while (begin < log.size()) {
+    auto pos = kernel::FindString(log.data() + begin, log.size() - begin,
+      target.data(), target.size());
+    if (pos == string_view::npos) break;
+    ++count;
+    begin += pos + target.size();
+  }
+
+  return count;
+}
+
+void Report(const char *name, string_view log, string_view target) {
+  auto std_time = BestOf(20, [&] { return CountStdFind(log, target); });
+  auto kernel_time = BestOf(20, [&] { return CountKernelFind(log, target); });
+  printf("%-36s string_view::find %6.2f  FindString %6.2f\n", name, std_time, kernel_time);
+}
+
+int main() {
+  auto log = BuildLog(100000);
+  string_view view(log);
+  printf("log %zu bytes, ms per pass\n", log.size());
+
+  //string_view::find runs memchr on first byte, it's fastest when that
+  //byte is rare and slowest when it's frequent
+  Report("absent, rare first byte", view, "not-found!");
+  Report("absent, frequent first byte", view, "2024-06-01");
+  Report("dense, rare first byte 'INFO'", view, "INFO");
+  Report("dense, rare first byte 'GET /api'", view, "GET /api");
+  Report("dense, frequent first byte ':1'", view, ":1");
+  Report("dense, frequent first byte '0 '", view, "0 ");
+  Report("sparse, frequent first byte", view, "s\n2024-05-28 12:59");
+
+  auto rfind_time = BestOf(20, [&] { return view.rfind('~'); });
+  auto kernel_rfind_time = BestOf(20, [&] {
+    return kernel::FindLastChar(view.data(), view.size(), '~');
+  });
+  printf("%-36s string_view::rfind %5.2f  FindLastChar %5.2f\n",
+    "absent byte, backwards", rfind_time, kernel_rfind_time);
+  return 0;
+}
@@ -0,0 +1,10 @@
+#!/bin/sh
+# Builds and runs byte string search benchmark against src/kernels.cc.
+# Usage: string_search.sh [C++ compiler]
+CXX=${1:-c++}
+DIR=$(cd "$(dirname "$0")" && pwd)
+OUT=${TMPDIR:-/tmp}/kagami_string_search.$$
+
+"$CXX" -std=c++17 -O2 -I"$DIR/../src" "$DIR/../src/kernels.cc" \
+  "$DIR/string_search.cc" -o "$OUT" && "$OUT"
+rm -f "$OUT"
@@ -0,0 +1,15 @@
+#!/bin/sh
+# Times 1M table operations, lookup and erase include filling the table.
+# Usage: table_ops.sh [path of kagami executable]
+KAGAMI=${1:-kagami}
+DIR=$(dirname "$0")
+
+for kind in int string; do
+  for op in none insert lookup erase; do
+    start=$(date +%s%N)
+    printf '%s\n%s\n' "$op" "$kind" |
+      "$KAGAMI" -script="$DIR/table_ops.kagami" > /dev/null 2>&1
+    end=$(date +%s%N)
+    echo "$kind $op $(( (end - start) / 1000000 )) ms"
+  done
+done
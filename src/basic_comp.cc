@@ -70,6 +70,20 @@ namespace kagami {
       return Message();
     }
 
+    if (type_id == kTypeIdStringView) {
+      auto view = obj.Cast<StringSlice>().View();
+      fwrite(view.data(), sizeof(char), view.size(), VM_STDOUT);
+      CHECK_PRINT_OPT(p);
+      return Message();
+    }
+
+    if (type_id == kTypeIdUTF8String) {
+      auto &data = obj.Cast<UTF8String>().Data();
+      fwrite(data.data(), sizeof(char), data.size(), VM_STDOUT);
+      CHECK_PRINT_OPT(p);
+      return Message();
+    }
+
     vector<string> methods = management::type::GetMethods(obj.GetTypeId());
 
     //TODO: add support of user-defined type
@@ -275,6 +289,24 @@ namespace kagami {
     return Message().SetObject(Object(value.extension().string(), kTypeIdString));
   }
 
+  Message GetMemoryUsage(ObjectMap &) {
+    ManagedTable table = make_shared<ObjectTable>();
+    
+    for (auto &unit : management::accounting::CollectAllocationStats()) {
+      ManagedTable stat = make_shared<ObjectTable>();
+      stat->insert(make_pair(Object(string("count")), 
+        Object(static_cast<int64_t>(unit.count), kTypeIdInt)));
+      stat->insert(make_pair(Object(string("bytes")), 
+        Object(static_cast<int64_t>(unit.bytes), kTypeIdInt)));
+      table->insert(make_pair(Object(unit.type_id), Object(stat, kTypeIdTable)));
+    }
+
+    Message msg = allocation_accounting ?
+      Message() :
+      Message("Allocation accounting is disabled, use memory_stats option", kStateWarning);
+    return msg.SetObject(Object(table, kTypeIdTable));
+  }
+
   void InitConsoleComponents() {
     using management::CreateImpl;
 
@@ -298,5 +330,6 @@ namespace kagami {
     CreateImpl(FunctionImpl(CopyFSFile, "from|to", "copy_file"));
     CreateImpl(FunctionImpl(GetDirectoryContent, "path", "dir_content"));
     CreateImpl(FunctionImpl(GetFilenameExtension, "path", "filename_ext"));
+    CreateImpl(FunctionImpl(GetMemoryUsage, "", "memory_usage"));
   }
 }
@@ -0,0 +1,348 @@
+#include "management.h"
+#include "btree.h"
+
+namespace kagami {
+  SortKey MakeSortKey(Object &obj) {
+    SortKey key;
+    auto &type_id = obj.GetTypeId();
+
+    if (type_id == kTypeIdInt) {
+      key.kind = kSortKeyInt;
+      key.int_value = obj.Cast<int64_t>();
+    }
+    else if (type_id == kTypeIdFloat) {
+      //NaN is unordered, it's left as invalid key
+      auto value = obj.Cast<double>();
+      if (!std::isnan(value)) {
+        key.kind = kSortKeyFloat;
+        key.float_value = value;
+      }
+    }
+    else if (type_id == kTypeIdBool) {
+      key.kind = kSortKeyBool;
+      key.int_value = obj.Cast<bool>() ? 1 : 0;
+    }
+    else if (type_id == kTypeIdString) {
+      key.kind = kSortKeyString;
+      key.str_value = obj.Cast<string>();
+    }
+
+    return key;
+  }
+
+  inline int SortKeyRank(SortKeyKind kind) {
+    return kind == kSortKeyFloat ? int(kSortKeyInt) : int(kind);
+  }
+
+  template <typename T>
+  inline int ThreeWayCompare(T lhs, T rhs) {
+    return lhs < rhs ? -1 : (rhs < lhs ? 1 : 0);
+  }
+
+  int CompareSortKey(const SortKey &lhs, const SortKey &rhs) {
+    auto lhs_rank = SortKeyRank(lhs.kind), rhs_rank = SortKeyRank(rhs.kind);
+    if (lhs_rank != rhs_rank) return lhs_rank < rhs_rank ? -1 : 1;
+
+    int result = 0;
+
+    switch (lhs.kind) {
+    case kSortKeyBool:
+      result = ThreeWayCompare(lhs.int_value, rhs.int_value);
+      break;
+    case kSortKeyString:
+      result = lhs.str_value.compare(rhs.str_value);
+      result = result < 0 ? -1 : (result > 0 ? 1 : 0);
+      break;
+    default:
+      //int/float mixed comparison, long double keeps int64 value exactly
+      if (lhs.kind == kSortKeyInt && rhs.kind == kSortKeyInt) {
+        result = ThreeWayCompare(lhs.int_value, rhs.int_value);
+      }
+      else {
+        long double lhs_value = lhs.kind == kSortKeyInt ?
+          static_cast<long double>(lhs.int_value) : lhs.float_value;
+        long double rhs_value = rhs.kind == kSortKeyInt ?
+          static_cast<long double>(rhs.int_value) : rhs.float_value;
+        result = ThreeWayCompare(lhs_value, rhs_value);
+        if (result == 0) result = ThreeWayCompare(int(lhs.kind), int(rhs.kind));
+      }
+      break;
+    }
+
+    return result;
+  }
+
+  /* Position helpers for sorted key vector */
+  inline size_t LowerBound(const vector<SortKey> &keys, const SortKey &key) {
+    size_t low = 0, high = keys.size();
+
+    while (low < high) {
+      size_t mid = (low + high) / 2;
+      if (CompareSortKey(keys[mid], key) < 0) low = mid + 1;
+      else high = mid;
+    }
+
+    return low;
+  }
+
+  inline size_t UpperBound(const vector<SortKey> &keys, const SortKey &key) {
+    size_t low = 0, high = keys.size();
+
+    while (low < high) {
+      size_t mid = (low + high) / 2;
+      if (CompareSortKey(keys[mid], key) <= 0) low = mid + 1;
+      else high = mid;
+    }
+
+    return low;
+  }
+
+  SortedTable::SortedTable(const SortedTable &rhs) :
+    root_(make_unique<Node>(true)), size_(0),
+    version_(make_shared<size_t>(0)) {
+    operator=(rhs);
+  }
+
+  SortedTable &SortedTable::operator=(const SortedTable &rhs) {
+    if (this == &rhs) return *this;
+
+    clear();
+    auto &source = const_cast<SortedTable &>(rhs);
+
+    for (auto it = source.begin(); it != source.end(); ++it) {
+      insert(it->first, it->second);
+    }
+
+    return *this;
+  }
+
+  unique_ptr<SortedTable::Node> SortedTable::InsertImpl(Node *node, SortKey &key,
+    Object &key_obj, Object &value, SortKey &separator, ObjectPair *&result,
+    bool &inserted) {
+    if (node->leaf) {
+      size_t pos = LowerBound(node->keys, key);
+
+      if (pos < node->keys.size() && CompareSortKey(node->keys[pos], key) == 0) {
+        result = node->values[pos].get();
+        inserted = false;
+        return nullptr;
+      }
+
+      node->keys.insert(node->keys.begin() + pos, key);
+      node->values.insert(node->values.begin() + pos,
+        make_unique<ObjectPair>(key_obj, value));
+      result = node->values[pos].get();
+      inserted = true;
+
+      if (node->keys.size() <= kMaxKeys) return nullptr;
+
+      auto right = make_unique<Node>(true);
+      size_t mid = node->keys.size() / 2;
+      std::move(node->keys.begin() + mid, node->keys.end(),
+        std::back_inserter(right->keys));
+      std::move(node->values.begin() + mid, node->values.end(),
+        std::back_inserter(right->values));
+      node->keys.resize(mid);
+      node->values.resize(mid);
+
+      right->next = node->next;
+      right->prev = node;
+      if (node->next != nullptr) node->next->prev = right.get();
+      node->next = right.get();
+
+      separator = right->keys.front();
+      return right;
+    }
+
+    size_t idx = UpperBound(node->keys, key);
+    SortKey child_separator;
+    auto child_right = InsertImpl(node->children[idx].get(), key, key_obj, value,
+      child_separator, result, inserted);
+
+    if (child_right == nullptr) return nullptr;
+
+    node->keys.insert(node->keys.begin() + idx, std::move(child_separator));
+    node->children.insert(node->children.begin() + idx + 1, std::move(child_right));
+
+    if (node->keys.size() <= kMaxKeys) return nullptr;
+
+    auto right = make_unique<Node>(false);
+    size_t mid = node->keys.size() / 2;
+    separator = std::move(node->keys[mid]);
+    std::move(node->keys.begin() + mid + 1, node->keys.end(),
+      std::back_inserter(right->keys));
+    std::move(node->children.begin() + mid + 1, node->children.end(),
+      std::back_inserter(right->children));
+    node->keys.resize(mid);
+    node->children.resize(mid + 1);
+    return right;
+  }
+
+  pair<ObjectPair *, bool> SortedTable::insert(Object &key, Object &value) {
+    auto sort_key = MakeSortKey(key);
+    SortKey separator;
+    ObjectPair *result = nullptr;
+    bool inserted = false;
+
+    auto right = InsertImpl(root_.get(), sort_key, key, value,
+      separator, result, inserted);
+
+    if (right != nullptr) {
+      auto new_root = make_unique<Node>(false);
+      new_root->keys.emplace_back(std::move(separator));
+      new_root->children.emplace_back(std::move(root_));
+      new_root->children.emplace_back(std::move(right));
+      root_ = std::move(new_root);
+    }
+
+    if (inserted) {
+      size_ += 1;
+      *version_ += 1;
+    }
+
+    return make_pair(result, inserted);
+  }
+
+  SortedTable::Node *SortedTable::FindLeaf(const SortKey &key) const {
+    Node *node = root_.get();
+
+    while (!node->leaf) {
+      node = node->children[UpperBound(node->keys, key)].get();
+    }
+
+    return node;
+  }
+
+  SortedTable::iterator SortedTable::find(Object &key) {
+    auto sort_key = MakeSortKey(key);
+    auto *leaf = FindLeaf(sort_key);
+    size_t pos = LowerBound(leaf->keys, sort_key);
+
+    if (pos < leaf->keys.size() && CompareSortKey(leaf->keys[pos], sort_key) == 0) {
+      return iterator(this, leaf, pos);
+    }
+
+    return end();
+  }
+
+  SortedTable::iterator SortedTable::lower_bound(Object &key) {
+    auto sort_key = MakeSortKey(key);
+    auto *leaf = FindLeaf(sort_key);
+    return iterator(this, leaf, LowerBound(leaf->keys, sort_key));
+  }
+
+  SortedTable::iterator SortedTable::upper_bound(Object &key) {
+    auto sort_key = MakeSortKey(key);
+    auto *leaf = FindLeaf(sort_key);
+    return iterator(this, leaf, UpperBound(leaf->keys, sort_key));
+  }
+
+  //Separators are not updated after erasing, they are still valid bounds
+  bool SortedTable::EraseImpl(Node *node, const SortKey &key) {
+    if (node->leaf) {
+      size_t pos = LowerBound(node->keys, key);
+
+      if (pos >= node->keys.size() || CompareSortKey(node->keys[pos], key) != 0) {
+        return false;
+      }
+
+      node->keys.erase(node->keys.begin() + pos);
+      node->values.erase(node->values.begin() + pos);
+      return true;
+    }
+
+    size_t idx = UpperBound(node->keys, key);
+    if (!EraseImpl(node->children[idx].get(), key)) return false;
+    if (node->children[idx]->keys.size() < kMinKeys) Rebalance(node, idx);
+    return true;
+  }
+
+  void SortedTable::Rebalance(Node *node, size_t idx) {
+    auto *child = node->children[idx].get();
+    auto *left = idx > 0 ? node->children[idx - 1].get() : nullptr;
+    auto *right = idx + 1 < node->children.size() ? node->children[idx + 1].get() : nullptr;
+
+    if (child->leaf) {
+      if (left != nullptr && left->keys.size() > kMinKeys) {
+        child->keys.insert(child->keys.begin(), std::move(left->keys.back()));
+        child->values.insert(child->values.begin(), std::move(left->values.back()));
+        left->keys.pop_back();
+        left->values.pop_back();
+        node->keys[idx - 1] = child->keys.front();
+      }
+      else if (right != nullptr && right->keys.size() > kMinKeys) {
+        child->keys.emplace_back(std::move(right->keys.front()));
+        child->values.emplace_back(std::move(right->values.front()));
+        right->keys.erase(right->keys.begin());
+        right->values.erase(right->values.begin());
+        node->keys[idx] = right->keys.front();
+      }
+      else {
+        //Merge right node into left node
+        size_t left_idx = left != nullptr ? idx - 1 : idx;
+        auto *dest = node->children[left_idx].get();
+        auto *src = node->children[left_idx + 1].get();
+        std::move(src->keys.begin(), src->keys.end(), std::back_inserter(dest->keys));
+        std::move(src->values.begin(), src->values.end(), std::back_inserter(dest->values));
+        dest->next = src->next;
+        if (src->next != nullptr) src->next->prev = dest;
+        node->keys.erase(node->keys.begin() + left_idx);
+        node->children.erase(node->children.begin() + left_idx + 1);
+      }
+
+      return;
+    }
+
+    if (left != nullptr && left->keys.size() > kMinKeys) {
+      child->keys.insert(child->keys.begin(), std::move(node->keys[idx - 1]));
+      child->children.insert(child->children.begin(), std::move(left->children.back()));
+      node->keys[idx - 1] = std::move(left->keys.back());
+      left->keys.pop_back();
+      left->children.pop_back();
+    }
+    else if (right != nullptr && right->keys.size() > kMinKeys) {
+      child->keys.emplace_back(std::move(node->keys[idx]));
+      child->children.emplace_back(std::move(right->children.front()));
+      node->keys[idx] = std::move(right->keys.front());
+      right->keys.erase(right->keys.begin());
+      right->children.erase(right->children.begin());
+    }
+    else {
+      size_t left_idx = left != nullptr ? idx - 1 : idx;
+      auto *dest = node->children[left_idx].get();
+      auto *src = node->children[left_idx + 1].get();
+      dest->keys.emplace_back(std::move(node->keys[left_idx]));
+      std::move(src->keys.begin(), src->keys.end(), std::back_inserter(dest->keys));
+      std::move(src->children.begin(), src->children.end(),
+        std::back_inserter(dest->children));
+      node->keys.erase(node->keys.begin() + left_idx);
+      node->children.erase(node->children.begin() + left_idx + 1);
+    }
+  }
+
+  size_t SortedTable::erase(Object &key) {
+    auto sort_key = MakeSortKey(key);
+    if (!EraseImpl(root_.get(), sort_key)) return 0;
+
+    if (!root_->leaf && root_->keys.empty()) {
+      auto new_root = std::move(root_->children.front());
+      root_ = std::move(new_root);
+    }
+
+    size_ -= 1;
+    *version_ += 1;
+    return 1;
+  }
+
+  void SortedTable::clear() {
+    root_ = make_unique<Node>(true);
+    size_ = 0;
+    *version_ += 1;
+  }
+
+  SortedTable::iterator SortedTable::begin() {
+    Node *node = root_.get();
+    while (!node->leaf) node = node->children.front().get();
+    return iterator(this, node, 0);
+  }
+}
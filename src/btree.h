@@ -0,0 +1,145 @@
+#pragma once
+#include "object.h"
+/*
+  B+ tree for sorted_table type.
+  Keys must be plain type objects(bool/int/float/string). Numbers are
+  ordered by value regardless of int/float type(int comes first if equal),
+  then ordered by type rank: bool < number < string. NaN can't be a key.
+  Key/value pairs are allocated separately, so references to them stay
+  valid while nodes are split or merged. Iterators point into leaf nodes,
+  they are invalidated by inserting new key, erasing, clearing and
+  destroying the table. Holders of iterators must check IsValid() before
+  using them.
+*/
+namespace kagami {
+  enum SortKeyKind {
+    kSortKeyBool = 0,
+    kSortKeyInt = 1,
+    kSortKeyFloat = 2,
+    kSortKeyString = 3,
+    kSortKeyInvalid = 4
+  };
+
+  struct SortKey {
+    SortKeyKind kind;
+    int64_t int_value;
+    double float_value;
+    string str_value;
+
+    SortKey() : kind(kSortKeyInvalid), int_value(0), float_value(0), str_value() {}
+  };
+
+  SortKey MakeSortKey(Object &obj);
+  int CompareSortKey(const SortKey &lhs, const SortKey &rhs);
+
+  class SortedTable {
+  private:
+    static constexpr size_t kMaxKeys = 31;
+    static constexpr size_t kMinKeys = kMaxKeys / 2;
+
+    struct Node {
+      bool leaf;
+      vector<SortKey> keys;
+      vector<unique_ptr<Node>> children;
+      vector<unique_ptr<ObjectPair>> values;
+      Node *prev;
+      Node *next;
+
+      Node(bool leaf) : leaf(leaf), keys(), children(), values(),
+        prev(nullptr), next(nullptr) {
+        keys.reserve(kMaxKeys + 1);
+        if (leaf) values.reserve(kMaxKeys + 1);
+        else children.reserve(kMaxKeys + 2);
+      }
+    };
+
+  public:
+    class iterator {
+    private:
+      shared_ptr<const size_t> version_cell_;
+      size_t version_;
+      Node *leaf_;
+      size_t index_;
+
+    public:
+      iterator() : version_cell_(), version_(0), leaf_(nullptr), index_(0) {}
+      iterator(const SortedTable *table, Node *leaf, size_t index) :
+        version_cell_(table->version_), version_(*table->version_),
+        leaf_(leaf), index_(index) {
+        if (leaf_ != nullptr && index_ >= leaf_->keys.size()) {
+          leaf_ = leaf_->next;
+          index_ = 0;
+        }
+      }
+
+      ObjectPair &operator*() const { return *leaf_->values[index_]; }
+      ObjectPair *operator->() const { return leaf_->values[index_].get(); }
+      const SortKey &GetKey() const { return leaf_->keys[index_]; }
+
+      //End iterator is always valid
+      bool IsValid() const {
+        return version_cell_ == nullptr || *version_cell_ == version_;
+      }
+
+      iterator &operator++() {
+        ++index_;
+        if (index_ >= leaf_->keys.size()) {
+          leaf_ = leaf_->next;
+          index_ = 0;
+        }
+        return *this;
+      }
+
+      iterator operator++(int) {
+        iterator temp(*this);
+        ++(*this);
+        return temp;
+      }
+
+      bool operator==(const iterator &rhs) const
+      { return leaf_ == rhs.leaf_ && index_ == rhs.index_; }
+      bool operator!=(const iterator &rhs) const
+      { return !operator==(rhs); }
+    };
+
+  private:
+    unique_ptr<Node> root_;
+    size_t size_;
+    //Modification counter, shared with iterators so they can outlive table
+    shared_ptr<size_t> version_;
+
+  private:
+    unique_ptr<Node> InsertImpl(Node *node, SortKey &key, Object &key_obj,
+      Object &value, SortKey &separator, ObjectPair *&result, bool &inserted);
+    bool EraseImpl(Node *node, const SortKey &key);
+    void Rebalance(Node *node, size_t idx);
+    Node *FindLeaf(const SortKey &key) const;
+
+  public:
+    SortedTable() : root_(make_unique<Node>(true)), size_(0),
+      version_(make_shared<size_t>(0)) {}
+    SortedTable(const SortedTable &rhs);
+    ~SortedTable() { *version_ += 1; }
+    SortedTable &operator=(const SortedTable &rhs);
+
+    //Key object must be copied by caller
+    pair<ObjectPair *, bool> insert(Object &key, Object &value);
+    iterator find(Object &key);
+    iterator lower_bound(Object &key);
+    iterator upper_bound(Object &key);
+    size_t erase(Object &key);
+    void clear();
+
+    iterator begin();
+    iterator end() { return iterator(); }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+  };
+
+  /* View of [begin, end) range in sorted_table */
+  struct SortedRange {
+    Object table;
+    SortedTable::iterator begin;
+    SortedTable::iterator end;
+  };
+}
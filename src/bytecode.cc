@@ -0,0 +1,300 @@
+#include "bytecode.h"
+#include <cstring>
+
+namespace kagami {
+  //Format version of cache file. Bump it whenever the layout below, the
+  //values of Keyword/ArgumentType/StringType/RequestType or the lowering
+  //in frontend are changed.
+  const uint32_t kBytecodeVersion = 3;
+  const char kBytecodeMagic[4] = { 'K', 'G', 'C', '1' };
+
+  class BytecodeWriter {
+  private:
+    string buffer_;
+
+  public:
+    template <typename T>
+    void Write(T value) {
+      static_assert(std::is_trivially_copyable_v<T>, "Not a plain value");
+      buffer_.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    void WriteString(const string &str) {
+      Write<uint64_t>(str.size());
+      buffer_.append(str);
+    }
+
+    string &GetBuffer() { return buffer_; }
+  };
+
+  class BytecodeReader {
+  private:
+    string_view buffer_;
+    size_t pos_;
+    bool good_;
+
+  public:
+    BytecodeReader(string_view buffer) : buffer_(buffer), pos_(0), good_(true) {}
+
+    template <typename T>
+    T Read() {
+      T value{};
+
+      if (!good_ || buffer_.size() - pos_ < sizeof(T)) {
+        good_ = false;
+        return value;
+      }
+
+      std::memcpy(&value, buffer_.data() + pos_, sizeof(T));
+      pos_ += sizeof(T);
+      return value;
+    }
+
+    string ReadString() {
+      auto size = Read<uint64_t>();
+
+      if (!good_ || buffer_.size() - pos_ < size) {
+        good_ = false;
+        return string();
+      }
+
+      string result(buffer_.substr(pos_, size));
+      pos_ += size;
+      return result;
+    }
+
+    //Value greater than last enumerator means broken or incompatible file
+    template <typename T>
+    T ReadEnum(T last) {
+      auto value = Read<uint32_t>();
+
+      if (value > static_cast<uint32_t>(last)) {
+        good_ = false;
+        return last;
+      }
+
+      return static_cast<T>(value);
+    }
+
+    bool Good() const { return good_; }
+    bool Finished() const { return pos_ == buffer_.size(); }
+    string_view Remaining() const { return buffer_.substr(pos_); }
+  };
+
+  void WriteArgument(BytecodeWriter &writer, const Argument &arg) {
+    writer.WriteString(arg.GetData());
+    writer.Write<uint32_t>(arg.GetType());
+    writer.Write<uint32_t>(arg.GetStringType());
+    writer.Write<uint8_t>(arg.option.optional_param);
+    writer.Write<uint8_t>(arg.option.variable_param);
+    writer.Write<uint8_t>(arg.option.use_last_assert);
+    writer.Write<uint8_t>(arg.option.assert_chain_tail);
+    writer.Write<uint8_t>(arg.option.is_constraint);
+    writer.WriteString(arg.option.domain);
+    writer.Write<uint32_t>(arg.option.domain_type);
+  }
+
+  Argument ReadArgument(BytecodeReader &reader) {
+    auto data = reader.ReadString();
+    auto type = reader.ReadEnum(kArgumentNull);
+    auto token_type = reader.ReadEnum(kStringTypeNull);
+    Argument arg(data, type, token_type);
+    arg.option.optional_param = reader.Read<uint8_t>() != 0;
+    arg.option.variable_param = reader.Read<uint8_t>() != 0;
+    arg.option.use_last_assert = reader.Read<uint8_t>() != 0;
+    arg.option.assert_chain_tail = reader.Read<uint8_t>() != 0;
+    arg.option.is_constraint = reader.Read<uint8_t>() != 0;
+    auto domain = reader.ReadString();
+    arg.SetDomain(domain, reader.ReadEnum(kArgumentNull));
+    return arg;
+  }
+
+  void WriteRequest(BytecodeWriter &writer, Request &req) {
+    writer.Write<uint32_t>(req.type);
+
+    if (req.type == kRequestCommand) {
+      writer.Write<uint32_t>(req.GetKeywordValue());
+    }
+    else if (req.type == kRequestFunction) {
+      auto &domain = req.GetInterfaceDomain();
+      writer.WriteString(req.GetInterfaceId());
+      WriteArgument(writer, domain);
+    }
+
+    writer.Write<uint64_t>(req.idx);
+    writer.Write<uint8_t>(req.option.void_call);
+    writer.Write<uint8_t>(req.option.local_object);
+    writer.Write<uint8_t>(req.option.ext_object);
+    writer.Write<uint8_t>(req.option.use_last_assert);
+    writer.Write<uint64_t>(req.option.nest);
+    writer.Write<uint64_t>(req.option.nest_end);
+    writer.Write<uint64_t>(req.option.escape_depth);
+    writer.Write<uint32_t>(req.option.nest_root);
+  }
+
+  Request ReadRequest(BytecodeReader &reader) {
+    Request req;
+    auto type = reader.ReadEnum(kRequestNull);
+
+    if (type == kRequestCommand) {
+      req = Request(reader.ReadEnum(kKeywordNull));
+    }
+    else if (type == kRequestFunction) {
+      auto id = reader.ReadString();
+      auto domain = ReadArgument(reader);
+      req = Request(id, domain);
+    }
+
+    req.idx = reader.Read<uint64_t>();
+    req.option.void_call = reader.Read<uint8_t>() != 0;
+    req.option.local_object = reader.Read<uint8_t>() != 0;
+    req.option.ext_object = reader.Read<uint8_t>() != 0;
+    req.option.use_last_assert = reader.Read<uint8_t>() != 0;
+    req.option.nest = reader.Read<uint64_t>();
+    req.option.nest_end = reader.Read<uint64_t>();
+    req.option.escape_depth = reader.Read<uint64_t>();
+    req.option.nest_root = reader.ReadEnum(kKeywordNull);
+    return req;
+  }
+
+  //FNV-1a
+  uint64_t HashScriptContent(string_view content) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    for (auto unit : content) {
+      hash ^= static_cast<uint8_t>(unit);
+      hash *= 0x100000001b3ULL;
+    }
+
+    return hash;
+  }
+
+  //Jump targets are resolved from nest/nest_end and jump records by optimizer,
+  //so every index of them must point into loaded code
+  bool IsCodeIndexValid(VMCode &code) {
+    auto size = code.size();
+
+    for (auto &command : code) {
+      auto &option = command.first.option;
+      if (option.nest >= size || option.nest_end >= size) return false;
+    }
+
+    for (auto &unit : code.GetJumpRecord()) {
+      if (unit.first >= size) return false;
+
+      for (auto index : unit.second) {
+        if (index >= size) return false;
+      }
+    }
+
+    return true;
+  }
+
+  string GetBytecodeCachePath(const string &script_path) {
+    return fs::path(script_path).replace_extension(kStrBytecodeExtension).string();
+  }
+
+  bool LoadBytecodeCache(const string &cache_path, uint64_t content_hash, VMCode &dest) {
+    FileView file;
+    if (!file.Open(cache_path)) return false;
+
+    BytecodeReader reader(file.Get());
+    char magic[4];
+
+    for (auto &unit : magic) unit = reader.Read<char>();
+
+    if (std::memcmp(magic, kBytecodeMagic, sizeof(magic)) != 0) return false;
+    if (reader.Read<uint32_t>() != kBytecodeVersion) return false;
+    if (reader.Read<uint64_t>() != content_hash) return false;
+
+    //Checksum of payload, content hash can't tell if cache file is damaged
+    auto payload_hash = reader.Read<uint64_t>();
+    if (!reader.Good() || HashScriptContent(reader.Remaining()) != payload_hash) return false;
+
+    auto command_count = reader.Read<uint64_t>();
+
+    for (uint64_t idx = 0; idx < command_count && reader.Good(); ++idx) {
+      Command command;
+      command.first = ReadRequest(reader);
+      auto arg_count = reader.Read<uint64_t>();
+
+      for (uint64_t arg_idx = 0; arg_idx < arg_count && reader.Good(); ++arg_idx) {
+        command.second.emplace_back(ReadArgument(reader));
+      }
+
+      dest.emplace_back(std::move(command));
+    }
+
+    auto record_count = reader.Read<uint64_t>();
+
+    for (uint64_t idx = 0; idx < record_count && reader.Good(); ++idx) {
+      auto index = reader.Read<uint64_t>();
+      auto size = reader.Read<uint64_t>();
+      list<size_t> record;
+
+      for (uint64_t unit = 0; unit < size && reader.Good(); ++unit) {
+        record.push_back(reader.Read<uint64_t>());
+      }
+
+      dest.AddJumpRecord(index, record);
+    }
+
+    if (!reader.Good() || !reader.Finished() || !IsCodeIndexValid(dest)) {
+      dest.clear();
+      dest.GetJumpRecord().clear();
+      return false;
+    }
+
+    return true;
+  }
+
+  bool SaveBytecodeCache(const string &cache_path, uint64_t content_hash, VMCode &code) {
+    BytecodeWriter header, writer;
+    writer.Write<uint64_t>(code.size());
+
+    for (auto &command : code) {
+      WriteRequest(writer, command.first);
+      writer.Write<uint64_t>(command.second.size());
+
+      for (auto &arg : command.second) {
+        WriteArgument(writer, arg);
+      }
+    }
+
+    auto &jump_record = code.GetJumpRecord();
+    writer.Write<uint64_t>(jump_record.size());
+
+    for (auto &unit : jump_record) {
+      writer.Write<uint64_t>(unit.first);
+      writer.Write<uint64_t>(unit.second.size());
+      for (auto index : unit.second) writer.Write<uint64_t>(index);
+    }
+
+    for (auto unit : kBytecodeMagic) header.Write<char>(unit);
+
+    header.Write<uint32_t>(kBytecodeVersion);
+    header.Write<uint64_t>(content_hash);
+    header.Write<uint64_t>(HashScriptContent(writer.GetBuffer()));
+
+    //Write to temporary file first, other processes may read the cache at the same time
+#if defined(_WIN32)
+    auto pid = static_cast<uint64_t>(GetCurrentProcessId());
+#else
+    auto pid = static_cast<uint64_t>(getpid());
+#endif
+    string temp_path = cache_path + "." + to_string(pid) + ".tmp";
+    FILE *fp = fopen(temp_path.data(), "wb");
+    if (fp == nullptr) return false;
+
+    auto &buffer = header.GetBuffer();
+    buffer.append(writer.GetBuffer());
+    bool good = fwrite(buffer.data(), 1, buffer.size(), fp) == buffer.size();
+    good = (fclose(fp) == 0) && good;
+
+    std::error_code error;
+    if (good) fs::rename(temp_path, cache_path, error);
+    if (!good || error) fs::remove(temp_path, error);
+
+    return good && !error;
+  }
+}
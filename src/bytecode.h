@@ -0,0 +1,17 @@
+#pragma once
+#include "vmcode.h"
+#include "filestream.h"
+/*
+  Compiled script cache(.kgc file next to script file).
+  Cache file is only accepted when format version, content hash of script
+  source and checksum of cached code are matched, and all nest/jump indexes
+  point into cached code. Otherwise the script is compiled again.
+*/
+namespace kagami {
+  const string kStrBytecodeExtension = ".kgc";
+
+  uint64_t HashScriptContent(string_view content);
+  string GetBytecodeCachePath(const string &script_path);
+  bool LoadBytecodeCache(const string &cache_path, uint64_t content_hash, VMCode &dest);
+  bool SaveBytecodeCache(const string &cache_path, uint64_t content_hash, VMCode &code);
+}
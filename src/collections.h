@@ -0,0 +1,77 @@
+#pragma once
+#include "table.h"
+/*
+  Storage of set and heap types.
+  Elements of set are kept as keys of ObjectTable, the value slots are
+  unused. Heap keeps elements in binary heap order, ordering functions are
+  supplied by container components. deque type uses ObjectArray directly.
+*/
+namespace kagami {
+  class ObjectSet {
+  private:
+    ObjectTable base_;
+
+  public:
+    class iterator {
+    private:
+      ObjectTable::iterator it_;
+
+    public:
+      iterator() : it_() {}
+      explicit iterator(ObjectTable::iterator it) : it_(it) {}
+
+      Object &operator*() const { return it_->first; }
+      Object *operator->() const { return &it_->first; }
+
+      iterator &operator++() {
+        ++it_;
+        return *this;
+      }
+
+      bool operator==(const iterator &rhs) const { return it_ == rhs.it_; }
+      bool operator!=(const iterator &rhs) const { return it_ != rhs.it_; }
+
+      bool IsValid() const { return it_.IsValid(); }
+      bool IsEnd() const { return it_.IsEnd(); }
+    };
+
+  public:
+    ObjectSet() : base_() {}
+
+    bool insert(const Object &key) {
+      return base_.insert(ObjectPair(key, Object())).second;
+    }
+
+    bool contains(const Object &key) { return base_.find(key) != base_.end(); }
+    size_t erase(const Object &key) { return base_.erase(key); }
+    void clear() { base_.clear(); }
+    void reserve(size_t count) { base_.reserve(count); }
+    size_t allocated_bytes() const { return base_.allocated_bytes(); }
+
+    iterator begin() { return iterator(base_.begin()); }
+    iterator end() { return iterator(base_.end()); }
+    size_t size() const { return base_.size(); }
+    bool empty() const { return base_.empty(); }
+  };
+
+  class ObjectHeap {
+  private:
+    vector<Object> data_;
+    Object comparator_;
+
+  public:
+    ObjectHeap() : data_(), comparator_() {}
+    explicit ObjectHeap(Object comparator) :
+      data_(), comparator_(comparator) {}
+
+    vector<Object> &GetData() { return data_; }
+    Object &GetComparator() { return comparator_; }
+    bool HasComparator() const { return !comparator_.Null(); }
+
+    Object &operator[](size_t idx) { return data_[idx]; }
+    vector<Object>::iterator begin() { return data_.begin(); }
+    vector<Object>::iterator end() { return data_.end(); }
+    size_t size() const { return data_.size(); }
+    bool empty() const { return data_.empty(); }
+  };
+}
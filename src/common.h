@@ -14,6 +14,8 @@
 #include <cstdio>
 #include <clocale>
 #include <cstdlib>
+#include <cmath>
+#include <cerrno>
 
 #include <string>
 #include <string_view>
@@ -27,7 +29,9 @@
 #include <deque>
 #include <stack>
 #include <type_traits>
+#include <limits>
 #include <functional>
+#include <algorithm>
 #include <list>
 #include <charconv>
 #include <variant>
@@ -37,7 +41,9 @@
 #include <set>
 #include <optional>
 #include <mutex>
+#include <shared_mutex>
 #include <atomic>
+#include <thread>
 
 #include "toml11/toml.hpp"
 
@@ -93,10 +99,13 @@ namespace kagami {
   using std::from_chars;
   using std::to_chars;
   using std::variant;
+  using std::monostate;
   using std::tuple;
   using std::optional;
   using std::mutex;
   using std::lock_guard;
+  using std::shared_mutex;
+  using std::shared_lock;
   
   using minatsuki::StandardLogger;
   using minatsuki::StandardCachedLogger;
@@ -134,15 +143,29 @@ namespace kagami {
   const string kTypeIdBool            = "bool";
   const string kTypeIdString          = "string";
   const string kTypeIdWideString      = "wstring";
+  const string kTypeIdStringView      = "string_view";
+  const string kTypeIdUTF8String      = "u8string";
   const string kTypeIdArray           = "array";
+  const string kTypeIdArraySlice      = "array_slice";
+  const string kTypeIdIntArray        = "int_array";
+  const string kTypeIdFloatArray      = "float_array";
+  const string kTypeIdBoolArray       = "bool_array";
+  const string kTypeIdBytes           = "bytes";
   const string kTypeIdInStream        = "instream";
   const string kTypeIdOutStream       = "outstream";
   const string kTypeIdFunction        = "function";
   const string kTypeIdFunctionPointer = "function_pointer";
+  const string kTypeIdCallbackDriver  = "callback_driver";
   const string kTypeIdObjectPointer   = "object_pointer";
   const string kTypeIdIterator        = "iterator";
   const string kTypeIdPair            = "pair";
   const string kTypeIdTable           = "table";
+  const string kTypeIdSortedTable     = "sorted_table";
+  const string kTypeIdSortedRange     = "sorted_range";
+  const string kTypeIdTableView       = "table_view";
+  const string kTypeIdSet             = "set";
+  const string kTypeIdDeque           = "deque";
+  const string kTypeIdHeap            = "heap";
   const string kTypeIdStruct          = "struct";
   const string kTypeIdWindowEvent     = "window_event";
   const string kTypeIdWindow          = "window";
@@ -1,14 +1,18 @@
 #include "containers.h"
 
 namespace kagami {
+  const string kStrInvalidIterator = "Container is modified, iterator is invalidated";
+
   Message IteratorStepForward(ObjectMap &p) {
     auto &it = p[kStrMe].Cast<UnifiedIterator>();
+    if (!it.IsValid()) return Message(kStrInvalidIterator, kStateError);
     it.StepForward();
     return Message();
   }
 
   Message IteratorStepBack(ObjectMap &p) {
     auto &it = p[kStrMe].Cast<UnifiedIterator>();
+    if (!it.IsValid()) return Message(kStrInvalidIterator, kStateError);
     it.StepBack();
     return Message();
   }
@@ -22,11 +26,16 @@ namespace kagami {
 
     auto &rhs = p[kStrRightHandSide].Cast<UnifiedIterator>();
     auto &lhs = p[kStrMe].Cast<UnifiedIterator>();
+    if (!lhs.IsValid() || !rhs.IsValid()) {
+      return Message(kStrInvalidIterator, kStateError);
+    }
+
     return Message().SetObject(lhs.Compare(rhs));
   }
 
   Message IteratorGet(ObjectMap &p) {
     auto &it = p[kStrMe].Cast<UnifiedIterator>();
+    if (!it.IsValid()) return Message(kStrInvalidIterator, kStateError);
     return Message().SetObject(it.Unpack());
   }
 
@@ -117,6 +126,138 @@ namespace kagami {
     return Message().SetObject(Object(it, kTypeIdIterator));
   }
 
+  //Slice of slice refers to source array/string directly
+  Message NewSlice(ObjectMap &p) {
+    auto tc = TypeChecking(
+      {
+        Expect("start", kTypeIdInt),
+        Expect("size", kTypeIdInt)
+      }, p
+    );
+
+    if (TC_FAIL(tc)) return TC_ERROR(tc);
+
+    auto &src = p["src"];
+    auto &type_id = src.GetTypeId();
+    auto start = p.Cast<int64_t>("start");
+    auto size = p.Cast<int64_t>("size");
+    size_t total = 0;
+
+    if (type_id == kTypeIdArray) total = src.Cast<ObjectArray>().size();
+    else if (type_id == kTypeIdArraySlice) total = src.Cast<ArraySlice>().size();
+    else if (type_id == kTypeIdString) total = src.Cast<string>().size();
+    else if (type_id == kTypeIdStringView) total = src.Cast<StringSlice>().size();
+    else return Message("Invalid slice source - " + type_id, kStateError);
+
+    if (start < 0 || size < 0 || size_t(start) > total || size_t(size) > total - size_t(start)) {
+      return Message("Invalid index/size", kStateError);
+    }
+
+    Object result;
+
+    if (type_id == kTypeIdArray) {
+      result = Object(make_shared<ArraySlice>(
+        Object(src.Get(), kTypeIdArray), size_t(start), size_t(size)), kTypeIdArraySlice);
+    }
+    else if (type_id == kTypeIdArraySlice) {
+      auto &slice = src.Cast<ArraySlice>();
+      result = Object(make_shared<ArraySlice>(
+        slice.GetSource(), slice.GetStart() + size_t(start), size_t(size)), kTypeIdArraySlice);
+    }
+    else if (type_id == kTypeIdString) {
+      result = Object(make_shared<StringSlice>(
+        Object(src.Get(), kTypeIdString), size_t(start), size_t(size)), kTypeIdStringView);
+    }
+    else {
+      result = Object(make_shared<StringSlice>(
+        src.Cast<StringSlice>().Slice(size_t(start), size_t(size))), kTypeIdStringView);
+    }
+
+    return Message().SetObject(result);
+  }
+
+  Message ArraySliceGetElement(ObjectMap &p) {
+    auto tc = TypeChecking(
+      { Expect("index", kTypeIdInt) }, p
+    );
+
+    if (TC_FAIL(tc)) return TC_ERROR(tc);
+
+    auto &slice = p.Cast<ArraySlice>(kStrMe);
+    auto &idx = p.Cast<int64_t>("index");
+
+    if (size_t(idx) >= slice.size()) return Message("Subscript is out of range", kStateError);
+
+    return Message().SetObjectRef(slice[idx]);
+  }
+
+  Message ArraySliceGetSize(ObjectMap &p) {
+    auto &slice = p.Cast<ArraySlice>(kStrMe);
+    return Message().SetObject(static_cast<int64_t>(slice.size()));
+  }
+
+  Message ArraySliceEmpty(ObjectMap &p) {
+    return Message().SetObject(p.Cast<ArraySlice>(kStrMe).empty());
+  }
+
+  Message ArraySliceHead(ObjectMap &p) {
+    auto &slice = p.Cast<ArraySlice>(kStrMe);
+    shared_ptr<UnifiedIterator> it =
+      make_shared<UnifiedIterator>(slice.begin(), kContainerObjectArray);
+    return Message().SetObject(Object(it, kTypeIdIterator));
+  }
+
+  Message ArraySliceTail(ObjectMap &p) {
+    auto &slice = p.Cast<ArraySlice>(kStrMe);
+    shared_ptr<UnifiedIterator> it =
+      make_shared<UnifiedIterator>(slice.end(), kContainerObjectArray);
+    return Message().SetObject(Object(it, kTypeIdIterator));
+  }
+
+  //Materialize elements into a new array
+  Message ArraySliceToArray(ObjectMap &p) {
+    auto &slice = p.Cast<ArraySlice>(kStrMe);
+    ManagedArray base = make_shared<ObjectArray>();
+
+    for (auto &unit : slice) {
+      base->emplace_back(management::type::CreateObjectCopy(unit));
+    }
+
+    return Message().SetObject(Object(base, kTypeIdArray));
+  }
+
+  //Elements must be string or string_view
+  template <typename ContainerType>
+  Message SequenceJoin(ObjectMap &p) {
+    auto &base = p.Cast<ContainerType>(kStrMe);
+    string_view separator, unit;
+
+    if (!FetchStringView(p["separator"], separator)) {
+      return Message("Invalid separator", kStateError);
+    }
+
+    size_t total = base.empty() ? 0 : separator.size() * (base.size() - 1);
+
+    for (auto &elem : base) {
+      if (!FetchStringView(elem, unit)) {
+        return Message("Invalid element type for join - " + elem.GetTypeId(), kStateError);
+      }
+
+      total += unit.size();
+    }
+
+    auto dest = make_shared<string>();
+    dest->reserve(total);
+
+    for (auto it = base.begin(); it != base.end(); ++it) {
+      if (it != base.begin()) dest->append(separator);
+      FetchStringView(*it, unit);
+      dest->append(unit);
+    }
+
+    return Message().SetObject(Object(dest, kTypeIdString));
+  }
+
   Message ArrayClear(ObjectMap &p) {
     auto &base = p.Cast<ObjectArray>(kStrMe);
     base.clear();
@@ -138,6 +279,11 @@ namespace kagami {
     return result;
   }
 
+  size_t ArraySizer(shared_ptr<void> ptr) {
+    auto &base = *static_pointer_cast<ObjectArray>(ptr);
+    return sizeof(ObjectArray) + base.size() * sizeof(Object);
+  }
+
   shared_ptr<void> ArrayDelivery(shared_ptr<void> ptr) {
     using namespace management::type;
     auto &src_base = *static_pointer_cast<ObjectArray>(ptr);
@@ -150,167 +296,2046 @@ namespace kagami {
     return dest_base;
   }
 
-  Message NewPair(ObjectMap &p) {
-    auto &left = p["left"];
-    auto &right = p["right"];
-    ManagedPair pair = make_shared<ObjectPair>(
-      management::type::CreateObjectCopy(left),
-      management::type::CreateObjectCopy(right));
-    return Message().SetObject(Object(pair, kTypeIdPair));
-  }
+  template <typename T>
+  Message NewPackedArray(ObjectMap &p) {
+    auto tc = TypeChecking(
+      { Expect("size", kTypeIdInt) }, p,
+      { "size" }
+    );
 
-  Message PairLeft(ObjectMap &p) {
-    auto &base = p.Cast<ObjectPair>(kStrMe);
-    return Message().SetObject(Object().PackObject(base.first));
-  }
+    if (TC_FAIL(tc)) return TC_ERROR(tc);
 
-  Message PairRight(ObjectMap &p) {
-    auto &base = p.Cast<ObjectPair>(kStrMe);
-    return Message().SetObject(Object().PackObject(base.second));
-  }
+    auto base = make_shared<vector<T>>();
 
-  shared_ptr<void> PairDelivery(shared_ptr<void> ptr) {
-    auto &src_base = *static_pointer_cast<ObjectPair>(ptr);
-    ManagedPair dest_base = make_shared<ObjectPair>(
-      management::type::CreateObjectCopy(src_base.first),
-      management::type::CreateObjectCopy(src_base.second)
-      );
-    return dest_base;
-  }
+    if (!p["size"].Null()) {
+      int64_t size = p.Cast<int64_t>("size");
+      if (size < 0) return Message("Invalid array size.", kStateError);
 
-  Message NewTable(ObjectMap &p) {
-    ManagedTable table = make_shared<ObjectTable>();
-    return Message().SetObject(Object(table, kTypeIdTable));
+      T init_value = T();
+      auto &init_obj = p["init_value"];
+
+      if (!init_obj.Null() && !FetchElement(init_obj, init_value)) {
+        return Message("Invalid initial value for " +
+          PackedArrayTrait<T>::TypeId(), kStateError);
+      }
+
+      base->assign(static_cast<size_t>(size), init_value);
+    }
+
+    return Message().SetObject(Object(base, PackedArrayTrait<T>::TypeId()));
   }
 
-  Message TableInsert(ObjectMap &p) {
-    using namespace management::type;
-    auto &table = p.Cast<ObjectTable>(kStrMe);
-    auto &key = p["key"];
-    auto &value = p["value"];
-    auto result = table.insert(
-      make_pair(CreateObjectCopy(key), CreateObjectCopy(value))
+  //for-each over range() is lowered into counting loop by frontend,
+  //so this is only reached by other expressions
+  Message NewRange(ObjectMap &p) {
+    auto tc = TypeChecking(
+      {
+        Expect("start", kTypeIdInt),
+        Expect("stop", kTypeIdInt),
+        Expect("step", kTypeIdInt)
+      }, p,
+      { "step" }
     );
-    return Message();
+
+    if (TC_FAIL(tc)) return TC_ERROR(tc);
+
+    auto start = p.Cast<int64_t>("start");
+    auto stop = p.Cast<int64_t>("stop");
+    auto step = p["step"].Null() ? int64_t(1) : p.Cast<int64_t>("step");
+
+    if (step == 0) return Message("Step of range() can't be zero", kStateError);
+
+    auto base = make_shared<IntArray>();
+
+    if (step > 0 ? start < stop : start > stop) {
+      //Unsigned arithmetic avoids overflow on wide ranges
+      uint64_t distance = step > 0 ?
+        uint64_t(stop) - uint64_t(start) : uint64_t(start) - uint64_t(stop);
+      uint64_t stride = step > 0 ? uint64_t(step) : uint64_t(0) - uint64_t(step);
+      uint64_t count = (distance - 1) / stride + 1;
+
+      base->resize(static_cast<size_t>(count));
+
+      for (uint64_t idx = 0; idx < count; ++idx) {
+        (*base)[idx] = static_cast<int64_t>(uint64_t(start) + idx * uint64_t(step));
+      }
+    }
+
+    return Message().SetObject(Object(base, kTypeIdIntArray));
   }
 
-  Message TableGetElement(ObjectMap &p) {
-    // Ref: https://stackoverflow.com/questions/53149145/
-    // Seems nothing to worry about pointers to element
+  template <typename T>
+  Message PackedArrayGetElement(ObjectMap &p) {
+    auto tc = TypeChecking(
+      { Expect("index", kTypeIdInt) }, p
+    );
 
-    auto &table = p.Cast<ObjectTable>(kStrMe);
-    auto &dest_key = p["key"];
-    auto &result = table[dest_key];
-    return Message().SetObjectRef(result);
+    if (TC_FAIL(tc)) return TC_ERROR(tc);
+
+    auto &base = p.Cast<vector<T>>(kStrMe);
+    auto &idx = p.Cast<int64_t>("index");
+
+    if (size_t(idx) >= base.size()) return Message("Subscript is out of range", kStateError);
+
+    return Message().SetObject(PackElement(base[idx]));
   }
 
-  Message TableFindElement(ObjectMap &p) {
-    auto &table = p.Cast<ObjectTable>(kStrMe);
-    auto &key = p["key"];
-    auto it = table.find(key);
-    if (it != table.end()) {
-      return Message().SetObjectRef(it->second);
-      //return Message().SetObject(Object().PackObject(it->second));
+  //Elements are stored as plain values, so assignment goes through set()
+  template <typename T>
+  Message PackedArraySetElement(ObjectMap &p) {
+    auto tc = TypeChecking(
+      { Expect("index", kTypeIdInt) }, p
+    );
+
+    if (TC_FAIL(tc)) return TC_ERROR(tc);
+
+    auto &base = p.Cast<vector<T>>(kStrMe);
+    auto &idx = p.Cast<int64_t>("index");
+
+    if (size_t(idx) >= base.size()) return Message("Subscript is out of range", kStateError);
+
+    if (!FetchElement(p["value"], base[idx])) {
+      return Message("Invalid element type for " +
+        PackedArrayTrait<T>::TypeId(), kStateError);
     }
-    return Message().SetObject(Object());
-  }
 
-  Message TableEraseElement(ObjectMap &p) {
-    auto &table = p.Cast<ObjectTable>(kStrMe);
-    auto &key = p["key"];
-    auto count = table.erase(key);
-    return Message().SetObject(static_cast<int64_t>(count));
+    return Message();
   }
 
-  Message TableEmpty(ObjectMap &p) {
-    auto &table = p.Cast<ObjectTable>(kStrMe);
-    return Message().SetObject(table.empty());
+  template <typename T>
+  Message PackedArrayGetSize(ObjectMap &p) {
+    auto &base = p.Cast<vector<T>>(kStrMe);
+    return Message().SetObject(static_cast<int64_t>(base.size()));
   }
 
-  Message TableSize(ObjectMap &p) {
-    auto &table = p.Cast<ObjectTable>(kStrMe);
-    return Message().SetObject(static_cast<int64_t>(table.size()));
+  template <typename T>
+  Message PackedArrayEmpty(ObjectMap &p) {
+    return Message().SetObject(p.Cast<vector<T>>(kStrMe).empty());
   }
 
-  Message TableClear(ObjectMap &p) {
-    auto &table = p.Cast<ObjectTable>(kStrMe);
-    table.clear();
+  template <typename T>
+  Message PackedArrayPush(ObjectMap &p) {
+    auto &base = p.Cast<vector<T>>(kStrMe);
+    T value;
+
+    if (!FetchElement(p["object"], value)) {
+      return Message("Invalid element type for " +
+        PackedArrayTrait<T>::TypeId(), kStateError);
+    }
+
+    base.push_back(value);
     return Message();
   }
 
-  Message TableHead(ObjectMap &p) {
-    auto &table = p.Cast<ObjectTable>(kStrMe);
+  template <typename T>
+  Message PackedArrayPop(ObjectMap &p) {
+    auto &base = p.Cast<vector<T>>(kStrMe);
+    if (!base.empty()) base.pop_back();
+
+    return Message().SetObject(base.empty());
+  }
+
+  template <typename T>
+  Message PackedArrayHead(ObjectMap &p) {
+    auto &base = p.Cast<vector<T>>(kStrMe);
     shared_ptr<UnifiedIterator> it =
-      make_shared<UnifiedIterator>(table.begin(), kContainerObjectTable);
+      make_shared<UnifiedIterator>(base.begin(), PackedArrayTrait<T>::code);
     return Message().SetObject(Object(it, kTypeIdIterator));
   }
 
-  Message TableTail(ObjectMap &p) {
-    auto &table = p.Cast<ObjectTable>(kStrMe);
+  template <typename T>
+  Message PackedArrayTail(ObjectMap &p) {
+    auto &base = p.Cast<vector<T>>(kStrMe);
     shared_ptr<UnifiedIterator> it =
-      make_shared<UnifiedIterator>(table.end(), kContainerObjectTable);
+      make_shared<UnifiedIterator>(base.end(), PackedArrayTrait<T>::code);
     return Message().SetObject(Object(it, kTypeIdIterator));
   }
 
-  shared_ptr<void> TableDelivery(shared_ptr<void> ptr) {
-    using namespace management::type;
-    auto &table = *static_pointer_cast<ObjectTable>(ptr);
-    ManagedTable dest = make_shared<ObjectTable>();
-    Object key_copy;
+  template <typename T>
+  Message PackedArrayClear(ObjectMap &p) {
+    auto &base = p.Cast<vector<T>>(kStrMe);
+    base.clear();
+    base.shrink_to_fit();
+    return Message();
+  }
 
-    for (auto &unit : table) {
-      key_copy = unit.first;
-      dest->insert(make_pair(CreateObjectCopy(key_copy), 
-          CreateObjectCopy(unit.second)));
+  template <typename T>
+  size_t PackedArrayHasher(shared_ptr<void> ptr) {
+    auto &base = *static_pointer_cast<vector<T>>(ptr);
+    auto hasher = std::hash<T>();
+    size_t result = 0;
+
+    for (auto &unit : base) {
+      result ^= hasher(unit);
+      result = result << 1;
     }
 
-    return dest;
+    return result;
   }
 
-  void InitContainerComponents() {
-    using management::type::ObjectTraitsSetup;
+  /* Bulk kernels for int_array and float_array */
+  template <typename T>
+  Message NumericArraySum(ObjectMap &p) {
+    auto &base = p.Cast<vector<T>>(kStrMe);
+    return Message().SetObject(kernel::Sum(base.data(), base.size()));
+  }
 
-    //TODO:insert()
-    ObjectTraitsSetup(kTypeIdArray, ArrayDelivery, ArrayHasher)
-      .InitConstructor(
-        FunctionImpl(NewArray, "size|init_value", "array", kParamAutoFill).SetLimit(0)
-      )
-      .InitMethods(
-        {
-          FunctionImpl(ArrayGetElement, "index", kStrAt),
-          FunctionImpl(ArrayGetSize, "", "size"),
-          FunctionImpl(ArrayPush, "object", "push"),
-          FunctionImpl(ArrayPop, "", "pop"),
-          FunctionImpl(ArrayEmpty, "", "empty"),
-          FunctionImpl(ArrayHead, "", "head"),
-          FunctionImpl(ArrayTail, "", "tail"),
-          FunctionImpl(ArrayClear, "", "clear")
-        }
-    );
+  template <typename T, bool is_min>
+  Message NumericArrayMinMax(ObjectMap &p) {
+    auto &base = p.Cast<vector<T>>(kStrMe);
+    if (base.empty()) return Message("Array is empty", kStateError);
+    T result = is_min ?
+      kernel::Min(base.data(), base.size()) :
+      kernel::Max(base.data(), base.size());
+    return Message().SetObject(result);
+  }
 
-    ObjectTraitsSetup(kTypeIdIterator, PlainDeliveryImpl<UnifiedIterator>)
-      .InitComparator(IteratorComparator)
-      .InitMethods(
-        {
-          FunctionImpl(IteratorGet, "", "obj"),
-          FunctionImpl(IteratorStepForward, "", "step_forward"),
-          FunctionImpl(IteratorStepBack, "", "step_back"),
-          FunctionImpl(IteratorOperatorCompare, kStrRightHandSide, kStrCompare)
-        }
+  template <typename T>
+  Message NumericArrayDot(ObjectMap &p) {
+    auto tc = TypeChecking(
+      { Expect("other", PackedArrayTrait<T>::TypeId()) }, p
     );
 
-    ObjectTraitsSetup(kTypeIdPair, PairDelivery)
-      .InitConstructor(
-        FunctionImpl(NewPair, "left|right", "pair")
-      )
-      .InitMethods(
-        {
-          FunctionImpl(PairLeft, "", "left"),
-          FunctionImpl(PairRight, "", "right")
+    if (TC_FAIL(tc)) return TC_ERROR(tc);
+
+    auto &lhs = p.Cast<vector<T>>(kStrMe);
+    auto &rhs = p.Cast<vector<T>>("other");
+
+    if (lhs.size() != rhs.size()) return Message("Array size mismatch", kStateError);
+
+    return Message().SetObject(kernel::Dot(lhs.data(), rhs.data(), lhs.size()));
+  }
+
+  //Integer division traps on zero divisor and INT64_MIN / -1
+  inline bool IsDivisionOverflow(int64_t lhs, int64_t rhs) {
+    return rhs == -1 && lhs == INT64_MIN;
+  }
+
+  //Elementwise operation with another array or a scalar, returns new array
+  template <typename T, kernel::ArithmeticOp op>
+  Message NumericArrayArithmetic(ObjectMap &p) {
+    auto &lhs = p.Cast<vector<T>>(kStrMe);
+    auto &value_obj = p["value"];
+    auto dest = make_shared<vector<T>>(lhs.size());
+
+    if (value_obj.GetTypeId() == PackedArrayTrait<T>::TypeId()) {
+      auto &rhs = value_obj.Cast<vector<T>>();
+
+      if (lhs.size() != rhs.size()) return Message("Array size mismatch", kStateError);
+
+      if constexpr (std::is_integral_v<T> && op == kernel::kArithmeticDiv) {
+        for (size_t idx = 0; idx < rhs.size(); ++idx) {
+          if (rhs[idx] == 0) return Message("Divided by zero", kStateError);
+          if (IsDivisionOverflow(lhs[idx], rhs[idx])) {
+            return Message("Integer overflow in division", kStateError);
+          }
         }
-    );
+      }
+
+      kernel::Arithmetic(op, lhs.data(), rhs.data(), dest->data(), lhs.size());
+    }
+    else {
+      T rhs;
+
+      if (!FetchElement(value_obj, rhs)) {
+        return Message("Invalid operand for " +
+          PackedArrayTrait<T>::TypeId(), kStateError);
+      }
+
+      if constexpr (std::is_integral_v<T> && op == kernel::kArithmeticDiv) {
+        if (rhs == 0) return Message("Divided by zero", kStateError);
+
+        if (rhs == -1) {
+          for (auto &unit : lhs) {
+            if (IsDivisionOverflow(unit, rhs)) {
+              return Message("Integer overflow in division", kStateError);
+            }
+          }
+        }
+      }
+
+      kernel::Arithmetic(op, lhs.data(), rhs, dest->data(), lhs.size());
+    }
+
+    return Message().SetObject(Object(dest, PackedArrayTrait<T>::TypeId()));
+  }
+
+  template <typename T>
+  Message NumericArrayFill(ObjectMap &p) {
+    auto &base = p.Cast<vector<T>>(kStrMe);
+    T value;
+
+    if (!FetchElement(p["value"], value)) {
+      return Message("Invalid element type for " +
+        PackedArrayTrait<T>::TypeId(), kStateError);
+    }
+
+    std::fill(base.begin(), base.end(), value);
+    return Message();
+  }
+
+  template <typename T>
+  Message NumericArrayIota(ObjectMap &p) {
+    auto &base = p.Cast<vector<T>>(kStrMe);
+    T start, step = 1;
+
+    if (!FetchElement(p["start"], start) ||
+      (!p["step"].Null() && !FetchElement(p["step"], step))) {
+      return Message("Invalid element type for " +
+        PackedArrayTrait<T>::TypeId(), kStateError);
+    }
+
+    kernel::Iota(start, step, base.data(), base.size());
+    return Message();
+  }
+
+  template <typename T>
+  Message NumericArrayCountIf(ObjectMap &p) {
+    const unordered_map<string, kernel::CompareOp> kCompareOpMatcher = {
+      make_pair(kStrEquals, kernel::kCompareEqual),
+      make_pair(kStrNotEqual, kernel::kCompareNotEqual),
+      make_pair(kStrLess, kernel::kCompareLess),
+      make_pair(kStrLessOrEqual, kernel::kCompareLessOrEqual),
+      make_pair(kStrGreater, kernel::kCompareGreater),
+      make_pair(kStrGreaterOrEqual, kernel::kCompareGreaterOrEqual)
+    };
+
+    auto tc = TypeChecking(
+      { Expect("op", kTypeIdString) }, p
+    );
+
+    if (TC_FAIL(tc)) return TC_ERROR(tc);
+
+    auto &base = p.Cast<vector<T>>(kStrMe);
+    auto it = kCompareOpMatcher.find(p.Cast<string>("op"));
+    T value;
+
+    if (it == kCompareOpMatcher.end()) {
+      return Message("Unknown comparison operator", kStateError);
+    }
+
+    if (!FetchElement(p["value"], value)) {
+      return Message("Invalid element type for " +
+        PackedArrayTrait<T>::TypeId(), kStateError);
+    }
+
+    auto count = kernel::CountIf(it->second, base.data(), value, base.size());
+    return Message().SetObject(static_cast<int64_t>(count));
+  }
+
+  template <typename T>
+  Message NumericArrayPrefixSum(ObjectMap &p) {
+    auto &base = p.Cast<vector<T>>(kStrMe);
+    auto dest = make_shared<vector<T>>(base.size());
+    kernel::PrefixSum(base.data(), dest->data(), base.size());
+    return Message().SetObject(Object(dest, PackedArrayTrait<T>::TypeId()));
+  }
+
+  template <typename T>
+  size_t PackedArraySizer(shared_ptr<void> ptr) {
+    auto &base = *static_pointer_cast<vector<T>>(ptr);
+    return sizeof(vector<T>) + base.capacity() * sizeof(T);
+  }
+
+  /* Intrinsics of base containers, see Machine::BuiltinContainerAction */
+  template <typename ContainerType>
+  void ContainerSizeIntrinsic(Object &me, ObjectView *, RuntimeFrame &frame) {
+    auto &base = me.Cast<ContainerType>();
+    frame.RefreshReturnStack(Object(static_cast<int64_t>(base.size()), kTypeIdInt));
+  }
+
+  template <typename ContainerType>
+  void ContainerEmptyIntrinsic(Object &me, ObjectView *, RuntimeFrame &frame) {
+    frame.RefreshReturnStack(me.Cast<ContainerType>().empty());
+  }
+
+  template <typename ContainerType, BaseContainerCode code, bool tail>
+  void ContainerIteratorIntrinsic(Object &me, ObjectView *, RuntimeFrame &frame) {
+    auto &base = me.Cast<ContainerType>();
+    shared_ptr<UnifiedIterator> it =
+      make_shared<UnifiedIterator>(tail ? base.end() : base.begin(), code);
+    frame.RefreshReturnStack(Object(it, kTypeIdIterator));
+  }
+
+  template <typename ContainerType>
+  void SequencePopIntrinsic(Object &me, ObjectView *, RuntimeFrame &frame) {
+    auto &base = me.Cast<ContainerType>();
+    if (!base.empty()) base.pop_back();
+    frame.RefreshReturnStack(base.empty());
+  }
+
+  template <typename ContainerType>
+  void SequenceClearIntrinsic(Object &me, ObjectView *, RuntimeFrame &frame) {
+    auto &base = me.Cast<ContainerType>();
+    base.clear();
+    base.shrink_to_fit();
+    frame.RefreshReturnStack(Object());
+  }
+
+  void ArrayAtIntrinsic(Object &me, ObjectView *args, RuntimeFrame &frame) {
+    auto &base = me.Cast<ObjectArray>();
+    auto &index_obj = args[0].Seek();
+
+    if (index_obj.GetTypeId() != kTypeIdInt) {
+      frame.MakeError("Invalid array index type");
+      return;
+    }
+
+    auto index = index_obj.Cast<int64_t>();
+    if (size_t(index) >= base.size()) {
+      frame.MakeError("Index is out of range");
+      return;
+    }
+
+    frame.RefreshReturnStack(ObjectView(&base[index]));
+  }
+
+  void ArraySliceAtIntrinsic(Object &me, ObjectView *args, RuntimeFrame &frame) {
+    auto &slice = me.Cast<ArraySlice>();
+    auto &index_obj = args[0].Seek();
+
+    if (index_obj.GetTypeId() != kTypeIdInt) {
+      frame.MakeError("Invalid array index type");
+      return;
+    }
+
+    auto index = index_obj.Cast<int64_t>();
+    if (size_t(index) >= slice.size()) {
+      frame.MakeError("Index is out of range");
+      return;
+    }
+
+    frame.RefreshReturnStack(ObjectView(&slice[index]));
+  }
+
+  void ArrayPushIntrinsic(Object &me, ObjectView *args, RuntimeFrame &frame) {
+    auto &base = me.Cast<ObjectArray>();
+    base.emplace_back(management::type::CreateObjectCopy(args[0].Seek()));
+    frame.RefreshReturnStack(Object());
+  }
+
+  //Packed arrays hold plain values, so elements are returned by value
+  template <typename T>
+  void PackedArrayAtIntrinsic(Object &me, ObjectView *args, RuntimeFrame &frame) {
+    auto &base = me.Cast<vector<T>>();
+    auto &index_obj = args[0].Seek();
+
+    if (index_obj.GetTypeId() != kTypeIdInt) {
+      frame.MakeError("Invalid array index type");
+      return;
+    }
+
+    auto index = index_obj.Cast<int64_t>();
+    if (size_t(index) >= base.size()) {
+      frame.MakeError("Index is out of range");
+      return;
+    }
+
+    frame.RefreshReturnStack(PackElement(base[index]));
+  }
+
+  template <typename T>
+  void PackedArrayPushIntrinsic(Object &me, ObjectView *args, RuntimeFrame &frame) {
+    auto &base = me.Cast<vector<T>>();
+    T value;
+
+    if (!FetchElement(args[0].Seek(), value)) {
+      frame.MakeError("Invalid element type for " + PackedArrayTrait<T>::TypeId());
+      return;
+    }
+
+    base.push_back(value);
+    frame.RefreshReturnStack(Object());
+  }
+
+  void TableAtIntrinsic(Object &me, ObjectView *args, RuntimeFrame &frame) {
+    auto &table = me.Cast<ObjectTable>();
+    frame.RefreshReturnStack(ObjectView(&table[args[0].Seek()]));
+  }
+
+  void TableInsertIntrinsic(Object &me, ObjectView *args, RuntimeFrame &frame) {
+    using management::type::CreateObjectCopy;
+    auto &table = me.Cast<ObjectTable>();
+    table.insert(make_pair(
+      CreateObjectCopy(args[0].Seek()), CreateObjectCopy(args[1].Seek())));
+    frame.RefreshReturnStack(Object());
+  }
+
+  void TableFindIntrinsic(Object &me, ObjectView *args, RuntimeFrame &frame) {
+    auto &table = me.Cast<ObjectTable>();
+    auto it = table.find(args[0].Seek());
+    if (it != table.end()) frame.RefreshReturnStack(ObjectView(&it->second));
+    else frame.RefreshReturnStack(Object());
+  }
+
+  void TableEraseIntrinsic(Object &me, ObjectView *args, RuntimeFrame &frame) {
+    auto &table = me.Cast<ObjectTable>();
+    auto count = table.erase(args[0].Seek());
+    frame.RefreshReturnStack(Object(static_cast<int64_t>(count), kTypeIdInt));
+  }
+
+  void TableClearIntrinsic(Object &me, ObjectView *, RuntimeFrame &frame) {
+    me.Cast<ObjectTable>().clear();
+    frame.RefreshReturnStack(Object());
+  }
+
+  template <typename T>
+  void InitPackedArrayType() {
+    using management::type::ObjectTraitsSetup;
+    using Trait = PackedArrayTrait<T>;
+
+    ObjectTraitsSetup setup(Trait::TypeId(), PlainDeliveryImpl<vector<T>>, PackedArrayHasher<T>);
+
+    setup.InitSizer(PackedArraySizer<T>)
+      .InitConstructor(
+        FunctionImpl(NewPackedArray<T>, "size|init_value", Trait::TypeId(), kParamAutoFill)
+          .SetLimit(0)
+      )
+      .InitMethods(
+        {
+          FunctionImpl(PackedArrayGetElement<T>, "index", kStrAt),
+          FunctionImpl(PackedArraySetElement<T>, "index|value", "set"),
+          FunctionImpl(PackedArrayGetSize<T>, "", "size"),
+          FunctionImpl(PackedArrayPush<T>, "object", "push"),
+          FunctionImpl(PackedArrayPop<T>, "", "pop"),
+          FunctionImpl(PackedArrayEmpty<T>, "", "empty"),
+          FunctionImpl(PackedArrayHead<T>, "", "head"),
+          FunctionImpl(PackedArrayTail<T>, "", "tail"),
+          FunctionImpl(PackedArrayClear<T>, "", "clear")
+        }
+    );
+
+    CreateIntrinsics(
+      {
+        IntrinsicImpl{ kStrAt, Trait::TypeId(), 1, PackedArrayAtIntrinsic<T> },
+        IntrinsicImpl{ "size", Trait::TypeId(), 0, ContainerSizeIntrinsic<vector<T>> },
+        IntrinsicImpl{ "push", Trait::TypeId(), 1, PackedArrayPushIntrinsic<T> },
+        IntrinsicImpl{ "pop", Trait::TypeId(), 0, SequencePopIntrinsic<vector<T>> },
+        IntrinsicImpl{ "empty", Trait::TypeId(), 0, ContainerEmptyIntrinsic<vector<T>> },
+        IntrinsicImpl{ "head", Trait::TypeId(), 0,
+          ContainerIteratorIntrinsic<vector<T>, Trait::code, false> },
+        IntrinsicImpl{ "tail", Trait::TypeId(), 0,
+          ContainerIteratorIntrinsic<vector<T>, Trait::code, true> },
+        IntrinsicImpl{ "clear", Trait::TypeId(), 0, SequenceClearIntrinsic<vector<T>> }
+      }
+    );
+
+    if constexpr (!std::is_same_v<T, uint8_t>) {
+      using namespace kernel;
+      setup.AppendMethods(
+        {
+          FunctionImpl(NumericArraySum<T>, "", "sum"),
+          FunctionImpl(NumericArrayMinMax<T, true>, "", "min"),
+          FunctionImpl(NumericArrayMinMax<T, false>, "", "max"),
+          FunctionImpl(NumericArrayDot<T>, "other", "dot"),
+          FunctionImpl(NumericArrayArithmetic<T, kArithmeticAdd>, "value", "add"),
+          FunctionImpl(NumericArrayArithmetic<T, kArithmeticSub>, "value", "sub"),
+          FunctionImpl(NumericArrayArithmetic<T, kArithmeticMul>, "value", "mul"),
+          FunctionImpl(NumericArrayArithmetic<T, kArithmeticDiv>, "value", "div"),
+          FunctionImpl(NumericArrayFill<T>, "value", "fill"),
+          FunctionImpl(NumericArrayIota<T>, "start|step", "iota", kParamAutoFill).SetLimit(1),
+          FunctionImpl(NumericArrayCountIf<T>, "op|value", "count_if"),
+          FunctionImpl(NumericArrayPrefixSum<T>, "", "prefix_sum")
+        }
+      );
+    }
+  }
+
+  /* Compact byte buffer, elements are exposed as int in [0, 255] */
+  inline bool FetchByte(Object &obj, uint8_t &dest) {
+    if (obj.GetTypeId() != kTypeIdInt) return false;
+    auto value = obj.Cast<int64_t>();
+    if (value < 0 || value > 255) return false;
+    dest = static_cast<uint8_t>(value);
+    return true;
+  }
+
+  //Source can be bytes, string or string_view
+  bool AppendBytes(ByteArray &dest, Object &src) {
+    string_view view;
+
+    if (src.GetTypeId() == kTypeIdBytes) {
+      auto &base = src.Cast<ByteArray>();
+      size_t size = base.size();
+      //Appending to itself, range is invalidated by resizing
+      if (&base == &dest) {
+        dest.resize(size * 2);
+        std::copy_n(dest.begin(), size, dest.begin() + size);
+      }
+      else {
+        dest.insert(dest.end(), base.begin(), base.end());
+      }
+    }
+    else if (FetchStringView(src, view)) {
+      dest.insert(dest.end(), view.begin(), view.end());
+    }
+    else {
+      return false;
+    }
+
+    return true;
+  }
+
+  Message NewBytes(ObjectMap &p) {
+    auto &src = p["src"];
+    auto base = make_shared<ByteArray>();
+
+    if (src.GetTypeId() == kTypeIdInt) {
+      auto size = src.Cast<int64_t>();
+      uint8_t value = 0;
+
+      if (size < 0) return Message("Invalid bytes size", kStateError);
+
+      if (!p["init_value"].Null() && !FetchByte(p["init_value"], value)) {
+        return Message("Invalid initial value for bytes", kStateError);
+      }
+
+      base->assign(static_cast<size_t>(size), value);
+    }
+    else if (!src.Null() && !AppendBytes(*base, src)) {
+      return Message("Invalid source for bytes - " + src.GetTypeId(), kStateError);
+    }
+
+    return Message().SetObject(Object(base, kTypeIdBytes));
+  }
+
+  Message BytesGetElement(ObjectMap &p) {
+    auto tc = TypeChecking(
+      { Expect("index", kTypeIdInt) }, p
+    );
+
+    if (TC_FAIL(tc)) return TC_ERROR(tc);
+
+    auto &base = p.Cast<ByteArray>(kStrMe);
+    auto idx = p.Cast<int64_t>("index");
+
+    if (size_t(idx) >= base.size()) return Message("Subscript is out of range", kStateError);
+
+    return Message().SetObject(static_cast<int64_t>(base[idx]));
+  }
+
+  Message BytesSetElement(ObjectMap &p) {
+    auto tc = TypeChecking(
+      { Expect("index", kTypeIdInt) }, p
+    );
+
+    if (TC_FAIL(tc)) return TC_ERROR(tc);
+
+    auto &base = p.Cast<ByteArray>(kStrMe);
+    auto idx = p.Cast<int64_t>("index");
+
+    if (size_t(idx) >= base.size()) return Message("Subscript is out of range", kStateError);
+
+    if (!FetchByte(p["value"], base[idx])) {
+      return Message("Invalid element value for bytes", kStateError);
+    }
+
+    return Message();
+  }
+
+  Message BytesGetSize(ObjectMap &p) {
+    return Message().SetObject(static_cast<int64_t>(p.Cast<ByteArray>(kStrMe).size()));
+  }
+
+  Message BytesEmpty(ObjectMap &p) {
+    return Message().SetObject(p.Cast<ByteArray>(kStrMe).empty());
+  }
+
+  Message BytesPush(ObjectMap &p) {
+    auto &base = p.Cast<ByteArray>(kStrMe);
+    uint8_t value;
+
+    if (!FetchByte(p["value"], value)) {
+      return Message("Invalid element value for bytes", kStateError);
+    }
+
+    base.push_back(value);
+    return Message();
+  }
+
+  Message BytesAppend(ObjectMap &p) {
+    auto &base = p.Cast<ByteArray>(kStrMe);
+    auto &src = p["src"];
+
+    if (!AppendBytes(base, src)) {
+      return Message("Invalid source for bytes - " + src.GetTypeId(), kStateError);
+    }
+
+    return Message();
+  }
+
+  Message BytesPop(ObjectMap &p) {
+    auto &base = p.Cast<ByteArray>(kStrMe);
+    if (!base.empty()) base.pop_back();
+    return Message().SetObject(base.empty());
+  }
+
+  Message BytesClear(ObjectMap &p) {
+    auto &base = p.Cast<ByteArray>(kStrMe);
+    base.clear();
+    base.shrink_to_fit();
+    return Message();
+  }
+
+  //Copy of [start, start + size)
+  Message BytesSlice(ObjectMap &p) {
+    auto tc = TypeChecking(
+      {
+        Expect("start", kTypeIdInt),
+        Expect("size", kTypeIdInt)
+      }, p
+    );
+
+    if (TC_FAIL(tc)) return TC_ERROR(tc);
+
+    auto &base = p.Cast<ByteArray>(kStrMe);
+    auto start = p.Cast<int64_t>("start");
+    auto size = p.Cast<int64_t>("size");
+
+    if (start < 0 || size < 0 || size_t(start) > base.size() ||
+      size_t(size) > base.size() - size_t(start)) {
+      return Message("Invalid index/size", kStateError);
+    }
+
+    auto dest = make_shared<ByteArray>(base.begin() + start, base.begin() + start + size);
+    return Message().SetObject(Object(dest, kTypeIdBytes));
+  }
+
+  Message BytesToString(ObjectMap &p) {
+    auto &base = p.Cast<ByteArray>(kStrMe);
+    auto dest = make_shared<string>(base.begin(), base.end());
+    return Message().SetObject(Object(dest, kTypeIdString));
+  }
+
+  Message BytesCompare(ObjectMap &p) {
+    auto &rhs = p[kStrRightHandSide];
+    bool result = rhs.GetTypeId() == kTypeIdBytes &&
+      p.Cast<ByteArray>(kStrMe) == rhs.Cast<ByteArray>();
+    return Message().SetObject(result);
+  }
+
+  size_t BytesHasher(shared_ptr<void> ptr) {
+    auto &base = *static_pointer_cast<ByteArray>(ptr);
+    return std::hash<string_view>()(
+      string_view(reinterpret_cast<const char *>(base.data()), base.size()));
+  }
+
+  size_t BytesSizer(shared_ptr<void> ptr) {
+    auto &base = *static_pointer_cast<ByteArray>(ptr);
+    return sizeof(ByteArray) + base.capacity();
+  }
+
+  void BytesAtIntrinsic(Object &me, ObjectView *args, RuntimeFrame &frame) {
+    auto &base = me.Cast<ByteArray>();
+    auto &index_obj = args[0].Seek();
+
+    if (index_obj.GetTypeId() != kTypeIdInt) {
+      frame.MakeError("Invalid array index type");
+      return;
+    }
+
+    auto index = index_obj.Cast<int64_t>();
+    if (size_t(index) >= base.size()) {
+      frame.MakeError("Index is out of range");
+      return;
+    }
+
+    frame.RefreshReturnStack(Object(static_cast<int64_t>(base[index]), kTypeIdInt));
+  }
+
+  void BytesSetIntrinsic(Object &me, ObjectView *args, RuntimeFrame &frame) {
+    auto &base = me.Cast<ByteArray>();
+    auto &index_obj = args[0].Seek();
+
+    if (index_obj.GetTypeId() != kTypeIdInt) {
+      frame.MakeError("Invalid array index type");
+      return;
+    }
+
+    auto index = index_obj.Cast<int64_t>();
+    if (size_t(index) >= base.size()) {
+      frame.MakeError("Index is out of range");
+      return;
+    }
+
+    if (!FetchByte(args[1].Seek(), base[index])) {
+      frame.MakeError("Invalid element value for bytes");
+      return;
+    }
+
+    frame.RefreshReturnStack(Object());
+  }
+
+  void BytesPushIntrinsic(Object &me, ObjectView *args, RuntimeFrame &frame) {
+    auto &base = me.Cast<ByteArray>();
+    uint8_t value;
+
+    if (!FetchByte(args[0].Seek(), value)) {
+      frame.MakeError("Invalid element value for bytes");
+      return;
+    }
+
+    base.push_back(value);
+    frame.RefreshReturnStack(Object());
+  }
+
+  void InitBytesType() {
+    using management::type::ObjectTraitsSetup;
+    using management::type::PlainComparator;
+
+    ObjectTraitsSetup(kTypeIdBytes, PlainDeliveryImpl<ByteArray>, BytesHasher)
+      .InitComparator(PlainComparator<ByteArray>)
+      .InitSizer(BytesSizer)
+      .InitConstructor(
+        FunctionImpl(NewBytes, "src|init_value", kTypeIdBytes, kParamAutoFill).SetLimit(0)
+      )
+      .InitMethods(
+        {
+          FunctionImpl(BytesGetElement, "index", kStrAt),
+          FunctionImpl(BytesSetElement, "index|value", "set"),
+          FunctionImpl(BytesGetSize, "", "size"),
+          FunctionImpl(BytesEmpty, "", "empty"),
+          FunctionImpl(BytesPush, "value", "push"),
+          FunctionImpl(BytesAppend, "src", "append"),
+          FunctionImpl(BytesPop, "", "pop"),
+          FunctionImpl(BytesClear, "", "clear"),
+          FunctionImpl(BytesSlice, "start|size", "slice"),
+          FunctionImpl(BytesToString, "", "to_string"),
+          FunctionImpl(BytesCompare, kStrRightHandSide, kStrCompare)
+        }
+    );
+
+    CreateIntrinsics(
+      {
+        IntrinsicImpl{ kStrAt, kTypeIdBytes, 1, BytesAtIntrinsic },
+        IntrinsicImpl{ "set", kTypeIdBytes, 2, BytesSetIntrinsic },
+        IntrinsicImpl{ "size", kTypeIdBytes, 0, ContainerSizeIntrinsic<ByteArray> },
+        IntrinsicImpl{ "empty", kTypeIdBytes, 0, ContainerEmptyIntrinsic<ByteArray> },
+        IntrinsicImpl{ "push", kTypeIdBytes, 1, BytesPushIntrinsic },
+        IntrinsicImpl{ "pop", kTypeIdBytes, 0, SequencePopIntrinsic<ByteArray> }
+      }
+    );
+  }
+
+  Message NewPair(ObjectMap &p) {
+    auto &left = p["left"];
+    auto &right = p["right"];
+    ManagedPair pair = make_shared<ObjectPair>(
+      management::type::CreateObjectCopy(left),
+      management::type::CreateObjectCopy(right));
+    return Message().SetObject(Object(pair, kTypeIdPair));
+  }
+
+  Message PairLeft(ObjectMap &p) {
+    auto &base = p.Cast<ObjectPair>(kStrMe);
+    return Message().SetObject(Object().PackObject(base.first));
+  }
+
+  Message PairRight(ObjectMap &p) {
+    auto &base = p.Cast<ObjectPair>(kStrMe);
+    return Message().SetObject(Object().PackObject(base.second));
+  }
+
+  shared_ptr<void> PairDelivery(shared_ptr<void> ptr) {
+    auto &src_base = *static_pointer_cast<ObjectPair>(ptr);
+    ManagedPair dest_base = make_shared<ObjectPair>(
+      management::type::CreateObjectCopy(src_base.first),
+      management::type::CreateObjectCopy(src_base.second)
+      );
+    return dest_base;
+  }
+
+  Message NewTable(ObjectMap &p) {
+    ManagedTable table = make_shared<ObjectTable>();
+    return Message().SetObject(Object(table, kTypeIdTable));
+  }
+
+  Message TableInsert(ObjectMap &p) {
+    using namespace management::type;
+    auto &table = p.Cast<ObjectTable>(kStrMe);
+    auto &key = p["key"];
+    auto &value = p["value"];
+    auto result = table.insert(
+      make_pair(CreateObjectCopy(key), CreateObjectCopy(value))
+    );
+    return Message();
+  }
+
+  Message TableGetElement(ObjectMap &p) {
+    // Ref: https://stackoverflow.com/questions/53149145/
+    // Seems nothing to worry about pointers to element
+
+    auto &table = p.Cast<ObjectTable>(kStrMe);
+    auto &dest_key = p["key"];
+    auto &result = table[dest_key];
+    return Message().SetObjectRef(result);
+  }
+
+  Message TableFindElement(ObjectMap &p) {
+    auto &table = p.Cast<ObjectTable>(kStrMe);
+    auto &key = p["key"];
+    auto it = table.find(key);
+    if (it != table.end()) {
+      return Message().SetObjectRef(it->second);
+      //return Message().SetObject(Object().PackObject(it->second));
+    }
+    return Message().SetObject(Object());
+  }
+
+  Message TableEraseElement(ObjectMap &p) {
+    auto &table = p.Cast<ObjectTable>(kStrMe);
+    auto &key = p["key"];
+    auto count = table.erase(key);
+    return Message().SetObject(static_cast<int64_t>(count));
+  }
+
+  Message TableEmpty(ObjectMap &p) {
+    auto &table = p.Cast<ObjectTable>(kStrMe);
+    return Message().SetObject(table.empty());
+  }
+
+  Message TableSize(ObjectMap &p) {
+    auto &table = p.Cast<ObjectTable>(kStrMe);
+    return Message().SetObject(static_cast<int64_t>(table.size()));
+  }
+
+  Message TableClear(ObjectMap &p) {
+    auto &table = p.Cast<ObjectTable>(kStrMe);
+    table.clear();
+    return Message();
+  }
+
+  Message TableHead(ObjectMap &p) {
+    auto &table = p.Cast<ObjectTable>(kStrMe);
+    shared_ptr<UnifiedIterator> it =
+      make_shared<UnifiedIterator>(table.begin(), kContainerObjectTable);
+    return Message().SetObject(Object(it, kTypeIdIterator));
+  }
+
+  Message TableTail(ObjectMap &p) {
+    auto &table = p.Cast<ObjectTable>(kStrMe);
+    shared_ptr<UnifiedIterator> it =
+      make_shared<UnifiedIterator>(table.end(), kContainerObjectTable);
+    return Message().SetObject(Object(it, kTypeIdIterator));
+  }
+
+  shared_ptr<void> TableDelivery(shared_ptr<void> ptr) {
+    using namespace management::type;
+    auto &table = *static_pointer_cast<ObjectTable>(ptr);
+    ManagedTable dest = make_shared<ObjectTable>();
+    Object key_copy;
+
+    for (auto &unit : table) {
+      key_copy = unit.first;
+      dest->insert(make_pair(CreateObjectCopy(key_copy), 
+          CreateObjectCopy(unit.second)));
+    }
+
+    return dest;
+  }
+
+  size_t TableSizer(shared_ptr<void> ptr) {
+    auto &table = *static_pointer_cast<ObjectTable>(ptr);
+    return sizeof(ObjectTable) + table.allocated_bytes();
+  }
+
+  Message NewSortedTable(ObjectMap &) {
+    ManagedSortedTable table = make_shared<SortedTable>();
+    return Message().SetObject(Object(table, kTypeIdSortedTable));
+  }
+
+  //Only plain type objects can be ordered
+  inline bool IsSortableKey(Object &key) {
+    return MakeSortKey(key).kind != kSortKeyInvalid;
+  }
+
+  inline bool IsNaNKey(Object &key) {
+    return key.GetTypeId() == kTypeIdFloat && std::isnan(key.Cast<double>());
+  }
+
+  inline Message InvalidKeyError(Object &key, string msg) {
+    return Message(IsNaNKey(key) ? "NaN can't be used as key" : msg, kStateError);
+  }
+
+  Message SortedTableInsert(ObjectMap &p) {
+    using namespace management::type;
+    auto &table = p.Cast<SortedTable>(kStrMe);
+    auto &key = p["key"];
+
+    if (!IsSortableKey(key)) {
+      return InvalidKeyError(key, "Invalid key type for sorted_table - " + key.GetTypeId());
+    }
+
+    auto key_copy = CreateObjectCopy(key);
+    auto value_copy = CreateObjectCopy(p["value"]);
+    auto result = table.insert(key_copy, value_copy);
+    return Message().SetObject(result.second);
+  }
+
+  Message SortedTableGetElement(ObjectMap &p) {
+    using namespace management::type;
+    auto &table = p.Cast<SortedTable>(kStrMe);
+    auto &key = p["key"];
+
+    if (!IsSortableKey(key)) {
+      return InvalidKeyError(key, "Invalid key type for sorted_table - " + key.GetTypeId());
+    }
+
+    auto it = table.find(key);
+
+    if (it == table.end()) {
+      auto key_copy = CreateObjectCopy(key);
+      Object value;
+      return Message().SetObjectRef(table.insert(key_copy, value).first->second);
+    }
+
+    return Message().SetObjectRef(it->second);
+  }
+
+  Message SortedTableFindElement(ObjectMap &p) {
+    auto &table = p.Cast<SortedTable>(kStrMe);
+    auto &key = p["key"];
+    if (!IsSortableKey(key)) return Message().SetObject(Object());
+    auto it = table.find(key);
+    if (it != table.end()) return Message().SetObjectRef(it->second);
+    return Message().SetObject(Object());
+  }
+
+  Message SortedTableEraseElement(ObjectMap &p) {
+    auto &table = p.Cast<SortedTable>(kStrMe);
+    auto &key = p["key"];
+    size_t count = IsSortableKey(key) ? table.erase(key) : 0;
+    return Message().SetObject(static_cast<int64_t>(count));
+  }
+
+  Message SortedTableEmpty(ObjectMap &p) {
+    auto &table = p.Cast<SortedTable>(kStrMe);
+    return Message().SetObject(table.empty());
+  }
+
+  Message SortedTableSize(ObjectMap &p) {
+    auto &table = p.Cast<SortedTable>(kStrMe);
+    return Message().SetObject(static_cast<int64_t>(table.size()));
+  }
+
+  Message SortedTableClear(ObjectMap &p) {
+    auto &table = p.Cast<SortedTable>(kStrMe);
+    table.clear();
+    return Message();
+  }
+
+  Message SortedTableHead(ObjectMap &p) {
+    auto &table = p.Cast<SortedTable>(kStrMe);
+    shared_ptr<UnifiedIterator> it =
+      make_shared<UnifiedIterator>(table.begin(), kContainerSortedTable);
+    return Message().SetObject(Object(it, kTypeIdIterator));
+  }
+
+  Message SortedTableTail(ObjectMap &p) {
+    auto &table = p.Cast<SortedTable>(kStrMe);
+    shared_ptr<UnifiedIterator> it =
+      make_shared<UnifiedIterator>(table.end(), kContainerSortedTable);
+    return Message().SetObject(Object(it, kTypeIdIterator));
+  }
+
+  template <bool upper>
+  Message SortedTableBound(ObjectMap &p) {
+    auto &table = p.Cast<SortedTable>(kStrMe);
+    auto &key = p["key"];
+
+    if (!IsSortableKey(key)) {
+      return InvalidKeyError(key, "Invalid key type for sorted_table - " + key.GetTypeId());
+    }
+
+    auto dest = upper ? table.upper_bound(key) : table.lower_bound(key);
+    shared_ptr<UnifiedIterator> it =
+      make_shared<UnifiedIterator>(dest, kContainerSortedTable);
+    return Message().SetObject(Object(it, kTypeIdIterator));
+  }
+
+  //Range view of [low, high), the view keeps the table alive
+  Message SortedTableRange(ObjectMap &p) {
+    auto &table = p.Cast<SortedTable>(kStrMe);
+    auto &low = p["low"];
+    auto &high = p["high"];
+
+    if (!IsSortableKey(low)) {
+      return InvalidKeyError(low, "Invalid key type for sorted_table range");
+    }
+
+    if (!IsSortableKey(high)) {
+      return InvalidKeyError(high, "Invalid key type for sorted_table range");
+    }
+
+    auto range = make_shared<SortedRange>();
+    range->table = Object(p[kStrMe].Get(), kTypeIdSortedTable);
+    range->begin = table.lower_bound(low);
+    range->end = table.lower_bound(high);
+
+    if (CompareSortKey(MakeSortKey(low), MakeSortKey(high)) >= 0) {
+      range->end = range->begin;
+    }
+
+    return Message().SetObject(Object(range, kTypeIdSortedRange));
+  }
+
+  shared_ptr<void> SortedTableDelivery(shared_ptr<void> ptr) {
+    using namespace management::type;
+    auto &table = *static_pointer_cast<SortedTable>(ptr);
+    ManagedSortedTable dest = make_shared<SortedTable>();
+
+    for (auto &unit : table) {
+      auto key_copy = CreateObjectCopy(unit.first);
+      auto value_copy = CreateObjectCopy(unit.second);
+      dest->insert(key_copy, value_copy);
+    }
+
+    return dest;
+  }
+
+  //Leaf entry with separated pair and cached sort key
+  size_t SortedTableSizer(shared_ptr<void> ptr) {
+    auto &table = *static_pointer_cast<SortedTable>(ptr);
+    size_t entry_size = sizeof(ObjectPair) + sizeof(SortKey) + 2 * sizeof(void *);
+    return sizeof(SortedTable) + table.size() * entry_size;
+  }
+
+  inline bool IsValidRange(SortedRange &range) {
+    return range.begin.IsValid() && range.end.IsValid();
+  }
+
+  Message SortedRangeEmpty(ObjectMap &p) {
+    auto &range = p.Cast<SortedRange>(kStrMe);
+    if (!IsValidRange(range)) return Message(kStrInvalidIterator, kStateError);
+    return Message().SetObject(range.begin == range.end);
+  }
+
+  Message SortedRangeSize(ObjectMap &p) {
+    auto &range = p.Cast<SortedRange>(kStrMe);
+    if (!IsValidRange(range)) return Message(kStrInvalidIterator, kStateError);
+    int64_t count = 0;
+    for (auto it = range.begin; it != range.end; ++it) count += 1;
+    return Message().SetObject(count);
+  }
+
+  Message SortedRangeHead(ObjectMap &p) {
+    auto &range = p.Cast<SortedRange>(kStrMe);
+    if (!IsValidRange(range)) return Message(kStrInvalidIterator, kStateError);
+    shared_ptr<UnifiedIterator> it =
+      make_shared<UnifiedIterator>(range.begin, kContainerSortedTable);
+    return Message().SetObject(Object(it, kTypeIdIterator));
+  }
+
+  Message SortedRangeTail(ObjectMap &p) {
+    auto &range = p.Cast<SortedRange>(kStrMe);
+    if (!IsValidRange(range)) return Message(kStrInvalidIterator, kStateError);
+    shared_ptr<UnifiedIterator> it =
+      make_shared<UnifiedIterator>(range.end, kContainerSortedTable);
+    return Message().SetObject(Object(it, kTypeIdIterator));
+  }
+
+  /*
+    table_view, returned by items() and values() of table/sorted_table.
+    for-each loop binds stored values as references, so they can be
+    modified in place without looking up the table again.
+  */
+  template <TableViewKind kind>
+  Message TableGetView(ObjectMap &p) {
+    auto &table = p[kStrMe];
+    auto view = make_shared<TableView>();
+    view->table = Object(table.Get(), table.GetTypeId());
+    view->kind = kind;
+    return Message().SetObject(Object(view, kTypeIdTableView));
+  }
+
+  inline size_t GetTableViewSize(TableView &view) {
+    return view.table.GetTypeId() == kTypeIdTable ?
+      view.table.Cast<ObjectTable>().size() :
+      view.table.Cast<SortedTable>().size();
+  }
+
+  Message TableViewSize(ObjectMap &p) {
+    auto &view = p.Cast<TableView>(kStrMe);
+    return Message().SetObject(static_cast<int64_t>(GetTableViewSize(view)));
+  }
+
+  Message TableViewEmpty(ObjectMap &p) {
+    auto &view = p.Cast<TableView>(kStrMe);
+    return Message().SetObject(GetTableViewSize(view) == 0);
+  }
+
+  /* set */
+  inline bool FetchSetElement(Object &obj, Message &msg) {
+    if (!management::type::IsHashable(obj)) {
+      msg = Message("Unhashable element for set - " + obj.GetTypeId(), kStateError);
+      return false;
+    }
+    return true;
+  }
+
+  Message NewSet(ObjectMap &p) {
+    using management::type::CreateObjectCopy;
+    auto &src = p["src"];
+    auto &type_id = src.GetTypeId();
+    ManagedSet base = make_shared<ObjectSet>();
+    Message msg;
+
+    if (type_id == kTypeIdArray || type_id == kTypeIdDeque) {
+      auto &src_base = src.Cast<ObjectArray>();
+      base->reserve(src_base.size());
+
+      for (auto &unit : src_base) {
+        if (!FetchSetElement(unit, msg)) return msg;
+        base->insert(CreateObjectCopy(unit));
+      }
+    }
+    else if (type_id == kTypeIdSet) {
+      for (auto &unit : src.Cast<ObjectSet>()) {
+        base->insert(CreateObjectCopy(unit));
+      }
+    }
+    else if (!src.Null()) {
+      return Message("Invalid source for set - " + type_id, kStateError);
+    }
+
+    return Message().SetObject(Object(base, kTypeIdSet));
+  }
+
+  Message SetInsert(ObjectMap &p) {
+    auto &base = p.Cast<ObjectSet>(kStrMe);
+    auto &value = p["value"];
+    Message msg;
+
+    if (!FetchSetElement(value, msg)) return msg;
+
+    return Message().SetObject(base.insert(management::type::CreateObjectCopy(value)));
+  }
+
+  Message SetContains(ObjectMap &p) {
+    auto &base = p.Cast<ObjectSet>(kStrMe);
+    return Message().SetObject(base.contains(p["value"]));
+  }
+
+  Message SetErase(ObjectMap &p) {
+    auto &base = p.Cast<ObjectSet>(kStrMe);
+    return Message().SetObject(static_cast<int64_t>(base.erase(p["value"])));
+  }
+
+  Message SetSize(ObjectMap &p) {
+    return Message().SetObject(static_cast<int64_t>(p.Cast<ObjectSet>(kStrMe).size()));
+  }
+
+  Message SetEmpty(ObjectMap &p) {
+    return Message().SetObject(p.Cast<ObjectSet>(kStrMe).empty());
+  }
+
+  Message SetClear(ObjectMap &p) {
+    p.Cast<ObjectSet>(kStrMe).clear();
+    return Message();
+  }
+
+  template <bool tail>
+  Message SetIterator(ObjectMap &p) {
+    auto &base = p.Cast<ObjectSet>(kStrMe);
+    shared_ptr<UnifiedIterator> it =
+      make_shared<UnifiedIterator>(tail ? base.end() : base.begin(), kContainerObjectSet);
+    return Message().SetObject(Object(it, kTypeIdIterator));
+  }
+
+  Message SetToArray(ObjectMap &p) {
+    auto &base = p.Cast<ObjectSet>(kStrMe);
+    ManagedArray dest = make_shared<ObjectArray>();
+
+    for (auto &unit : base) {
+      dest->emplace_back(management::type::CreateObjectCopy(unit));
+    }
+
+    return Message().SetObject(Object(dest, kTypeIdArray));
+  }
+
+  shared_ptr<void> SetDelivery(shared_ptr<void> ptr) {
+    using management::type::CreateObjectCopy;
+    auto &base = *static_pointer_cast<ObjectSet>(ptr);
+    ManagedSet dest = make_shared<ObjectSet>();
+    dest->reserve(base.size());
+
+    for (auto &unit : base) {
+      dest->insert(CreateObjectCopy(unit));
+    }
+
+    return dest;
+  }
+
+  size_t SetSizer(shared_ptr<void> ptr) {
+    auto &base = *static_pointer_cast<ObjectSet>(ptr);
+    return sizeof(ObjectSet) + base.allocated_bytes();
+  }
+
+  void SetInsertIntrinsic(Object &me, ObjectView *args, RuntimeFrame &frame) {
+    auto &value = args[0].Seek();
+
+    if (!management::type::IsHashable(value)) {
+      frame.MakeError("Unhashable element for set - " + value.GetTypeId());
+      return;
+    }
+
+    auto result = me.Cast<ObjectSet>().insert(management::type::CreateObjectCopy(value));
+    frame.RefreshReturnStack(result);
+  }
+
+  void SetContainsIntrinsic(Object &me, ObjectView *args, RuntimeFrame &frame) {
+    frame.RefreshReturnStack(me.Cast<ObjectSet>().contains(args[0].Seek()));
+  }
+
+  void SetEraseIntrinsic(Object &me, ObjectView *args, RuntimeFrame &frame) {
+    auto count = me.Cast<ObjectSet>().erase(args[0].Seek());
+    frame.RefreshReturnStack(Object(static_cast<int64_t>(count), kTypeIdInt));
+  }
+
+  /* deque, storage is shared with array */
+  Message NewDeque(ObjectMap &p) {
+    auto &src = p["src"];
+    ManagedArray base;
+
+    if (compare(src.GetTypeId(), kTypeIdArray, kTypeIdDeque)) {
+      base = static_pointer_cast<ObjectArray>(ArrayDelivery(src.Get()));
+    }
+    else if (src.Null()) {
+      base = make_shared<ObjectArray>();
+    }
+    else {
+      return Message("Invalid source for deque - " + src.GetTypeId(), kStateError);
+    }
+
+    return Message().SetObject(Object(base, kTypeIdDeque));
+  }
+
+  template <bool front>
+  Message DequePush(ObjectMap &p) {
+    auto &base = p.Cast<ObjectArray>(kStrMe);
+    auto obj = management::type::CreateObjectCopy(p["value"]);
+    front ? base.emplace_front(obj) : base.emplace_back(obj);
+    return Message();
+  }
+
+  //Removed element is returned, or null if deque is empty
+  template <bool front>
+  Message DequePop(ObjectMap &p) {
+    auto &base = p.Cast<ObjectArray>(kStrMe);
+    Object result;
+
+    if (base.empty()) return Message().SetObject(result);
+
+    if (front) {
+      result = base.front();
+      base.pop_front();
+    }
+    else {
+      result = base.back();
+      base.pop_back();
+    }
+
+    return Message().SetObject(result);
+  }
+
+  template <bool front>
+  Message DequePeek(ObjectMap &p) {
+    auto &base = p.Cast<ObjectArray>(kStrMe);
+    if (base.empty()) return Message("Deque is empty", kStateError);
+    return Message().SetObjectRef(front ? base.front() : base.back());
+  }
+
+  template <bool front>
+  void DequePushIntrinsic(Object &me, ObjectView *args, RuntimeFrame &frame) {
+    auto &base = me.Cast<ObjectArray>();
+    auto obj = management::type::CreateObjectCopy(args[0].Seek());
+    front ? base.emplace_front(obj) : base.emplace_back(obj);
+    frame.RefreshReturnStack(Object());
+  }
+
+  template <bool front>
+  void DequePopIntrinsic(Object &me, ObjectView *, RuntimeFrame &frame) {
+    auto &base = me.Cast<ObjectArray>();
+    Object result;
+
+    if (!base.empty()) {
+      result = front ? base.front() : base.back();
+      front ? base.pop_front() : base.pop_back();
+    }
+
+    frame.RefreshReturnStack(result);
+  }
+
+  /*
+    heap, the top element is the smallest one. Without comparator,
+    elements are ordered in the same way as sorted_table keys. Comparator
+    is called as comparator(lhs, rhs) and returns true if lhs goes first.
+  */
+  class HeapOrder {
+  private:
+    Object *comparator_;
+    bool failed_;
+    string msg_;
+
+  public:
+    HeapOrder(ObjectHeap &heap) : comparator_(heap.HasComparator() ?
+      &heap.GetComparator() : nullptr), failed_(false), msg_() {}
+
+    bool Less(Object &lhs, Object &rhs) {
+      if (failed_) return false;
+
+      if (comparator_ == nullptr) {
+        if (lhs.GetTypeId() == kTypeIdInt && rhs.GetTypeId() == kTypeIdInt) {
+          return lhs.Cast<int64_t>() < rhs.Cast<int64_t>();
+        }
+
+        return CompareSortKey(MakeSortKey(lhs), MakeSortKey(rhs)) < 0;
+      }
+
+      vector<Object> args = { lhs, rhs };
+      auto result = InvokeFunctionObject(*comparator_, args);
+
+      if (result.GetLevel() == kStateError) {
+        failed_ = true;
+        msg_ = result.GetDetail();
+        return false;
+      }
+
+      auto obj = result.GetObj();
+
+      if (obj.GetTypeId() != kTypeIdBool) {
+        failed_ = true;
+        msg_ = "Heap comparator must return bool value";
+        return false;
+      }
+
+      return obj.Cast<bool>();
+    }
+
+    bool Failed() const { return failed_; }
+    const string &GetMessage() const { return msg_; }
+  };
+
+  Message NewHeap(ObjectMap &p) {
+    auto &comparator = p["comparator"];
+
+    if (!comparator.Null() && comparator.GetTypeId() != kTypeIdFunction) {
+      return Message("Invalid heap comparator - " + comparator.GetTypeId(), kStateError);
+    }
+
+    ManagedHeap base = comparator.Null() ?
+      make_shared<ObjectHeap>() : make_shared<ObjectHeap>(comparator);
+    return Message().SetObject(Object(base, kTypeIdHeap));
+  }
+
+  /*
+    Sifting is done here instead of std::push_heap/pop_heap. Script
+    comparator may fail halfway, swaps are recorded and undone in reverse
+    order so the heap is left as it was before the operation.
+  */
+  using HeapSwaps = vector<pair<size_t, size_t>>;
+
+  inline void HeapSwap(vector<Object> &data, size_t lhs, size_t rhs, HeapSwaps &swaps) {
+    std::swap(data[lhs], data[rhs]);
+    swaps.emplace_back(lhs, rhs);
+  }
+
+  inline void UndoHeapSwaps(vector<Object> &data, HeapSwaps &swaps) {
+    for (auto it = swaps.rbegin(); it != swaps.rend(); ++it) {
+      std::swap(data[it->first], data[it->second]);
+    }
+  }
+
+  bool HeapSiftUp(vector<Object> &data, size_t idx, HeapOrder &order, HeapSwaps &swaps) {
+    while (idx > 0) {
+      size_t parent = (idx - 1) / 2;
+      bool less = order.Less(data[idx], data[parent]);
+      if (order.Failed()) return false;
+      if (!less) break;
+      HeapSwap(data, idx, parent, swaps);
+      idx = parent;
+    }
+
+    return true;
+  }
+
+  bool HeapSiftDown(vector<Object> &data, size_t idx, HeapOrder &order, HeapSwaps &swaps) {
+    size_t size = data.size();
+
+    while (idx * 2 + 1 < size) {
+      size_t child = idx * 2 + 1;
+
+      if (child + 1 < size) {
+        bool right_first = order.Less(data[child + 1], data[child]);
+        if (order.Failed()) return false;
+        if (right_first) child += 1;
+      }
+
+      bool less = order.Less(data[child], data[idx]);
+      if (order.Failed()) return false;
+      if (!less) break;
+      HeapSwap(data, idx, child, swaps);
+      idx = child;
+    }
+
+    return true;
+  }
+
+  Message HeapPushImpl(ObjectHeap &heap, Object &value) {
+    if (!heap.HasComparator() && !IsSortableKey(value)) {
+      return InvalidKeyError(value, "Heap without comparator only accepts plain type object");
+    }
+
+    auto &data = heap.GetData();
+    HeapOrder order(heap);
+
+    HeapSwaps swaps;
+
+    data.emplace_back(management::type::CreateObjectCopy(value));
+
+    if (!HeapSiftUp(data, data.size() - 1, order, swaps)) {
+      UndoHeapSwaps(data, swaps);
+      data.pop_back();
+      return Message(order.GetMessage(), kStateError);
+    }
+
+    return Message();
+  }
+
+  Message HeapPopImpl(ObjectHeap &heap) {
+    auto &data = heap.GetData();
+    HeapOrder order(heap);
+    Object result;
+
+    HeapSwaps swaps;
+
+    if (data.empty()) return Message().SetObject(result);
+
+    HeapSwap(data, 0, data.size() - 1, swaps);
+    result = std::move(data.back());
+    data.pop_back();
+
+    if (!HeapSiftDown(data, 0, order, swaps)) {
+      data.emplace_back(std::move(result));
+      UndoHeapSwaps(data, swaps);
+      return Message(order.GetMessage(), kStateError);
+    }
+
+    return Message().SetObject(result);
+  }
+
+  Message HeapPush(ObjectMap &p) {
+    return HeapPushImpl(p.Cast<ObjectHeap>(kStrMe), p["value"]);
+  }
+
+  //Top element is removed and returned, or null if heap is empty
+  Message HeapPop(ObjectMap &p) {
+    return HeapPopImpl(p.Cast<ObjectHeap>(kStrMe));
+  }
+
+  Message HeapTop(ObjectMap &p) {
+    auto &base = p.Cast<ObjectHeap>(kStrMe);
+    if (base.empty()) return Message().SetObject(Object());
+    return Message().SetObject(management::type::CreateObjectCopy(base[0]));
+  }
+
+  Message HeapSize(ObjectMap &p) {
+    return Message().SetObject(static_cast<int64_t>(p.Cast<ObjectHeap>(kStrMe).size()));
+  }
+
+  Message HeapEmpty(ObjectMap &p) {
+    return Message().SetObject(p.Cast<ObjectHeap>(kStrMe).empty());
+  }
+
+  Message HeapClear(ObjectMap &p) {
+    p.Cast<ObjectHeap>(kStrMe).GetData().clear();
+    return Message();
+  }
+
+  template <bool tail>
+  Message HeapIterator(ObjectMap &p) {
+    auto &base = p.Cast<ObjectHeap>(kStrMe);
+    shared_ptr<UnifiedIterator> it =
+      make_shared<UnifiedIterator>(tail ? base.end() : base.begin(), kContainerObjectHeap);
+    return Message().SetObject(Object(it, kTypeIdIterator));
+  }
+
+  shared_ptr<void> HeapDelivery(shared_ptr<void> ptr) {
+    using management::type::CreateObjectCopy;
+    auto &base = *static_pointer_cast<ObjectHeap>(ptr);
+    ManagedHeap dest = make_shared<ObjectHeap>(base.GetComparator());
+
+    dest->GetData().reserve(base.size());
+    for (auto &unit : base) {
+      dest->GetData().emplace_back(CreateObjectCopy(unit));
+    }
+
+    return dest;
+  }
+
+  size_t HeapSizer(shared_ptr<void> ptr) {
+    auto &base = *static_pointer_cast<ObjectHeap>(ptr);
+    return sizeof(ObjectHeap) + base.GetData().capacity() * sizeof(Object);
+  }
+
+  void HeapPushIntrinsic(Object &me, ObjectView *args, RuntimeFrame &frame) {
+    auto msg = HeapPushImpl(me.Cast<ObjectHeap>(), args[0].Seek());
+
+    if (msg.GetLevel() == kStateError) {
+      frame.MakeError(msg.GetDetail());
+      return;
+    }
+
+    frame.RefreshReturnStack(Object());
+  }
+
+  void HeapPopIntrinsic(Object &me, ObjectView *, RuntimeFrame &frame) {
+    auto msg = HeapPopImpl(me.Cast<ObjectHeap>());
+
+    if (msg.GetLevel() == kStateError) {
+      frame.MakeError(msg.GetDetail());
+      return;
+    }
+
+    frame.RefreshReturnStack(msg.GetObj());
+  }
+
+  void InitCollectionTypes() {
+    using management::type::ObjectTraitsSetup;
+
+    ObjectTraitsSetup(kTypeIdSet, SetDelivery)
+      .InitSizer(SetSizer)
+      .InitConstructor(
+        FunctionImpl(NewSet, "src", "set", kParamAutoFill).SetLimit(0)
+      )
+      .InitMethods(
+        {
+          FunctionImpl(SetInsert, "value", "insert"),
+          FunctionImpl(SetContains, "value", "contains"),
+          FunctionImpl(SetErase, "value", "erase"),
+          FunctionImpl(SetSize, "", "size"),
+          FunctionImpl(SetEmpty, "", "empty"),
+          FunctionImpl(SetClear, "", "clear"),
+          FunctionImpl(SetIterator<false>, "", "head"),
+          FunctionImpl(SetIterator<true>, "", "tail"),
+          FunctionImpl(SetToArray, "", "to_array")
+        }
+    );
+
+    CreateIntrinsics(
+      {
+        IntrinsicImpl{ "insert", kTypeIdSet, 1, SetInsertIntrinsic },
+        IntrinsicImpl{ "contains", kTypeIdSet, 1, SetContainsIntrinsic },
+        IntrinsicImpl{ "erase", kTypeIdSet, 1, SetEraseIntrinsic },
+        IntrinsicImpl{ "size", kTypeIdSet, 0, ContainerSizeIntrinsic<ObjectSet> },
+        IntrinsicImpl{ "empty", kTypeIdSet, 0, ContainerEmptyIntrinsic<ObjectSet> }
+      }
+    );
+
+    ObjectTraitsSetup(kTypeIdDeque, ArrayDelivery)
+      .InitSizer(ArraySizer)
+      .InitConstructor(
+        FunctionImpl(NewDeque, "src", "deque", kParamAutoFill).SetLimit(0)
+      )
+      .InitMethods(
+        {
+          FunctionImpl(ArrayGetElement, "index", kStrAt),
+          FunctionImpl(DequePush<false>, "value", "push_back"),
+          FunctionImpl(DequePush<true>, "value", "push_front"),
+          FunctionImpl(DequePop<false>, "", "pop_back"),
+          FunctionImpl(DequePop<true>, "", "pop_front"),
+          FunctionImpl(DequePeek<false>, "", "back"),
+          FunctionImpl(DequePeek<true>, "", "front"),
+          FunctionImpl(ArrayGetSize, "", "size"),
+          FunctionImpl(ArrayEmpty, "", "empty"),
+          FunctionImpl(ArrayClear, "", "clear"),
+          FunctionImpl(ArrayHead, "", "head"),
+          FunctionImpl(ArrayTail, "", "tail")
+        }
+    );
+
+    CreateIntrinsics(
+      {
+        IntrinsicImpl{ kStrAt, kTypeIdDeque, 1, ArrayAtIntrinsic },
+        IntrinsicImpl{ "push_back", kTypeIdDeque, 1, DequePushIntrinsic<false> },
+        IntrinsicImpl{ "push_front", kTypeIdDeque, 1, DequePushIntrinsic<true> },
+        IntrinsicImpl{ "pop_back", kTypeIdDeque, 0, DequePopIntrinsic<false> },
+        IntrinsicImpl{ "pop_front", kTypeIdDeque, 0, DequePopIntrinsic<true> },
+        IntrinsicImpl{ "size", kTypeIdDeque, 0, ContainerSizeIntrinsic<ObjectArray> },
+        IntrinsicImpl{ "empty", kTypeIdDeque, 0, ContainerEmptyIntrinsic<ObjectArray> }
+      }
+    );
+
+    ObjectTraitsSetup(kTypeIdHeap, HeapDelivery)
+      .InitSizer(HeapSizer)
+      .InitConstructor(
+        FunctionImpl(NewHeap, "comparator", "heap", kParamAutoFill).SetLimit(0)
+      )
+      .InitMethods(
+        {
+          FunctionImpl(HeapPush, "value", "push"),
+          FunctionImpl(HeapPop, "", "pop"),
+          FunctionImpl(HeapTop, "", "top"),
+          FunctionImpl(HeapSize, "", "size"),
+          FunctionImpl(HeapEmpty, "", "empty"),
+          FunctionImpl(HeapClear, "", "clear"),
+          FunctionImpl(HeapIterator<false>, "", "head"),
+          FunctionImpl(HeapIterator<true>, "", "tail")
+        }
+    );
+
+    CreateIntrinsics(
+      {
+        IntrinsicImpl{ "push", kTypeIdHeap, 1, HeapPushIntrinsic },
+        IntrinsicImpl{ "pop", kTypeIdHeap, 0, HeapPopIntrinsic },
+        IntrinsicImpl{ "size", kTypeIdHeap, 0, ContainerSizeIntrinsic<ObjectHeap> },
+        IntrinsicImpl{ "empty", kTypeIdHeap, 0, ContainerEmptyIntrinsic<ObjectHeap> }
+      }
+    );
+
+    management::CreateImpl(
+      FunctionImpl(NewHeap, "comparator", "priority_queue", kParamAutoFill).SetLimit(0)
+    );
+  }
+
+  /*
+    Higher-order builtins over array, deque and packed arrays. reduce()
+    calls its callback as callback(accumulator, value), other builtins call
+    callback(value). Returning values are copied in the same way as pushing
+    into array. Elements appended by callback are not visited, length of
+    source is taken before the first calling.
+  */
+  template <typename T>
+  size_t GetSourceSize(Object &source) {
+    return source.Cast<T>().size();
+  }
+
+  //Elements of packed arrays are created as plain type objects
+  template <typename T>
+  Object GetSourceElement(Object &source, size_t idx) {
+    auto &base = source.Cast<T>();
+    if constexpr (std::is_same_v<T, ObjectArray>) return base[idx];
+    else return PackElement(base[idx]);
+  }
+
+  template <typename T>
+  inline void SetSourceAccess(CallbackDriver::SizeGetter &size_getter,
+    CallbackDriver::ElementGetter &element_getter) {
+    size_getter = GetSourceSize<T>;
+    element_getter = GetSourceElement<T>;
+  }
+
+  bool CallbackDriver::SelectSourceAccess(const string &type_id,
+    SizeGetter &size_getter, ElementGetter &element_getter) {
+    if (type_id == kTypeIdArray || type_id == kTypeIdDeque) {
+      SetSourceAccess<ObjectArray>(size_getter, element_getter);
+    }
+    else if (type_id == kTypeIdIntArray) {
+      SetSourceAccess<IntArray>(size_getter, element_getter);
+    }
+    else if (type_id == kTypeIdFloatArray) {
+      SetSourceAccess<FloatArray>(size_getter, element_getter);
+    }
+    else if (type_id == kTypeIdBoolArray) {
+      SetSourceAccess<BoolArray>(size_getter, element_getter);
+    }
+    else {
+      return false;
+    }
+
+    return true;
+  }
+
+  CallbackDriver::CallbackDriver(CallbackDriverKind kind, Object &source,
+    Object &callback, Object &init, size_t start) :
+    kind_(kind), source_(source), size_getter_(nullptr), element_getter_(nullptr),
+    callback_(callback), current_(), accumulator_(init), results_(), keys_(),
+    idx_(start), end_(0), finished_(false),
+    msg_(), caller_void_call(false), caller_stack_base(0) {
+    SelectSourceAccess(source.GetTypeId(), size_getter_, element_getter_);
+    end_ = size_getter_(source_);
+  }
+
+  bool CallbackDriver::Prepare(ObjectMap &args) {
+    auto &params = GetImpl().GetParameters();
+
+    //Callback may also remove elements from source container
+    if (finished_ || idx_ >= end_ || idx_ >= size_getter_(source_)) {
+      finished_ = true;
+      return false;
+    }
+
+    current_ = element_getter_(source_, idx_);
+    idx_ += 1;
+
+    if (kind_ == kDriverReduce) {
+      args.emplace(NamedObject(params[0], accumulator_));
+      args.emplace(NamedObject(params[1], current_));
+    }
+    else {
+      args.emplace(NamedObject(params[0], current_));
+    }
+
+    return true;
+  }
+
+  bool CallbackDriver::Feed(Object &value) {
+    using management::type::CreateObjectCopy;
+
+    if (kind_ == kDriverMap) {
+      results_.emplace_back(CreateObjectCopy(value));
+    }
+    else if (kind_ == kDriverReduce) {
+      accumulator_ = CreateObjectCopy(value);
+    }
+    else if (kind_ == kDriverSortBy) {
+      auto key = MakeSortKey(value);
+
+      if (key.kind == kSortKeyInvalid) {
+        msg_ = IsNaNKey(value) ?
+          "NaN can't be used as key" : "Invalid sorting key - " + value.GetTypeId();
+        return false;
+      }
+
+      keys_.emplace_back(std::move(key));
+      results_.emplace_back(CreateObjectCopy(current_));
+    }
+    else {
+      if (value.GetTypeId() != kTypeIdBool) {
+        msg_ = "Callback must return bool value";
+        return false;
+      }
+
+      bool state = value.Cast<bool>();
+
+      if (kind_ == kDriverFilter) {
+        if (state) results_.emplace_back(CreateObjectCopy(current_));
+      }
+      //any() stops at first true value, all() stops at first false value
+      else if (state == (kind_ == kDriverAny)) {
+        accumulator_ = Object(state, kTypeIdBool);
+        finished_ = true;
+      }
+    }
+
+    return true;
+  }
+
+  Object CallbackDriver::GetResult() {
+    if (kind_ == kDriverReduce || kind_ == kDriverAny || kind_ == kDriverAll) {
+      return accumulator_;
+    }
+
+    ManagedArray base = make_shared<ObjectArray>();
+
+    if (kind_ == kDriverSortBy) {
+      vector<size_t> order(results_.size());
+
+      for (size_t idx = 0; idx < order.size(); ++idx) order[idx] = idx;
+
+      std::stable_sort(order.begin(), order.end(), [this](size_t lhs, size_t rhs) -> bool {
+        return CompareSortKey(keys_[lhs], keys_[rhs]) < 0;
+      });
+
+      for (auto idx : order) base->emplace_back(results_[idx]);
+    }
+    else {
+      base->swap(results_);
+    }
+
+    results_.clear();
+    keys_.clear();
+    return Object(base, kTypeIdArray);
+  }
+
+  template <CallbackDriverKind kind>
+  Message HigherOrderFunction(ObjectMap &p) {
+    using management::type::CreateObjectCopy;
+    auto &src = p["src"];
+    auto &callback = p["callback"];
+    size_t arity = kind == kDriverReduce ? 2 : 1;
+    size_t start = 0;
+    Object init;
+    CallbackDriver::SizeGetter size_getter;
+    CallbackDriver::ElementGetter element_getter;
+
+    if (!CallbackDriver::SelectSourceAccess(src.GetTypeId(), size_getter, element_getter)) {
+      return Message("Expected array, deque or packed array - " + src.GetTypeId(), kStateError);
+    }
+
+    if (callback.GetTypeId() != kTypeIdFunction) {
+      return Message("Invalid callback - " + callback.GetTypeId(), kStateError);
+    }
+
+    auto &impl = callback.Cast<FunctionImpl>();
+
+    if (impl.GetPattern() != kParamFixed || impl.GetParameters().size() != arity) {
+      return Message("Callback must accept " + to_string(arity) + " argument(s)", kStateError);
+    }
+
+    if constexpr (kind == kDriverReduce) {
+      if (!p["init"].Null()) {
+        init = CreateObjectCopy(p["init"]);
+      }
+      else if (size_getter(src) > 0) {
+        auto front = element_getter(src, 0);
+        init = CreateObjectCopy(front);
+        start = 1;
+      }
+      else {
+        return Message("Empty container without initial value", kStateError);
+      }
+    }
+    else if constexpr (kind == kDriverAny || kind == kDriverAll) {
+      init = Object(kind == kDriverAll, kTypeIdBool);
+    }
+
+    auto driver = make_shared<CallbackDriver>(kind, src, callback, init, start);
+
+    //Script function is called from main loop of machine
+    if (impl.GetType() == kFunctionVMCode) {
+      return Message().SetDrivingSign(Object(driver, kTypeIdCallbackDriver));
+    }
+
+    if (impl.GetType() != kFunctionCXX) {
+      return Message("Unsupported function variant", kStateError);
+    }
+
+    auto activity = impl.GetActivity();
+    ObjectMap args;
+    Message result;
+
+    while (driver->Prepare(args)) {
+      result = activity(args);
+
+      if (result.GetLevel() == kStateError) return result;
+
+      if (result.IsInvokingRequest() || result.IsDrivingRequest()) {
+        return Message("Unsupported callback - " + impl.GetId(), kStateError);
+      }
+
+      auto value = result.GetObj();
+      if (!driver->Feed(value)) return Message(driver->GetMessage(), kStateError);
+      args.clear();
+    }
+
+    return Message().SetObject(driver->GetResult());
+  }
+
+  void InitHigherOrderFunctions() {
+    using management::CreateImpl;
+
+    CreateImpl(FunctionImpl(HigherOrderFunction<kDriverMap>, "src|callback", "map"));
+    CreateImpl(FunctionImpl(HigherOrderFunction<kDriverFilter>, "src|callback", "filter"));
+    CreateImpl(FunctionImpl(HigherOrderFunction<kDriverAny>, "src|callback", "any"));
+    CreateImpl(FunctionImpl(HigherOrderFunction<kDriverAll>, "src|callback", "all"));
+    CreateImpl(FunctionImpl(HigherOrderFunction<kDriverSortBy>, "src|callback", "sort_by"));
+    CreateImpl(
+      FunctionImpl(HigherOrderFunction<kDriverReduce>, "src|callback|init", "reduce", 
+        kParamAutoFill).SetLimit(2)
+    );
+  }
+
+  void InitContainerComponents() {
+    using management::type::ObjectTraitsSetup;
+
+    //TODO:insert()
+    ObjectTraitsSetup(kTypeIdArray, ArrayDelivery, ArrayHasher)
+      .InitSizer(ArraySizer)
+      .InitConstructor(
+        FunctionImpl(NewArray, "size|init_value", "array", kParamAutoFill).SetLimit(0)
+      )
+      .InitMethods(
+        {
+          FunctionImpl(ArrayGetElement, "index", kStrAt),
+          FunctionImpl(ArrayGetSize, "", "size"),
+          FunctionImpl(ArrayPush, "object", "push"),
+          FunctionImpl(ArrayPop, "", "pop"),
+          FunctionImpl(ArrayEmpty, "", "empty"),
+          FunctionImpl(ArrayHead, "", "head"),
+          FunctionImpl(ArrayTail, "", "tail"),
+          FunctionImpl(ArrayClear, "", "clear"),
+          FunctionImpl(SequenceJoin<ObjectArray>, "separator", "join")
+        }
+    );
+
+    CreateIntrinsics(
+      {
+        IntrinsicImpl{ kStrAt, kTypeIdArray, 1, ArrayAtIntrinsic },
+        IntrinsicImpl{ "size", kTypeIdArray, 0, ContainerSizeIntrinsic<ObjectArray> },
+        IntrinsicImpl{ "push", kTypeIdArray, 1, ArrayPushIntrinsic },
+        IntrinsicImpl{ "pop", kTypeIdArray, 0, SequencePopIntrinsic<ObjectArray> },
+        IntrinsicImpl{ "empty", kTypeIdArray, 0, ContainerEmptyIntrinsic<ObjectArray> },
+        IntrinsicImpl{ "head", kTypeIdArray, 0,
+          ContainerIteratorIntrinsic<ObjectArray, kContainerObjectArray, false> },
+        IntrinsicImpl{ "tail", kTypeIdArray, 0,
+          ContainerIteratorIntrinsic<ObjectArray, kContainerObjectArray, true> },
+        IntrinsicImpl{ "clear", kTypeIdArray, 0, SequenceClearIntrinsic<ObjectArray> }
+      }
+    );
+
+    ObjectTraitsSetup(kTypeIdArraySlice, PlainDeliveryImpl<ArraySlice>)
+      .InitMethods(
+        {
+          FunctionImpl(ArraySliceGetElement, "index", kStrAt),
+          FunctionImpl(ArraySliceGetSize, "", "size"),
+          FunctionImpl(ArraySliceEmpty, "", "empty"),
+          FunctionImpl(ArraySliceHead, "", "head"),
+          FunctionImpl(ArraySliceTail, "", "tail"),
+          FunctionImpl(ArraySliceToArray, "", "to_array"),
+          FunctionImpl(SequenceJoin<ArraySlice>, "separator", "join")
+        }
+    );
+
+    CreateIntrinsics(
+      {
+        IntrinsicImpl{ kStrAt, kTypeIdArraySlice, 1, ArraySliceAtIntrinsic },
+        IntrinsicImpl{ "size", kTypeIdArraySlice, 0, ContainerSizeIntrinsic<ArraySlice> },
+        IntrinsicImpl{ "empty", kTypeIdArraySlice, 0, ContainerEmptyIntrinsic<ArraySlice> },
+        IntrinsicImpl{ "head", kTypeIdArraySlice, 0,
+          ContainerIteratorIntrinsic<ArraySlice, kContainerObjectArray, false> },
+        IntrinsicImpl{ "tail", kTypeIdArraySlice, 0,
+          ContainerIteratorIntrinsic<ArraySlice, kContainerObjectArray, true> }
+      }
+    );
+
+    management::CreateImpl(FunctionImpl(NewSlice, "src|start|size", "slice"));
+
+    InitPackedArrayType<int64_t>();
+    InitPackedArrayType<double>();
+    InitPackedArrayType<uint8_t>();
+    InitBytesType();
+    InitCollectionTypes();
+    InitHigherOrderFunctions();
+
+    management::CreateImpl(
+      FunctionImpl(NewRange, "start|stop|step", kStrRange, kParamAutoFill).SetLimit(2)
+    );
+
+    ObjectTraitsSetup(kTypeIdIterator, PlainDeliveryImpl<UnifiedIterator>)
+      .InitComparator(IteratorComparator)
+      .InitMethods(
+        {
+          FunctionImpl(IteratorGet, "", "obj"),
+          FunctionImpl(IteratorStepForward, "", "step_forward"),
+          FunctionImpl(IteratorStepBack, "", "step_back"),
+          FunctionImpl(IteratorOperatorCompare, kStrRightHandSide, kStrCompare)
+        }
+    );
+
+    ObjectTraitsSetup(kTypeIdPair, PairDelivery)
+      .InitConstructor(
+        FunctionImpl(NewPair, "left|right", "pair")
+      )
+      .InitMethods(
+        {
+          FunctionImpl(PairLeft, "", "left"),
+          FunctionImpl(PairRight, "", "right")
+        }
+    );
 
     ObjectTraitsSetup(kTypeIdTable, TableDelivery)
+      .InitSizer(TableSizer)
       .InitConstructor(
         FunctionImpl(NewTable, "", "table")
       )
@@ -324,13 +2349,84 @@ namespace kagami {
           FunctionImpl(TableSize, "", "size"),
           FunctionImpl(TableClear, "", "clear"),
           FunctionImpl(TableHead, "", "head"),
-          FunctionImpl(TableTail, "", "tail")
+          FunctionImpl(TableTail, "", "tail"),
+          FunctionImpl(TableGetView<kTableViewItems>, "", "items"),
+          FunctionImpl(TableGetView<kTableViewValues>, "", "values")
+        }
+    );
+
+    CreateIntrinsics(
+      {
+        IntrinsicImpl{ kStrAt, kTypeIdTable, 1, TableAtIntrinsic },
+        IntrinsicImpl{ "insert", kTypeIdTable, 2, TableInsertIntrinsic },
+        IntrinsicImpl{ "find", kTypeIdTable, 1, TableFindIntrinsic },
+        IntrinsicImpl{ "erase", kTypeIdTable, 1, TableEraseIntrinsic },
+        IntrinsicImpl{ "empty", kTypeIdTable, 0, ContainerEmptyIntrinsic<ObjectTable> },
+        IntrinsicImpl{ "size", kTypeIdTable, 0, ContainerSizeIntrinsic<ObjectTable> },
+        IntrinsicImpl{ "clear", kTypeIdTable, 0, TableClearIntrinsic },
+        IntrinsicImpl{ "head", kTypeIdTable, 0,
+          ContainerIteratorIntrinsic<ObjectTable, kContainerObjectTable, false> },
+        IntrinsicImpl{ "tail", kTypeIdTable, 0,
+          ContainerIteratorIntrinsic<ObjectTable, kContainerObjectTable, true> }
+      }
+    );
+
+    ObjectTraitsSetup(kTypeIdSortedTable, SortedTableDelivery)
+      .InitSizer(SortedTableSizer)
+      .InitConstructor(
+        FunctionImpl(NewSortedTable, "", "sorted_table")
+      )
+      .InitMethods(
+        {
+          FunctionImpl(SortedTableInsert, "key|value", "insert"),
+          FunctionImpl(SortedTableGetElement, "key", kStrAt),
+          FunctionImpl(SortedTableFindElement, "key", "find"),
+          FunctionImpl(SortedTableEraseElement, "key", "erase"),
+          FunctionImpl(SortedTableEmpty, "", "empty"),
+          FunctionImpl(SortedTableSize, "", "size"),
+          FunctionImpl(SortedTableClear, "", "clear"),
+          FunctionImpl(SortedTableHead, "", "head"),
+          FunctionImpl(SortedTableTail, "", "tail"),
+          FunctionImpl(SortedTableBound<false>, "key", "lower_bound"),
+          FunctionImpl(SortedTableBound<true>, "key", "upper_bound"),
+          FunctionImpl(SortedTableRange, "low|high", "range"),
+          FunctionImpl(TableGetView<kTableViewItems>, "", "items"),
+          FunctionImpl(TableGetView<kTableViewValues>, "", "values")
+        }
+    );
+
+    ObjectTraitsSetup(kTypeIdSortedRange, PlainDeliveryImpl<SortedRange>)
+      .InitMethods(
+        {
+          FunctionImpl(SortedRangeEmpty, "", "empty"),
+          FunctionImpl(SortedRangeSize, "", "size"),
+          FunctionImpl(SortedRangeHead, "", "head"),
+          FunctionImpl(SortedRangeTail, "", "tail")
+        }
+    );
+
+    ObjectTraitsSetup(kTypeIdTableView, PlainDeliveryImpl<TableView>)
+      .InitMethods(
+        {
+          FunctionImpl(TableViewEmpty, "", "empty"),
+          FunctionImpl(TableViewSize, "", "size")
         }
     );
 
     EXPORT_CONSTANT(kTypeIdArray);
+    EXPORT_CONSTANT(kTypeIdArraySlice);
+    EXPORT_CONSTANT(kTypeIdIntArray);
+    EXPORT_CONSTANT(kTypeIdFloatArray);
+    EXPORT_CONSTANT(kTypeIdBoolArray);
+    EXPORT_CONSTANT(kTypeIdBytes);
     EXPORT_CONSTANT(kTypeIdIterator);
     EXPORT_CONSTANT(kTypeIdPair);
     EXPORT_CONSTANT(kTypeIdTable);
+    EXPORT_CONSTANT(kTypeIdSortedTable);
+    EXPORT_CONSTANT(kTypeIdSortedRange);
+    EXPORT_CONSTANT(kTypeIdTableView);
+    EXPORT_CONSTANT(kTypeIdSet);
+    EXPORT_CONSTANT(kTypeIdDeque);
+    EXPORT_CONSTANT(kTypeIdHeap);
   }
 }
\ No newline at end of file
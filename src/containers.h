@@ -1,5 +1,6 @@
 #pragma once
 #include "machine.h"
+#include "kernels.h"
 /*
   Base container implementations for Kagami script.
 */
@@ -8,9 +9,78 @@ namespace kagami {
   enum BaseContainerCode {
     kContainerObjectArray,
     kContainerObjectTable,
+    kContainerIntArray,
+    kContainerFloatArray,
+    kContainerBoolArray,
+    kContainerSortedTable,
+    kContainerObjectSet,
+    kContainerObjectHeap,
     kContainerNull
   };
 
+  enum TableViewKind {
+    kTableViewItems,
+    kTableViewValues
+  };
+
+  //Iteration view of table or sorted_table, the view keeps the table alive.
+  //for-each loop binds stored entries as references.
+  struct TableView {
+    Object table;
+    TableViewKind kind;
+  };
+
+  /* Element packing for iterators and packed arrays */
+  inline Object PackElement(Object &obj) { return Object().PackObject(obj); }
+  inline Object PackElement(int64_t value) { return Object(value, kTypeIdInt); }
+  inline Object PackElement(double value) { return Object(value, kTypeIdFloat); }
+  inline Object PackElement(uint8_t value) { return Object(value != 0, kTypeIdBool); }
+
+  /* Plain value extraction for packed arrays */
+  template <typename T>
+  bool FetchElement(Object &obj, T &dest) { return false; }
+
+  template <>
+  inline bool FetchElement<int64_t>(Object &obj, int64_t &dest) {
+    if (obj.GetTypeId() != kTypeIdInt) return false;
+    dest = obj.Cast<int64_t>();
+    return true;
+  }
+
+  template <>
+  inline bool FetchElement<double>(Object &obj, double &dest) {
+    auto type_id = obj.GetTypeId();
+    if (type_id == kTypeIdFloat) dest = obj.Cast<double>();
+    else if (type_id == kTypeIdInt) dest = static_cast<double>(obj.Cast<int64_t>());
+    else return false;
+    return true;
+  }
+
+  template <>
+  inline bool FetchElement<uint8_t>(Object &obj, uint8_t &dest) {
+    if (obj.GetTypeId() != kTypeIdBool) return false;
+    dest = obj.Cast<bool>() ? 1 : 0;
+    return true;
+  }
+
+  /* Type information for packed arrays */
+  template <typename T>
+  struct PackedArrayTrait {};
+
+#define INIT_PACKED_ARRAY_TRAIT(_Type, _TypeId, _ElementTypeId, _Code) \
+  template <>                                                           \
+  struct PackedArrayTrait<_Type> {                                      \
+    static const BaseContainerCode code = _Code;                        \
+    static string TypeId() { return _TypeId; }                          \
+    static string ElementTypeId() { return _ElementTypeId; }            \
+  };
+
+  INIT_PACKED_ARRAY_TRAIT(int64_t, kTypeIdIntArray, kTypeIdInt, kContainerIntArray)
+  INIT_PACKED_ARRAY_TRAIT(double, kTypeIdFloatArray, kTypeIdFloat, kContainerFloatArray)
+  INIT_PACKED_ARRAY_TRAIT(uint8_t, kTypeIdBoolArray, kTypeIdBool, kContainerBoolArray)
+
+#undef INIT_PACKED_ARRAY_TRAIT
+
   /* Unified iterator wrapper */
   class IteratorInterface {
   public:
@@ -18,6 +88,9 @@ namespace kagami {
     virtual void StepForward() = 0;
     virtual void StepBack() = 0;
     virtual Object Unpack() = 0;
+    //Iterator of node-based container may be invalidated by modification,
+    //iterator of hash table/set is invalidated by clear()
+    virtual bool IsValid() { return true; }
   };
 
   template <typename IteratorType>
@@ -34,7 +107,7 @@ namespace kagami {
   public:
     void StepForward() { ++it_; }
     void StepBack() { --it_; }
-    Object Unpack() { return Object().PackObject(*it_); }
+    Object Unpack() { return PackElement(*it_); }
     IteratorType &Get() { return it_; }
     bool operator==(BasicIterator<IteratorType> &rhs) const 
     { return it_ == rhs.it_; }
@@ -56,6 +129,7 @@ namespace kagami {
     void StepForward() { ++it_; }
     void StepBack() { }
     ObjectTable::iterator &Get() { return it_; }
+    bool IsValid() { return it_.IsValid(); }
     Object Unpack() {
       auto copy_left = it_->first;
       ManagedPair base = make_shared<ObjectPair>(
@@ -67,8 +141,83 @@ namespace kagami {
     { return it_ == rhs.it_; }
   };
 
+  template <>
+  class BasicIterator<SortedTable::iterator> : public IteratorInterface {
+  private:
+    SortedTable::iterator it_;
+
+  public:
+    BasicIterator() = delete;
+    BasicIterator(SortedTable::iterator it) : it_(it) {}
+    BasicIterator(const BasicIterator &rhs) : it_(rhs.it_) {}
+    BasicIterator(const BasicIterator &&rhs) : BasicIterator(rhs) {}
+
+  public:
+    void StepForward() { ++it_; }
+    void StepBack() { }
+    SortedTable::iterator &Get() { return it_; }
+    bool IsValid() { return it_.IsValid(); }
+    Object Unpack() {
+      ManagedPair base = make_shared<ObjectPair>(
+        Object(management::type::CreateObjectCopy(it_->first)),
+        Object(management::type::CreateObjectCopy(it_->second)));
+      return Object(base, kTypeIdPair);
+    }
+    bool operator==(BasicIterator<SortedTable::iterator> &rhs) const
+    { return it_ == rhs.it_; }
+  };
+
+  //Elements of set and heap are unpacked as copies, modifying them in place
+  //would break hash/heap order of container
+  template <>
+  class BasicIterator<ObjectSet::iterator> : public IteratorInterface {
+  private:
+    ObjectSet::iterator it_;
+
+  public:
+    BasicIterator() = delete;
+    BasicIterator(ObjectSet::iterator it) : it_(it) {}
+    BasicIterator(const BasicIterator &rhs) : it_(rhs.it_) {}
+    BasicIterator(const BasicIterator &&rhs) : BasicIterator(rhs) {}
+
+  public:
+    void StepForward() { ++it_; }
+    void StepBack() { }
+    ObjectSet::iterator &Get() { return it_; }
+    bool IsValid() { return it_.IsValid(); }
+    Object Unpack() { return management::type::CreateObjectCopy(*it_); }
+    bool operator==(BasicIterator<ObjectSet::iterator> &rhs) const
+    { return it_ == rhs.it_; }
+  };
+
+  template <>
+  class BasicIterator<vector<Object>::iterator> : public IteratorInterface {
+  private:
+    vector<Object>::iterator it_;
+
+  public:
+    BasicIterator() = delete;
+    BasicIterator(vector<Object>::iterator it) : it_(it) {}
+    BasicIterator(const BasicIterator &rhs) : it_(rhs.it_) {}
+    BasicIterator(const BasicIterator &&rhs) : BasicIterator(rhs) {}
+
+  public:
+    void StepForward() { ++it_; }
+    void StepBack() { --it_; }
+    vector<Object>::iterator &Get() { return it_; }
+    Object Unpack() { return management::type::CreateObjectCopy(*it_); }
+    bool operator==(BasicIterator<vector<Object>::iterator> &rhs) const
+    { return it_ == rhs.it_; }
+  };
+
   using ObjectArrayIterator = BasicIterator<ObjectArray::iterator>;
   using ObjectTableIterator = BasicIterator<ObjectTable::iterator>;
+  using IntArrayIterator = BasicIterator<IntArray::iterator>;
+  using FloatArrayIterator = BasicIterator<FloatArray::iterator>;
+  using BoolArrayIterator = BasicIterator<BoolArray::iterator>;
+  using SortedTableIterator = BasicIterator<SortedTable::iterator>;
+  using ObjectSetIterator = BasicIterator<ObjectSet::iterator>;
+  using ObjectHeapIterator = BasicIterator<vector<Object>::iterator>;
   /*
     Top iterator wrapper.
     Provide unified methods for iterator type in script.
@@ -128,6 +277,7 @@ namespace kagami {
     }
 
     Object Unpack() { return it_->Unpack(); }
+    bool IsValid() { return it_ == nullptr || it_->IsValid(); }
 
     bool Compare(UnifiedIterator &rhs) {
       bool result = false;
@@ -141,6 +291,24 @@ namespace kagami {
         case kContainerObjectTable:
           result = CastAndCompare<ObjectTableIterator>(it_, rhs.it_);
           break;
+        case kContainerIntArray:
+          result = CastAndCompare<IntArrayIterator>(it_, rhs.it_);
+          break;
+        case kContainerFloatArray:
+          result = CastAndCompare<FloatArrayIterator>(it_, rhs.it_);
+          break;
+        case kContainerBoolArray:
+          result = CastAndCompare<BoolArrayIterator>(it_, rhs.it_);
+          break;
+        case kContainerSortedTable:
+          result = CastAndCompare<SortedTableIterator>(it_, rhs.it_);
+          break;
+        case kContainerObjectSet:
+          result = CastAndCompare<ObjectSetIterator>(it_, rhs.it_);
+          break;
+        case kContainerObjectHeap:
+          result = CastAndCompare<ObjectHeapIterator>(it_, rhs.it_);
+          break;
         default:
           result = false;
           break;
@@ -164,6 +332,24 @@ namespace kagami {
       case kContainerObjectTable:
         COPY_ITERATOR(ObjectTableIterator);
         break;
+      case kContainerIntArray:
+        COPY_ITERATOR(IntArrayIterator);
+        break;
+      case kContainerFloatArray:
+        COPY_ITERATOR(FloatArrayIterator);
+        break;
+      case kContainerBoolArray:
+        COPY_ITERATOR(BoolArrayIterator);
+        break;
+      case kContainerSortedTable:
+        COPY_ITERATOR(SortedTableIterator);
+        break;
+      case kContainerObjectSet:
+        COPY_ITERATOR(ObjectSetIterator);
+        break;
+      case kContainerObjectHeap:
+        COPY_ITERATOR(ObjectHeapIterator);
+        break;
       default:
         break;
       }
@@ -171,4 +357,4 @@ namespace kagami {
       return it;
     }
   };
-}
\ No newline at end of file
+}
\ No newline at end of file
@@ -16,6 +16,9 @@ namespace kagami {
     kExtTypeFunctionPointer = 6,
     kExtTypeObjectPointer   = 7,
     kExtTypeArray           = 8,
+    kExtTypeIntArray        = 9,
+    kExtTypeFloatArray      = 10,
+    kExtTypeBoolArray       = 11,
     kExtCustomTypes         = 100
   };
 
@@ -89,7 +92,10 @@ namespace kagami {
     make_pair(kTypeIdWideString, kExtTypeWideString),
     make_pair(kTypeIdFunctionPointer, kExtTypeFunctionPointer),
     make_pair(kTypeIdObjectPointer, kExtTypeObjectPointer),
-    make_pair(kTypeIdArray, kExtTypeArray)
+    make_pair(kTypeIdArray, kExtTypeArray),
+    make_pair(kTypeIdIntArray, kExtTypeIntArray),
+    make_pair(kTypeIdFloatArray, kExtTypeFloatArray),
+    make_pair(kTypeIdBoolArray, kExtTypeBoolArray)
   };
 
   extern "C" struct Descriptor {
@@ -105,6 +111,7 @@ namespace kagami {
   using ObjectDumper = int(*)(Descriptor *, void **);
   using DescriptorFetcher = int(*)(Descriptor *, void *, const char *);
   using CapacityInformer = size_t(*)(Descriptor);
+  using BufferFetcher = int(*)(Descriptor *, void **, size_t *);
 
   extern "C" struct ExtInterfaces {
     MemoryDisposer disposer;
@@ -114,6 +121,7 @@ namespace kagami {
     ArrayElementFetcher arr_elem_fetcher;
     ObjectDumper dumper;
     CapacityInformer capacity_informer;
+    BufferFetcher buffer_fetcher;
   };
 
   using ExtensionLoader = int(*)(ExtInterfaces *);
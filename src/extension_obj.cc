@@ -20,7 +20,8 @@ namespace kagami {
       FetchDescriptor,
       FetchArrayElementDescriptor,
       DumpObjectFromDescriptor,
-      GetArrayObjectCapacity
+      GetArrayObjectCapacity,
+      FetchArrayBuffer
     };
 
     auto result = loader(&interfaces);
@@ -1,4 +1,10 @@
 #include "filestream.h"
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 namespace kagami {
   FILE *GetVMStdout(FILE *dest) {
@@ -24,6 +30,66 @@ namespace kagami {
     if (GetVMStdout() != stdout) fclose(GetVMStdout());
   }
 
+  void FileView::Release() {
+#ifndef _WIN32
+    if (mapped_) munmap(const_cast<char *>(data_), size_);
+#endif
+    data_ = nullptr;
+    size_ = 0;
+    mapped_ = false;
+    buffer_.clear();
+  }
+
+  bool FileView::Open(const string &path) {
+    Release();
+
+#ifndef _WIN32
+    int fd = open(path.data(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+      void *ptr = mmap(nullptr, static_cast<size_t>(info.st_size), 
+        PROT_READ, MAP_PRIVATE, fd, 0);
+
+      if (ptr != MAP_FAILED) {
+        data_ = static_cast<const char *>(ptr);
+        size_ = static_cast<size_t>(info.st_size);
+        mapped_ = true;
+        close(fd);
+        return true;
+      }
+    }
+
+    close(fd);
+#endif
+    FILE *fp = fopen(path.data(), "rb");
+    if (fp == nullptr) return false;
+
+    std::fseek(fp, 0, SEEK_END);
+    long length = std::ftell(fp);
+    std::fseek(fp, 0, SEEK_SET);
+
+    if (length > 0) {
+      buffer_.resize(static_cast<size_t>(length));
+      buffer_.resize(fread(&buffer_[0], 1, buffer_.size(), fp));
+    }
+
+    //Not a seekable file, read it by chunks
+    if (length < 0) {
+      char chunk[8192];
+      size_t count = 0;
+      while ((count = fread(chunk, 1, sizeof(chunk), fp)) > 0) buffer_.append(chunk, count);
+    }
+
+    bool good = ferror(fp) == 0;
+    fclose(fp);
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+    return good;
+  }
+
   string InStream::GetLine() {
     if (fp_ == nullptr || eof_) return string();
 
@@ -57,6 +123,13 @@ namespace kagami {
     return buf;
   }
 
+  size_t InStream::Read(void *dest, size_t size) {
+    if (fp_ == nullptr || eof_) return 0;
+    size_t count = fread(dest, 1, size, fp_);
+    if (count < size) eof_ = true;
+    return count;
+  }
+
   wchar_t InStreamW::Get() {
     auto buf = fgetwc(fp_);
     if (buf == WEOF) {
@@ -116,6 +189,11 @@ namespace kagami {
     return fputc(chr, fp_) != EOF;
   }
 
+  bool OutStream::Write(const void *src, size_t size) {
+    if (fp_ == nullptr) return false;
+    return fwrite(src, 1, size, fp_) == size;
+  }
+
   bool OutStreamW::Write(wstring str) {
     if (fp_ == nullptr) return false;
     auto it = str.begin();
@@ -3,6 +3,7 @@
 #include <cstdio>
 #include <cstdlib>
 #include <string>
+#include <string_view>
 #ifdef _MSC_VER
 #pragma warning(disable:4996)
 #endif
@@ -12,6 +13,7 @@ namespace kagami {
   using std::fopen;
   using std::string;
   using std::wstring;
+  using std::string_view;
   using std::fputc;
   using std::fputwc;
   using std::fgetc;
@@ -75,6 +77,8 @@ namespace kagami {
 
     string GetLine();
     char Get();
+    //Returns count of bytes actually read
+    size_t Read(void *dest, size_t size);
   };
 
   class InStreamW : public BasicStream {
@@ -96,6 +100,31 @@ namespace kagami {
     wchar_t Get();
   };
 
+  /*
+    Read-only view of whole file content.
+    File is mapped into memory if possible, otherwise it's loaded by one bulk read.
+  */
+  class FileView {
+  private:
+    const char *data_;
+    size_t size_;
+    bool mapped_;
+    string buffer_;
+
+    void Release();
+
+  public:
+    ~FileView() { Release(); }
+    FileView() : data_(nullptr), size_(0), mapped_(false), buffer_() {}
+    FileView(const FileView &) = delete;
+    FileView(const FileView &&) = delete;
+    void operator=(const FileView &) = delete;
+
+    bool Open(const string &path);
+    string_view Get() const { return string_view(data_, size_); }
+    bool IsMapped() const { return mapped_; }
+  };
+
   string _ProcessingOutStreamArgument(bool append, bool binary);
 
   class OutStream : public BasicStream {
@@ -116,6 +145,7 @@ namespace kagami {
 
     bool Write(string str);
     bool Write(char chr);
+    bool Write(const void *src, size_t size);
   };
 
   class OutStreamW : public BasicStream {
@@ -1,4 +1,5 @@
 #include "frontend.h"
+#include <cstring>
 
 #define ERROR_MSG(_Msg) Message(_Msg, kStateError)
 
@@ -36,7 +37,8 @@ namespace kagami {
       keyword == kKeywordCase ||
       keyword == kKeywordStruct ||
       keyword == kKeywordModule ||
-      keyword == kKeywordFor;
+      keyword == kKeywordFor ||
+      keyword == kKeywordForRange;
   }
 
   inline bool IsSingleKeyword(Keyword keyword) {
@@ -53,19 +55,21 @@ namespace kagami {
     return string();
   }
 
-  string IndentationAndCommentProc(string target) {
-    if (target == "") return "";
-    string data;
+  inline bool IsBlankChar(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+  }
+
+  string_view IndentationAndCommentProc(string_view target) {
+    if (target.empty()) return string_view();
+    string_view data;
     char current = 0, last = 0;
     size_t head = 0, tail = 0;
     bool exempt_blank_char = true;
     bool string_processing = false;
-    auto toString = [](char t) ->string {return string().append(1, t); };
 
     for (size_t count = 0; count < target.size(); ++count) {
       current = target[count];
-      auto type = lexical::GetStringType(toString(current));
-      if (type != StringType::kStringTypeBlank && exempt_blank_char) {
+      if (!IsBlankChar(current) && exempt_blank_char) {
         head = count;
         exempt_blank_char = false;
       }
@@ -80,114 +84,258 @@ namespace kagami {
     }
     if (tail > head) data = target.substr(head, tail - head);
     else data = target.substr(head, target.size() - head);
-    if (data.front() == '#') return "";
+    if (data.front() == '#') return string_view();
 
-    while (!data.empty() &&
-      lexical::GetStringType(toString(data.back())) == kStringTypeBlank) {
-      data.pop_back();
+    while (!data.empty() && IsBlankChar(data.back())) {
+      data.remove_suffix(1);
     }
     return data;
   }
 
-  void LexicalFactory::Scan(deque<string> &output, string target) {
-    string current_token, temp;
-    bool inside_string = false;
-    bool leave_string = false;
-    bool enter_string = false;
-    bool escape_flag = false;
-    bool not_escape_char = false;
-    char current = 0, next = 0, last = 0;
-
-    for (size_t idx = 0; idx < target.size(); idx += 1) {
-      current = target[idx];
+  /* Lexer states, token text is accepted while state is not rejected */
+  enum LexState {
+    kLexStart,
+    kLexBlank,
+    kLexIdentifier,
+    kLexInt,
+    kLexIntDot,
+    kLexFloat,
+    kLexPlus,
+    kLexMinus,
+    kLexGreater,
+    kLexLess,
+    kLexEquals,
+    kLexNot,
+    kLexAnd,
+    kLexOr,
+    kLexSymbol,
+    kLexString,
+    kLexStringEnd,
+    kLexUnknown,
+    kLexReject,
+    kLexStateCount = kLexReject
+  };
+
+  enum LexCharClass {
+    kLexCharOther,
+    kLexCharBlank,
+    kLexCharAlpha,
+    kLexCharDigit,
+    kLexCharUnderscore,
+    kLexCharQuote,
+    kLexCharDot,
+    kLexCharPlus,
+    kLexCharMinus,
+    kLexCharGreater,
+    kLexCharLess,
+    kLexCharEquals,
+    kLexCharNot,
+    kLexCharAnd,
+    kLexCharOr,
+    kLexCharSingle,
+    kLexCharClassCount
+  };
+
+  struct LexTable {
+    uint8_t char_class[256];
+    uint8_t transition[kLexStateCount][kLexCharClassCount];
+    StringType accept[kLexStateCount];
+  };
+
+  //Generated from GetStringType() rules, every accepting state is a valid token
+  //and sign prefix is always separated from number.
+  const LexTable &GetLexTable() {
+    static const LexTable table = [] {
+      LexTable result;
+
+      auto set_class = [&](const char *chars, LexCharClass char_class) {
+        for (; *chars != 0; ++chars) {
+          result.char_class[static_cast<unsigned char>(*chars)] = char_class;
+        }
+      };
 
-      (idx < target.size() - 1) ?
-        next = target[idx + 1] :
-        next = 0;
+      auto set_state = [&](LexState state, LexCharClass char_class, LexState next) {
+        result.transition[state][char_class] = static_cast<uint8_t>(next);
+      };
 
-      if (leave_string) {
-        inside_string = false;
-        leave_string = false;
+      for (auto &unit : result.char_class) unit = kLexCharOther;
+      for (char c = 'a'; c <= 'z'; ++c) result.char_class[static_cast<unsigned char>(c)] = kLexCharAlpha;
+      for (char c = 'A'; c <= 'Z'; ++c) result.char_class[static_cast<unsigned char>(c)] = kLexCharAlpha;
+      for (char c = '0'; c <= '9'; ++c) result.char_class[static_cast<unsigned char>(c)] = kLexCharDigit;
+      set_class(" \t\r\n", kLexCharBlank);
+      set_class("_", kLexCharUnderscore);
+      set_class("'", kLexCharQuote);
+      set_class(".", kLexCharDot);
+      set_class("+", kLexCharPlus);
+      set_class("-", kLexCharMinus);
+      set_class(">", kLexCharGreater);
+      set_class("<", kLexCharLess);
+      set_class("=", kLexCharEquals);
+      set_class("!", kLexCharNot);
+      set_class("&", kLexCharAnd);
+      set_class("|", kLexCharOr);
+      set_class("*/(){}[],;", kLexCharSingle);
+
+      for (auto &row : result.transition) {
+        for (auto &unit : row) unit = kLexReject;
       }
 
-      escape_flag = (inside_string && last == '\\' && !not_escape_char);
+      set_state(kLexStart, kLexCharOther, kLexUnknown);
+      set_state(kLexStart, kLexCharBlank, kLexBlank);
+      set_state(kLexStart, kLexCharAlpha, kLexIdentifier);
+      set_state(kLexStart, kLexCharDigit, kLexInt);
+      set_state(kLexStart, kLexCharUnderscore, kLexIdentifier);
+      set_state(kLexStart, kLexCharQuote, kLexString);
+      set_state(kLexStart, kLexCharDot, kLexSymbol);
+      set_state(kLexStart, kLexCharPlus, kLexPlus);
+      set_state(kLexStart, kLexCharMinus, kLexMinus);
+      set_state(kLexStart, kLexCharGreater, kLexGreater);
+      set_state(kLexStart, kLexCharLess, kLexLess);
+      set_state(kLexStart, kLexCharEquals, kLexEquals);
+      set_state(kLexStart, kLexCharNot, kLexNot);
+      set_state(kLexStart, kLexCharAnd, kLexAnd);
+      set_state(kLexStart, kLexCharOr, kLexOr);
+      set_state(kLexStart, kLexCharSingle, kLexSymbol);
+      set_state(kLexBlank, kLexCharBlank, kLexBlank);
+      set_state(kLexIdentifier, kLexCharAlpha, kLexIdentifier);
+      set_state(kLexIdentifier, kLexCharDigit, kLexIdentifier);
+      set_state(kLexIdentifier, kLexCharUnderscore, kLexIdentifier);
+      set_state(kLexInt, kLexCharDigit, kLexInt);
+      set_state(kLexInt, kLexCharDot, kLexIntDot);
+      set_state(kLexIntDot, kLexCharDigit, kLexFloat);
+      set_state(kLexFloat, kLexCharDigit, kLexFloat);
+      set_state(kLexPlus, kLexCharEquals, kLexSymbol);
+      set_state(kLexMinus, kLexCharEquals, kLexSymbol);
+      set_state(kLexMinus, kLexCharGreater, kLexSymbol);
+      set_state(kLexGreater, kLexCharEquals, kLexSymbol);
+      set_state(kLexLess, kLexCharEquals, kLexSymbol);
+      set_state(kLexLess, kLexCharMinus, kLexSymbol);
+      set_state(kLexEquals, kLexCharEquals, kLexSymbol);
+      set_state(kLexNot, kLexCharEquals, kLexSymbol);
+      set_state(kLexAnd, kLexCharAnd, kLexSymbol);
+      set_state(kLexOr, kLexCharOr, kLexSymbol);
+      set_state(kLexStringEnd, kLexCharQuote, kLexString);
+
+      for (auto &unit : result.accept) unit = kStringTypeSymbol;
+      result.accept[kLexStart] = kStringTypeNull;
+      result.accept[kLexBlank] = kStringTypeBlank;
+      result.accept[kLexIdentifier] = kStringTypeIdentifier;
+      result.accept[kLexInt] = kStringTypeInt;
+      result.accept[kLexIntDot] = kStringTypeNull;
+      result.accept[kLexFloat] = kStringTypeFloat;
+      result.accept[kLexString] = kStringTypeNull;
+      result.accept[kLexStringEnd] = kStringTypeLiteralStr;
+      result.accept[kLexUnknown] = kStringTypeNull;
+
+      return result;
+    }();
+
+    return table;
+  }
 
-      if (not_escape_char) not_escape_char = false;
+  inline bool IsAcceptingState(LexState state) {
+    return state != kLexIntDot && state != kLexString;
+  }
 
-      if (current == '\'' && !escape_flag) {
-        if (!inside_string && lexical::GetStringType(current_token) == kStringTypeBlank) {
-          current_token.clear();
-        }
+  void LexicalFactory::Scan(vector<Token> &output, string_view target) {
+    auto &table = GetLexTable();
+    size_t head = 0;
 
-        inside_string ?
-          leave_string = true :
-          inside_string = true, enter_string = true;
-      }
+    while (head < target.size()) {
+      LexState state = kLexStart, accept_state = kLexStart;
+      size_t pos = head, accept_pos = head;
+      bool modified = false;
 
-      if (!inside_string || enter_string) {
-        temp = current_token;
-        temp.append(1, current);
-
-        auto type = lexical::GetStringType(temp);
-        if (type == kStringTypeNull) {
-          auto type = lexical::GetStringType(current_token);
-          switch (type) {
-          case kStringTypeBlank:
-            current_token.clear();
-            current_token.append(1, current);
-            break;
-          case kStringTypeInt:
-            if (current == '.' && lexical::IsDigit(next)) {
-              current_token.append(1, current);
+      while (pos < target.size()) {
+        auto char_class = table.char_class[static_cast<unsigned char>(target[pos])];
+        auto next_state = static_cast<LexState>(table.transition[state][char_class]);
+
+        if (next_state == kLexReject) break;
+
+        state = next_state;
+        pos += 1;
+
+        if (state == kLexString) {
+          //Escape sequence is replaced in place, but the backslash is kept
+          //for GetRawString()
+          char current = 0, last = '\'';
+          bool escape_flag = false, not_escape_char = false;
+
+          if (modified) literal_.append(1, '\'');
+
+          for (; pos < target.size(); ++pos) {
+            current = target[pos];
+            escape_flag = (last == '\\' && !not_escape_char);
+            not_escape_char = false;
+
+            if (current == '\'' && !escape_flag) {
+              state = kLexStringEnd;
+              break;
             }
-            else {
-              output.emplace_back(current_token);
-              current_token.clear();
-              current_token.append(1, current);
+
+            if (escape_flag) current = lexical::GetEscapeChar(current);
+            if (current == '\\' && last == '\\') not_escape_char = true;
+
+            if (!modified && current != target[pos]) {
+              literal_.assign(target.substr(head, pos - head));
+              modified = true;
             }
-            break;
-          default:
-            output.emplace_back(current_token);
-            current_token.clear();
-            current_token.append(1, current);
+
+            if (modified) literal_.append(1, current);
+            last = target[pos];
+          }
+
+          //Unclosed string literal is taken until end of line
+          if (state == kLexString) {
+            accept_state = state;
+            accept_pos = pos;
             break;
           }
+
+          if (modified) literal_.append(1, '\'');
+          pos += 1;
         }
-        else {
-          if (type == kStringTypeInt && (temp[0] == '+' || temp[0] == '-')) {
-            output.emplace_back(string().append(1, temp[0]));
-            current_token = temp.substr(1, temp.size() - 1);
-          }
-          else {
-            current_token = temp;
-          }
+
+        if (IsAcceptingState(state)) {
+          accept_state = state;
+          accept_pos = pos;
         }
+      }
 
+      StringType type = table.accept[accept_state];
 
-        if (enter_string) enter_string = false;
+      if (type == kStringTypeBlank) {
+        head = accept_pos;
+        continue;
       }
-      else {
-        if (escape_flag) current = lexical::GetEscapeChar(current);
-        if (current == '\\' && last == '\\') not_escape_char = true;
-        current_token.append(1, current);
+
+      string data = modified ?
+        literal_ :
+        string(target.substr(head, accept_pos - head));
+
+      if (accept_state == kLexString) {
+        type = data.size() == 1 ? kStringTypeSymbol :
+          (data.back() == '\'' ? kStringTypeLiteralStr : kStringTypeNull);
       }
 
-      last = target[idx];
-    }
+      if (type == kStringTypeIdentifier) {
+        if (data == kStrTrue || data == kStrFalse) type = kStringTypeBool;
+        else if (data == "_") type = kStringTypeSymbol;
+      }
 
-    if (lexical::GetStringType(current_token) != kStringTypeBlank) {
-      output.emplace_back(current_token);
-    }
+      output.emplace_back(std::move(data), type);
 
+      head = accept_pos;
+    }
   }
 
   bool LexicalFactory::Feed(CombinedCodeline &src) {
     bool good = true;
     bool negative_flag = false;
     stack<string> bracket_stack;
-    deque<string> target;
+    vector<Token> target;
     Token current = INVALID_TOKEN;
-    Token next = INVALID_TOKEN;
+    StringType next_type = kStringTypeNull;
     Token last = INVALID_TOKEN;
 
     Scan(target, src.second);
@@ -197,22 +345,21 @@ namespace kagami {
     auto *tokens = &dest_->back().second;
 
     for (size_t idx = 0; idx < target.size(); idx += 1) {
-      current = Token(target[idx], lexical::GetStringType(target[idx]));
-      next = (idx < target.size() - 1) ?
-        Token(target[idx + 1], lexical::GetStringType(target[idx + 1])) :
-        INVALID_TOKEN;
+      current = std::move(target[idx]);
+      next_type = (idx < target.size() - 1) ?
+        target[idx + 1].second : kStringTypeNull;
 
       if (current.first == ";") {
         if (!bracket_stack.empty()) {
-          AppendMessage("Invalid end of statment at line " +
-            to_string(src.first), kStateError, logger_);
+          Report("Invalid end of statment at line " +
+            to_string(src.first), kStateError);
           good = false;
           break;
         }
 
         if (idx == target.size() - 1) {
-          AppendMessage("Unnecessary semicolon at line " +
-            to_string(src.first), kStateWarning, logger_);
+          Report("Unnecessary semicolon at line " +
+            to_string(src.first), kStateWarning);
         }
         else {
           dest_->emplace_back(CombinedToken(src.first, deque<Token>()));
@@ -223,15 +370,15 @@ namespace kagami {
       }
 
       if (current.second == kStringTypeNull) {
-        AppendMessage("Unknown token - " + current.first +
-          " at line " + to_string(src.first), kStateError, logger_);
+        Report("Unknown token - " + current.first +
+          " at line " + to_string(src.first), kStateError);
         good = false;
         break;
       }
 
       if (compare(current.first, "+", "-") && !compare(last.first, ")", "]", "}")) {
         if (compare(last.second, kStringTypeSymbol, kStringTypeNull) &&
-          compare(next.second, kStringTypeInt, kStringTypeFloat)) {
+          compare(next_type, kStringTypeInt, kStringTypeFloat)) {
           negative_flag = true;
           tokens->push_back(current);
           last = current;
@@ -245,15 +392,15 @@ namespace kagami {
 
       if (compare(current.first, ")", "]", "}")) {
         if (bracket_stack.empty()) {
-          AppendMessage("Left bracket is missing - " + current.first +
-            " at line " + to_string(src.first), kStateError, logger_);
+          Report("Left bracket is missing - " + current.first +
+            " at line " + to_string(src.first), kStateError);
           good = false;
           break;
         }
 
         if (GetLeftBracket(current.first) != bracket_stack.top()) {
-          AppendMessage("Left bracket is missing - " + current.first +
-            " at line " + to_string(src.first), kStateError, logger_);
+          Report("Left bracket is missing - " + current.first +
+            " at line " + to_string(src.first), kStateError);
           good = false;
           break;
         }
@@ -264,8 +411,7 @@ namespace kagami {
       if (current.first == ",") {
         if (last.second == kStringTypeSymbol &&
           !compare(last.first, "]", ")", "}", "'")) {
-          AppendMessage("Invalid comma at line " + to_string(src.first), kStateError,
-            logger_);
+          Report("Invalid comma at line " + to_string(src.first), kStateError);
           good = false;
           break;
         }
@@ -287,6 +433,15 @@ namespace kagami {
     return good;
   }
 
+  void LexicalFactory::Report(string msg, StateLevel level) {
+    if (logger_ != nullptr) {
+      AppendMessage(msg, level, logger_);
+    }
+    else {
+      reports_.emplace_back(Message(msg, level));
+    }
+  }
+
   void ParserFrame::Eat() {
     if (idx < tokens.size()) {
       last = current;
@@ -671,6 +826,18 @@ namespace kagami {
     frame_->args.emplace_back(Argument(
       frame_->current.first, kArgumentLiteral, kStringTypeIdentifier));
 
+    //for key, value in container
+    if (frame_->next.first == ",") {
+      frame_->Eat();
+
+      if (frame_->Eat(); lexical::GetStringType(frame_->current.first) != kStringTypeIdentifier) {
+        error_string_ = "Invalid identifier argument in for-each expression";
+        return false;
+      }
+
+      frame_->args.emplace_back(Argument(
+        frame_->current.first, kArgumentLiteral, kStringTypeIdentifier));
+    }
     
     if (frame_->Eat(); lexical::GetTerminatorCode(frame_->current.first) != kTerminatorIn) {
       error_string_ = "Invalid for-each expression";
@@ -766,8 +933,7 @@ namespace kagami {
         frame_->current.first, kArgumentObjectStack, kStringTypeIdentifier));
 
       if (!frame_->domain.IsPlaceholder() || frame_->seek_last_assert) {
-        frame_->args.back().option.domain = frame_->domain.GetData();
-        frame_->args.back().option.domain_type = frame_->domain.GetType();
+        frame_->args.back().SetDomain(frame_->domain.GetData(), frame_->domain.GetType());
 
         if (frame_->seek_last_assert) {
           frame_->args.back().option.use_last_assert = true;
@@ -917,16 +1083,24 @@ namespace kagami {
     return Parse().SetIndex(line.first);
   }
 
-  bool VMCodeFactory::ReadScript(list<CombinedCodeline> &dest) {
+  bool VMCodeFactory::ReadScript(vector<CombinedCodeline> &dest) {
     bool inside_comment_block = false;
     size_t idx = 1;
-    string buf;
-    InStream reader(path_);
+    string_view buf;
+    auto content = source_.Get();
+    const char *pos = content.data();
+    const char *end = content.data() + content.size();
+
+    dest.reserve(std::count(content.begin(), content.end(), '\n') + 1);
 
-    if (!reader.Good()) return false;
+    while (pos < end) {
+      auto *line_end = static_cast<const char *>(memchr(pos, '\n', end - pos));
+      if (line_end == nullptr) line_end = end;
+      buf = string_view(pos, line_end - pos);
+      pos = line_end + 1;
 
-    while (!reader.eof()) {
-      buf = reader.GetLine();
+      //Same as text mode reading on Windows
+      if (!buf.empty() && buf.back() == '\r') buf.remove_suffix(1);
 
       if (buf == kStrCommentBegin) {
         inside_comment_block = true;
@@ -954,167 +1128,331 @@ namespace kagami {
     return true;
   }
 
-  bool VMCodeFactory::Start() {
-    bool good = true;
-    LexicalFactory lexer(tokens_, logger_);
-    LineParser line_parser;
-    Message msg;
-    VMCode anchorage;
-    StateLevel level;
-    Keyword ast_root;
+  size_t frontend_threads = 1;
 
-    if (!ReadScript(script_)) return false;
+  void SetFrontendThreads(size_t count) {
+    frontend_threads = count;
+  }
+
+  //Lines handled by one worker at least, smaller scripts are compiled serially
+  constexpr size_t kMinLinesPerWorker = 2048;
+
+  inline size_t GetFrontendWorkerCount(size_t line_count) {
+    size_t count = frontend_threads;
 
-    for (auto it = script_.begin(); it != script_.end(); ++it) {
-      good = lexer.Feed(*it);
-      if (!good) break;
+    if (count == 0) {
+      count = std::thread::hardware_concurrency();
+      if (count == 0) count = 1;
     }
 
-    if (!good) return false;
+    return std::max(size_t(1), std::min(count, line_count / kMinLinesPerWorker));
+  }
 
-    for (auto it = tokens_.begin(); it != tokens_.end(); ++it) {
-      if (!good) break;
+  /*
+    'for x in range(start, stop, step)' is lowered into a counting loop.
+    Arguments of range() are moved into loop command, so no array is created
+    and loop variable is bound without calling any method. range() outside
+    of for-each expression is a built-in function which returns int_array.
+  */
+  void LowerRangeLoop(ParsedLine &line) {
+    auto &output = line.output;
 
-      msg = line_parser.Make(*it);
+    if (output.size() < 2) return;
 
-      level = msg.GetLevel();
-      ast_root = line_parser.GetASTRoot();
+    auto &loop = output.back();
+    auto &range = output[output.size() - 2];
+    auto &range_args = range.second;
 
-      if (level != kStateNormal) {
-        AppendMessage(msg.GetDetail(), level, logger_, msg.GetIndex());
-        if (level == kStateError) { good = false; continue; }
-      }
+    if (loop.second.size() != 2 ||
+      loop.second[1].GetType() != kArgumentReturnStack) return;
 
-      anchorage.swap(line_parser.GetOutput());
-      line_parser.Clear();
+    //Built-in functions can't be overridden by script
+    if (range.first.type != kRequestFunction ||
+      range.first.GetInterfaceId() != kStrRange ||
+      !range.first.GetInterfaceDomain().IsPlaceholder() ||
+      range.first.option.use_last_assert) return;
 
-      if (inside_struct_) {
-        if (ast_root == kKeywordFn) struct_member_fn_nest += 1;
+    if (range_args.size() < 2 || range_args.size() > 3) return;
 
-        if (struct_member_fn_nest == 0 && 
-          !compare(ast_root, kKeywordBind, kKeywordEnd, kKeywordInclude, kKeywordAttribute)) {
-          AppendMessage("Invalid expression inside struct", kStateError,
-            logger_, msg.GetIndex());
-          good = false;
-          break;
-        }
+    Command command{ Request(kKeywordForRange), ArgumentList() };
+    command.first.idx = loop.first.idx;
+    command.first.option = loop.first.option;
+    command.second.push_back(loop.second[0]);
+    command.second.insert(command.second.end(), range_args.begin(), range_args.end());
+
+    if (range_args.size() == 2) {
+      command.second.emplace_back(Argument("1", kArgumentLiteral, kStringTypeInt));
+    }
+
+    output.pop_back();
+    output.back() = std::move(command);
+    line.ast_root = kKeywordForRange;
+  }
+
+  //Doesn't touch any state of VMCodeFactory, so it's safe on worker threads
+  void ParseLine(LineParser &parser, CombinedToken &line, ParsedLine &dest) {
+    dest.index = line.first;
+    dest.msg = parser.Make(line);
+    dest.ast_root = parser.GetASTRoot();
+    dest.output.clear();
+
+    if (dest.msg.GetLevel() != kStateError) {
+      dest.output.swap(parser.GetOutput());
+      parser.Clear();
+      if (dest.ast_root == kKeywordFor) LowerRangeLoop(dest);
+    }
+  }
+
+  /* Contiguous part of script, lexed and parsed by one worker */
+  struct FrontendChunk {
+    vector<CombinedCodeline>::iterator begin;
+    vector<CombinedCodeline>::iterator end;
+    deque<CombinedToken> tokens;
+    deque<ParsedLine> lines;
+    deque<Message> reports;
+    bool good;
+  };
+
+  void ProcessChunk(FrontendChunk &chunk) {
+    LexicalFactory lexer(chunk.tokens, nullptr);
+    LineParser line_parser;
+
+    chunk.good = true;
+
+    for (auto it = chunk.begin; it != chunk.end; ++it) {
+      chunk.good = lexer.Feed(*it);
+      if (!chunk.good) break;
+    }
+
+    chunk.reports.swap(lexer.GetReports());
+
+    if (!chunk.good) return;
+
+    //Lines after error are not resolved, no need to parse them
+    for (auto &unit : chunk.tokens) {
+      auto &line = chunk.lines.emplace_back();
+      ParseLine(line_parser, unit, line);
+      if (line.msg.GetLevel() == kStateError) break;
+    }
+  }
+
+  //Returns false to stop processing rest lines
+  bool VMCodeFactory::ResolveLine(ParsedLine &line, bool &good, bool &message_reported) {
+    auto &msg = line.msg;
+    auto level = msg.GetLevel();
+    auto ast_root = line.ast_root;
+
+    if (level != kStateNormal) {
+      AppendMessage(msg.GetDetail(), level, logger_, msg.GetIndex());
+      message_reported = true;
+      if (level == kStateError) { good = false; return false; }
+    }
+
+    if (inside_struct_) {
+      if (ast_root == kKeywordFn) struct_member_fn_nest += 1;
+
+      if (struct_member_fn_nest == 0 && 
+        !compare(ast_root, kKeywordBind, kKeywordEnd, kKeywordInclude, kKeywordAttribute)) {
+        AppendMessage("Invalid expression inside struct", kStateError,
+          logger_, msg.GetIndex());
+        good = false;
+        return false;
       }
+    }
 
-      if (inside_module_) {
-        if (ast_root == kKeywordFn) struct_member_fn_nest += 1;
+    if (inside_module_) {
+      if (ast_root == kKeywordFn) struct_member_fn_nest += 1;
 
-        if (struct_member_fn_nest == 0 &&
-          !compare(ast_root, kKeywordBind, kKeywordEnd, kKeywordAttribute)) {
-          AppendMessage("Invalid expression inside struct", kStateError,
-            logger_, msg.GetIndex());
-          good = false;
-          break;
-        }
+      if (struct_member_fn_nest == 0 &&
+        !compare(ast_root, kKeywordBind, kKeywordEnd, kKeywordAttribute)) {
+        AppendMessage("Invalid expression inside struct", kStateError,
+          logger_, msg.GetIndex());
+        good = false;
+        return false;
       }
+    }
 
-      if (IsNestRoot(ast_root)) {
-        if (ast_root == kKeywordIf || ast_root == kKeywordCase) {
-          jump_stack_.push(JumpListFrame{ ast_root,
-            dest_->size() + anchorage.size() - 1 });
-        }
+    if (IsNestRoot(ast_root)) {
+      if (ast_root == kKeywordIf || ast_root == kKeywordCase) {
+        jump_stack_.push(JumpListFrame{ ast_root,
+          dest_->size() + line.output.size() - 1 });
+      }
 
-        if (ast_root == kKeywordWhile || ast_root == kKeywordFor) {
-          cycle_escaper_.push(nest_.size() + 1);
-        }
+      if (compare(ast_root, kKeywordWhile, kKeywordFor, kKeywordForRange)) {
+        cycle_escaper_.push(nest_.size() + 1);
+      }
 
-        if (ast_root == kKeywordStruct) {
-          inside_struct_ = true;
-        }
+      if (ast_root == kKeywordStruct) {
+        inside_struct_ = true;
+      }
 
-        if (ast_root == kKeywordModule) {
-          inside_module_ = true;
-        }
+      if (ast_root == kKeywordModule) {
+        inside_module_ = true;
+      }
 
-        nest_.push(dest_->size());
-        nest_end_.push(dest_->size() + anchorage.size() - 1);
-        nest_origin_.push(it->first);
-        nest_type_.push(ast_root);
-        dest_->insert(dest_->end(), anchorage.begin(), anchorage.end());
-        anchorage.clear();
-        continue;
+      nest_.push(dest_->size());
+      nest_end_.push(dest_->size() + line.output.size() - 1);
+      nest_origin_.push(line.index);
+      nest_type_.push(ast_root);
+      dest_->insert(dest_->end(), line.output.begin(), line.output.end());
+      line.output.clear();
+      return true;
+    }
+
+    if (IsBranchKeyword(ast_root)) {
+      if (jump_stack_.empty()) {
+        AppendMessage("Invalid branch keyword at line " + to_string(line.index), kStateError,
+          logger_);
+        message_reported = true;
+        return false;
       }
 
-      if (IsBranchKeyword(ast_root)) {
-        if (jump_stack_.empty()) {
-          AppendMessage("Invalid branch keyword at line " + to_string(it->first), kStateError,
+      if (jump_stack_.top().nest_code == kKeywordIf) {
+        if (ast_root == kKeywordElif || ast_root == kKeywordElse) {
+          jump_stack_.top().jump_record.push_back(dest_->size());
+        }
+        else {
+          AppendMessage("Invalid branch keyword at line " + to_string(line.index),
             logger_);
-          break;
+          message_reported = true;
+          return false;
         }
-
-        if (jump_stack_.top().nest_code == kKeywordIf) {
-          if (ast_root == kKeywordElif || ast_root == kKeywordElse) {
-            jump_stack_.top().jump_record.push_back(dest_->size());
-          }
-          else {
-            AppendMessage("Invalid branch keyword at line " + to_string(it->first),
-              logger_);
-            break;
-          }
+      }
+      else if (jump_stack_.top().nest_code == kKeywordCase) {
+        if (ast_root == kKeywordWhen || ast_root == kKeywordElse) {
+          jump_stack_.top().jump_record.push_back(dest_->size());
         }
-        else if (jump_stack_.top().nest_code == kKeywordCase) {
-          if (ast_root == kKeywordWhen || ast_root == kKeywordElse) {
-            jump_stack_.top().jump_record.push_back(dest_->size());
-          }
-          else {
-            AppendMessage("Invalid branch keyword at line " + to_string(it->first), kStateError,
-              logger_);
-            break;
-          }
+        else {
+          AppendMessage("Invalid branch keyword at line " + to_string(line.index), kStateError,
+            logger_);
+          message_reported = true;
+          return false;
         }
       }
+    }
 
-      if (ast_root == kKeywordContinue || ast_root == kKeywordBreak) {
-        if (cycle_escaper_.empty()) {
-          AppendMessage("Invalid cycle escaper at line " + to_string(it->first), kStateError,
-            logger_);
-          break;
-        }
+    if (ast_root == kKeywordContinue || ast_root == kKeywordBreak) {
+      if (cycle_escaper_.empty()) {
+        AppendMessage("Invalid cycle escaper at line " + to_string(line.index), kStateError,
+          logger_);
+        message_reported = true;
+        return false;
+      }
 
-        anchorage.back().first.option.escape_depth = nest_.size() - cycle_escaper_.top();
+      line.output.back().first.option.escape_depth = nest_.size() - cycle_escaper_.top();
+    }
+
+    if (ast_root == kKeywordEnd) {
+      if (nest_type_.empty()) {
+        AppendMessage("Invalid 'end' token at line " + to_string(line.index), kStateError, 
+          logger_, msg.GetIndex());
+        good = false;
+        return false;
       }
 
-      if (ast_root == kKeywordEnd) {
-        if (nest_type_.empty()) {
-          AppendMessage("Invalid 'end' token at line " + to_string(it->first), kStateError, 
-            logger_, msg.GetIndex());
-          good = false;
-          break;
+      if (!cycle_escaper_.empty() && nest_.size() == cycle_escaper_.top())
+        cycle_escaper_.pop();
+
+      (*dest_)[nest_end_.top()].first.option.nest_end = dest_->size();
+      line.output.back().first.option.nest_root = nest_type_.top();
+      line.output.back().first.option.nest = nest_.top();
+
+      if (compare(nest_type_.top(), kKeywordIf, kKeywordCase) && !jump_stack_.empty()){
+        if (!jump_stack_.top().jump_record.empty()) {
+          dest_->AddJumpRecord(jump_stack_.top().nest, jump_stack_.top().jump_record);
         }
+        jump_stack_.pop();
+      }
 
-        if (!cycle_escaper_.empty() && nest_.size() == cycle_escaper_.top())
-          cycle_escaper_.pop();
+      if (compare(nest_type_.top(), kKeywordFn) && (inside_struct_ || inside_module_)) {
+        struct_member_fn_nest -= 1;
+      }
 
-        (*dest_)[nest_end_.top()].first.option.nest_end = dest_->size();
-        anchorage.back().first.option.nest_root = nest_type_.top();
-        anchorage.back().first.option.nest = nest_.top();
+      if (compare(nest_type_.top(), kKeywordStruct)) inside_struct_ = false;
+      if (compare(nest_type_.top(), kKeywordModule)) inside_module_ = false;
 
-        if (compare(nest_type_.top(), kKeywordIf, kKeywordCase) && !jump_stack_.empty()){
-          if (!jump_stack_.top().jump_record.empty()) {
-            dest_->AddJumpRecord(jump_stack_.top().nest, jump_stack_.top().jump_record);
-          }
-          jump_stack_.pop();
+      nest_.pop();
+      nest_end_.pop();
+      nest_origin_.pop();
+      nest_type_.pop();
+    }
+
+    dest_->insert(dest_->end(), line.output.begin(), line.output.end());
+    line.output.clear();
+    return true;
+  }
+
+  bool VMCodeFactory::Start() {
+    bool good = true;
+    bool message_reported = false;
+    string cache_path = GetBytecodeCachePath(path_);
+
+    if (!source_.Open(path_)) return false;
+
+    uint64_t content_hash = HashScriptContent(source_.Get());
+
+    if (LoadBytecodeCache(cache_path, content_hash, *dest_)) return true;
+
+    if (!ReadScript(script_)) return false;
+
+    size_t worker_count = GetFrontendWorkerCount(script_.size());
+
+    if (worker_count > 1) {
+      //Lexing and parsing are done in parallel, nest resolution needs line order
+      vector<FrontendChunk> chunks(worker_count);
+      vector<std::thread> workers;
+      size_t chunk_size = script_.size() / worker_count;
+
+      for (size_t idx = 0; idx < worker_count; ++idx) {
+        auto &chunk = chunks[idx];
+        chunk.begin = script_.begin() + idx * chunk_size;
+        chunk.end = idx == worker_count - 1 ?
+          script_.end() : chunk.begin + chunk_size;
+      }
+
+      for (size_t idx = 1; idx < worker_count; ++idx) {
+        workers.emplace_back(ProcessChunk, std::ref(chunks[idx]));
+      }
+
+      ProcessChunk(chunks.front());
+
+      for (auto &unit : workers) unit.join();
+
+      for (auto &chunk : chunks) {
+        for (auto &unit : chunk.reports) {
+          AppendMessage(unit.GetDetail(), unit.GetLevel(), logger_);
         }
 
-        if (compare(nest_type_.top(), kKeywordFn) && (inside_struct_ || inside_module_)) {
-          struct_member_fn_nest -= 1;
+        if (!chunk.good) return false;
+      }
+
+      bool resolving = true;
+
+      for (auto &chunk : chunks) {
+        for (auto &line : chunk.lines) {
+          resolving = ResolveLine(line, good, message_reported);
+          if (!resolving) break;
         }
 
-        if (compare(nest_type_.top(), kKeywordStruct)) inside_struct_ = false;
-        if (compare(nest_type_.top(), kKeywordModule)) inside_module_ = false;
+        if (!resolving) break;
+      }
+    }
+    else {
+      LexicalFactory lexer(tokens_, logger_);
+      LineParser line_parser;
+      ParsedLine line;
 
-        nest_.pop();
-        nest_end_.pop();
-        nest_origin_.pop();
-        nest_type_.pop();
+      for (auto it = script_.begin(); it != script_.end(); ++it) {
+        good = lexer.Feed(*it);
+        if (!good) break;
       }
 
-      dest_->insert(dest_->end(), anchorage.begin(), anchorage.end());
-      anchorage.clear();
+      if (!good) return false;
+
+      for (auto it = tokens_.begin(); it != tokens_.end(); ++it) {
+        ParseLine(line_parser, *it, line);
+        if (!ResolveLine(line, good, message_reported)) break;
+      }
     }
 
     if (!nest_.empty()) {
@@ -1123,6 +1461,23 @@ namespace kagami {
       good = false;
     }
 
+    //Reported messages must appear again in next run, so this one is not cached
+    if (good && !message_reported) {
+      SaveBytecodeCache(cache_path, content_hash, *dest_);
+    }
+
     return good;
   }
+
+  bool VMCodeFactory::Optimize(bool imported) {
+    PassManager manager(GetOptimizationLevel(), imported);
+
+    if (!manager.Run(*dest_, path_, logger_)) return false;
+
+    if (IsVMCodeDumpEnabled()) {
+      printf("VMCode of %s:\n%s", path_.data(), DumpVMCode(*dest_).data());
+    }
+
+    return true;
+  }
 }
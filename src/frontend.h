@@ -1,21 +1,29 @@
 #pragma once
 #include "trace.h"
 #include "filestream.h"
+#include "bytecode.h"
+#include "optimizer.h"
 
 #define INVALID_TOKEN Token(string(), kStringTypeNull)
 
 namespace kagami {
-  using CombinedCodeline = pair<size_t, string>;
+  //Line content refers to the source buffer held by VMCodeFactory
+  using CombinedCodeline = pair<size_t, string_view>;
   using CombinedToken = pair<size_t, deque<Token>>;
 
+  //Messages are kept in GetReports() if logger is null
   class LexicalFactory {
   private:
     StandardLogger *logger_;
 
   private:
     deque<CombinedToken> *dest_;
+    deque<Message> reports_;
+    string literal_;
 
-    void Scan(deque<string> &output, string target);
+    //Tokens own their text, parser and VMCode outlive the source buffer
+    void Scan(vector<Token> &output, string_view target);
+    void Report(string msg, StateLevel level);
   public:
     LexicalFactory() = delete;
     LexicalFactory(deque<CombinedToken> &dest, StandardLogger *logger) : 
@@ -24,6 +32,7 @@ namespace kagami {
     bool Feed(CombinedCodeline &src);
 
     auto &GetOutput() { return dest_; }
+    auto &GetReports() { return reports_; }
   };
 
   struct ParserFrame {
@@ -107,6 +116,19 @@ namespace kagami {
     list<size_t> jump_record;
   };
 
+  /* Parser output of one line, waiting for nest resolution */
+  struct ParsedLine {
+    size_t index;
+    Message msg;
+    Keyword ast_root;
+    VMCode output;
+
+    ParsedLine() : index(0), msg(), ast_root(kKeywordNull), output() {}
+  };
+
+  //Worker threads for lexing and parsing, 1 = serial, 0 = hardware concurrency
+  void SetFrontendThreads(size_t count);
+
   class VMCodeFactory {
   private:
     VMCode *dest_;
@@ -120,7 +142,8 @@ namespace kagami {
     stack<size_t> cycle_escaper_;
     stack<Keyword> nest_type_;
     stack<JumpListFrame> jump_stack_;
-    list<CombinedCodeline> script_;
+    FileView source_;
+    vector<CombinedCodeline> script_;
     deque<CombinedToken> tokens_;
 
   private:
@@ -128,7 +151,8 @@ namespace kagami {
     bool is_logger_held_;
 
   private:
-    bool ReadScript(list<CombinedCodeline> &dest);
+    bool ReadScript(vector<CombinedCodeline> &dest);
+    bool ResolveLine(ParsedLine &line, bool &good, bool &message_reported);
 
   public:
     ~VMCodeFactory() { if (is_logger_held_) delete logger_; }
@@ -149,5 +173,8 @@ namespace kagami {
       logger_(logger), is_logger_held_(false) {}
     
     bool Start();
+    //Run passes of current optimization level on compiled VMCode.
+    //imported = VMCode is loaded by 'using'
+    bool Optimize(bool imported = false);
   };
 }
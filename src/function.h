@@ -37,11 +37,28 @@ namespace kagami {
   class VMCodeFunction : public _FunctionImpl {
   private:
     VMCode code_;
+    //Body in [begin_, end_) of source_ is copied on first use
+    VMCode *source_;
+    size_t begin_, end_;
+    std::once_flag copied_;
     
   public:
-    VMCodeFunction(VMCode ir) : code_(ir) {}
+    VMCodeFunction(VMCode ir) : code_(std::move(ir)), source_(nullptr), begin_(0), end_(0) {}
 
-    VMCode &GetCode() { return code_; }
+    VMCodeFunction(VMCode &source, size_t begin, size_t end) :
+      code_(&source), source_(&source), begin_(begin), end_(end) {}
+
+    VMCode &GetCode() {
+      if (source_ != nullptr) {
+        std::call_once(copied_, [this]() {
+          for (size_t idx = begin_; idx < end_; ++idx) {
+            code_.push_back((*source_)[idx]);
+          }
+        });
+      }
+
+      return code_;
+    }
   };
 
   class ExternalFunction : public _FunctionImpl {
@@ -105,7 +122,26 @@ namespace kagami {
       vector<string> params,
       ParameterPattern argument_mode = kParamFixed
     ) :
-      impl_(new VMCodeFunction(ir)),
+      impl_(new VMCodeFunction(std::move(ir))),
+      record_(),
+      mode_(argument_mode),
+      type_(kFunctionVMCode),
+      limit_(0),
+      offset_(offset),
+      id_(id),
+      params_(params) {}
+
+    //Body in [offset, end) of source is copied on first call,
+    //source must live longer than this function
+    FunctionImpl(
+      size_t offset,
+      VMCode &source,
+      size_t end,
+      string id,
+      vector<string> params,
+      ParameterPattern argument_mode = kParamFixed
+    ) :
+      impl_(new VMCodeFunction(source, offset, end)),
       record_(),
       mode_(argument_mode),
       type_(kFunctionVMCode),
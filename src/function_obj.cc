@@ -34,11 +34,19 @@ namespace kagami {
     return Message().SetObject(result);
   }
 
+  //Closure record is counted here, captured objects are counted by their types
+  size_t FunctionSizer(shared_ptr<void> ptr) {
+    auto &impl = *static_pointer_cast<FunctionImpl>(ptr);
+    size_t record_size = sizeof(NamedObject) + 2 * sizeof(void *);
+    return sizeof(FunctionImpl) + impl.GetClosureRecord().size() * record_size;
+  }
+
   void InitFunctionType() {
     using namespace management::type;
 
     ObjectTraitsSetup(kTypeIdFunction, PlainDeliveryImpl<FunctionImpl>)
       .InitComparator(PlainComparator<FunctionImpl>)
+      .InitSizer(FunctionSizer)
       .InitMethods(
         {
           FunctionImpl(FunctionGetId, "", "id"),
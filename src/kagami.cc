@@ -14,7 +14,7 @@ void BootMainVMObject(string path, string log_path, bool real_time_log) {
 
   {
     VMCodeFactory factory(path, script_file, log_path, real_time_log);
-    if (!factory.Start()) return;
+    if (!factory.Start() || !factory.Optimize()) return;
   }
   
   Machine main_thread(script_file, log_path, real_time_log);
@@ -40,6 +40,13 @@ void HelpFile() {
     "\tvm_stdout=FILE      Redirection of script standard output.\n"
     "\tvm_stdin=FILE       Redirection of script standard input.\n"
     "\trtlog               Enable real-time logger\n"
+    "\tmemory_stats=MS     Enable allocation accounting, dump to log every MS milliseconds.\n"
+    "\t                    (0 = dump at exit only)\n"
+    "\tfrontend_threads=N  Lex and parse script with N threads.\n"
+    "\t                    (0 = hardware concurrency, default = 1)\n"
+    "\tO0|O1|O2|O3         Optimization level of VMCode.(default=O2)\n"
+    "\tdump_vmcode         Print VMCode after optimization passes.\n"
+    "\tverbose             Write pass statistics and timing to log.\n"
     "\twait                Automatically pause at application exit.\n"
     "\thelp                Show this message.\n"
     "\tversion             Show version message of interpreter.\n"
@@ -82,6 +89,23 @@ void Processing(Processor &processor) {
     setlocale(LC_ALL, processor.Exist("locale") ?
       processor.ValueOf("locale").data() : "en_US.UTF8");
 
+    if (processor.Exist("memory_stats")) {
+      string interval = processor.ValueOf("memory_stats");
+      accounting::EnableAccounting(strtoll(interval.data(), nullptr, 10));
+    }
+
+    if (processor.Exist("frontend_threads")) {
+      string count = processor.ValueOf("frontend_threads");
+      SetFrontendThreads(strtoull(count.data(), nullptr, 10));
+    }
+
+    for (size_t level = 0; level <= kMaxOptimizationLevel; ++level) {
+      if (processor.Exist("O" + to_string(level))) SetOptimizationLevel(level);
+    }
+
+    SetVMCodeDump(processor.Exist("dump_vmcode"));
+    SetOptimizerVerbose(processor.Exist("verbose"));
+
     runtime::InformScriptPath(path);
     BootMainVMObject(path, log, processor.Exist("rtlog"));
     CloseStream();
@@ -112,6 +136,8 @@ void InitFromConfigFile() {
     auto locale = toml::expect<string>(startup, "locale");
     auto vm_stdin = toml::expect<string>(startup, "vm_stdin");
     auto vm_stdout = toml::expect<string>(startup, "vm_stdout");
+    auto optimization_level = toml::expect<int64_t>(startup, "optimization_level");
+    auto dump_vmcode = toml::expect<bool>(startup, "dump_vmcode");
 
     if (vm_stdout.is_ok()) {
       if (log == vm_stdout.unwrap()) {
@@ -132,6 +158,13 @@ void InitFromConfigFile() {
 
     setlocale(LC_ALL, locale.is_ok() ? locale.unwrap().data() : "en_US.UTF8");
 
+    if (optimization_level.is_ok()) {
+      SetOptimizationLevel(static_cast<size_t>(
+        std::max(int64_t(0), optimization_level.unwrap())));
+    }
+
+    SetVMCodeDump(dump_vmcode.is_ok() ? dump_vmcode.unwrap() : false);
+
     runtime::InformScriptPath(script);
     BootMainVMObject(script, log, real_time_log.is_ok() ?
       real_time_log.unwrap() : false);
@@ -178,7 +211,15 @@ int main(int argc, char **argv) {
     Pattern("log"    , Option(true, true)),
     Pattern("locale" , Option(true, true)),
     Pattern("vm_stdout" ,Option(true, true)),
-    Pattern("vm_stdin"  ,Option(true, true))
+    Pattern("vm_stdin"  ,Option(true, true)),
+    Pattern("memory_stats", Option(true, true)),
+    Pattern("frontend_threads", Option(true, true)),
+    Pattern("O0"     , Option(false, true, 2)),
+    Pattern("O1"     , Option(false, true, 2)),
+    Pattern("O2"     , Option(false, true, 2)),
+    Pattern("O3"     , Option(false, true, 2)),
+    Pattern("dump_vmcode", Option(false, true)),
+    Pattern("verbose", Option(false, true))
   };
 
   if (argc <= 1) {
@@ -0,0 +1,905 @@
+#include "kernels.h"
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define KERNEL_AVX2_AVAILABLE
+#define KERNEL_AVX2 __attribute__((target("avx2")))
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define KERNEL_SSE2_AVAILABLE
+#endif
+
+namespace kagami::kernel {
+  bool UseAVX2() {
+#if defined(KERNEL_AVX2_AVAILABLE)
+    static const bool result = __builtin_cpu_supports("avx2") != 0;
+    return result;
+#else
+    return false;
+#endif
+  }
+
+  /* Operand access for array/scalar right hand side */
+  template <typename T>
+  inline T At(const T *src, size_t idx) { return src[idx]; }
+  template <typename T>
+  inline T At(T value, size_t) { return value; }
+
+  //Signed integer overflow wraps around like packed adds on every path.
+  //Division overflow(INT64_MIN / -1) must be rejected by caller
+  template <ArithmeticOp op, typename T>
+  inline T Calculate(T lhs, T rhs) {
+    if constexpr (std::is_signed_v<T> && std::is_integral_v<T> && op != kArithmeticDiv) {
+      using Unsigned = std::make_unsigned_t<T>;
+      return static_cast<T>(Calculate<op>(static_cast<Unsigned>(lhs), static_cast<Unsigned>(rhs)));
+    }
+    else if constexpr (op == kArithmeticAdd) return lhs + rhs;
+    else if constexpr (op == kArithmeticSub) return lhs - rhs;
+    else if constexpr (op == kArithmeticMul) return lhs * rhs;
+    else return lhs / rhs;
+  }
+
+  template <CompareOp op, typename T>
+  inline bool Match(T lhs, T rhs) {
+    if constexpr (op == kCompareEqual) return lhs == rhs;
+    else if constexpr (op == kCompareNotEqual) return lhs != rhs;
+    else if constexpr (op == kCompareLess) return lhs < rhs;
+    else if constexpr (op == kCompareLessOrEqual) return lhs <= rhs;
+    else if constexpr (op == kCompareGreater) return lhs > rhs;
+    else return lhs >= rhs;
+  }
+
+  /* Scalar implementations, also used for remaining tail elements */
+  template <typename T>
+  T ScalarSum(const T *src, size_t size) {
+    T result = T();
+    for (size_t idx = 0; idx < size; ++idx) {
+      result = Calculate<kArithmeticAdd>(result, src[idx]);
+    }
+    return result;
+  }
+
+  template <typename T>
+  T ScalarDot(const T *lhs, const T *rhs, size_t size) {
+    T result = T();
+    for (size_t idx = 0; idx < size; ++idx) {
+      result = Calculate<kArithmeticAdd>(result, Calculate<kArithmeticMul>(lhs[idx], rhs[idx]));
+    }
+    return result;
+  }
+
+  //NaN is propagated by min/max on every path, regardless of its position
+  template <typename T>
+  T ScalarMin(const T *src, size_t size, T init) {
+    T result = init;
+    for (size_t idx = 0; idx < size; ++idx) {
+      if constexpr (std::is_floating_point_v<T>) {
+        if (std::isnan(src[idx])) return src[idx];
+      }
+      if (src[idx] < result) result = src[idx];
+    }
+    return result;
+  }
+
+  template <typename T>
+  T ScalarMax(const T *src, size_t size, T init) {
+    T result = init;
+    for (size_t idx = 0; idx < size; ++idx) {
+      if constexpr (std::is_floating_point_v<T>) {
+        if (std::isnan(src[idx])) return src[idx];
+      }
+      if (src[idx] > result) result = src[idx];
+    }
+    return result;
+  }
+
+  template <ArithmeticOp op, typename T, typename Rhs>
+  void ScalarArithmetic(const T *lhs, Rhs rhs, T *dest, size_t begin, size_t size) {
+    for (size_t idx = begin; idx < size; ++idx) {
+      dest[idx] = Calculate<op>(lhs[idx], At(rhs, idx));
+    }
+  }
+
+  template <CompareOp op, typename T>
+  size_t ScalarCountIf(const T *src, T value, size_t size) {
+    size_t result = 0;
+    for (size_t idx = 0; idx < size; ++idx) {
+      if (Match<op>(src[idx], value)) ++result;
+    }
+    return result;
+  }
+
+#if defined(KERNEL_SSE2_AVAILABLE)
+  /* SSE2 implementations */
+  inline __m128d LoadSSE2(const double *src, size_t idx) { return _mm_loadu_pd(src + idx); }
+  inline __m128d LoadSSE2(double value, size_t) { return _mm_set1_pd(value); }
+  inline __m128i LoadSSE2(const int64_t *src, size_t idx) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + idx));
+  }
+  inline __m128i LoadSSE2(int64_t value, size_t) {
+    return _mm_set1_epi64x(value);
+  }
+
+  double SumSSE2(const double *src, size_t size) {
+    __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+    size_t idx = 0;
+    for (; idx + 4 <= size; idx += 4) {
+      acc0 = _mm_add_pd(acc0, _mm_loadu_pd(src + idx));
+      acc1 = _mm_add_pd(acc1, _mm_loadu_pd(src + idx + 2));
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, _mm_add_pd(acc0, acc1));
+    return lanes[0] + lanes[1] + ScalarSum(src + idx, size - idx);
+  }
+
+  int64_t SumSSE2(const int64_t *src, size_t size) {
+    __m128i acc = _mm_setzero_si128();
+    size_t idx = 0;
+    for (; idx + 2 <= size; idx += 2) {
+      acc = _mm_add_epi64(acc, LoadSSE2(src, idx));
+    }
+    int64_t lanes[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), acc);
+    return Calculate<kArithmeticAdd>(ScalarSum(lanes, 2), ScalarSum(src + idx, size - idx));
+  }
+
+  double DotSSE2(const double *lhs, const double *rhs, size_t size) {
+    __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+    size_t idx = 0;
+    for (; idx + 4 <= size; idx += 4) {
+      acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(lhs + idx), _mm_loadu_pd(rhs + idx)));
+      acc1 = _mm_add_pd(acc1,
+        _mm_mul_pd(_mm_loadu_pd(lhs + idx + 2), _mm_loadu_pd(rhs + idx + 2)));
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, _mm_add_pd(acc0, acc1));
+    return lanes[0] + lanes[1] + ScalarDot(lhs + idx, rhs + idx, size - idx);
+  }
+
+  template <bool is_min>
+  double MinMaxSSE2(const double *src, size_t size) {
+    __m128d acc = _mm_set1_pd(src[0]), unordered = _mm_setzero_pd();
+    size_t idx = 0;
+    for (; idx + 2 <= size; idx += 2) {
+      __m128d value = _mm_loadu_pd(src + idx);
+      unordered = _mm_or_pd(unordered, _mm_cmpunord_pd(value, value));
+      acc = is_min ? _mm_min_pd(acc, value) : _mm_max_pd(acc, value);
+    }
+    if (_mm_movemask_pd(unordered) != 0) return std::numeric_limits<double>::quiet_NaN();
+    double lanes[2];
+    _mm_storeu_pd(lanes, acc);
+    return is_min ?
+      ScalarMin(src + idx, size - idx, lanes[0] < lanes[1] ? lanes[0] : lanes[1]) :
+      ScalarMax(src + idx, size - idx, lanes[0] > lanes[1] ? lanes[0] : lanes[1]);
+  }
+
+  template <ArithmeticOp op, typename Rhs>
+  void ArithmeticSSE2(const double *lhs, Rhs rhs, double *dest, size_t size) {
+    size_t idx = 0;
+    for (; idx + 2 <= size; idx += 2) {
+      __m128d a = _mm_loadu_pd(lhs + idx), b = LoadSSE2(rhs, idx), r;
+      if constexpr (op == kArithmeticAdd) r = _mm_add_pd(a, b);
+      else if constexpr (op == kArithmeticSub) r = _mm_sub_pd(a, b);
+      else if constexpr (op == kArithmeticMul) r = _mm_mul_pd(a, b);
+      else r = _mm_div_pd(a, b);
+      _mm_storeu_pd(dest + idx, r);
+    }
+    ScalarArithmetic<op>(lhs, rhs, dest, idx, size);
+  }
+
+  template <ArithmeticOp op, typename Rhs>
+  void ArithmeticSSE2(const int64_t *lhs, Rhs rhs, int64_t *dest, size_t size) {
+    size_t idx = 0;
+    //No packed 64-bit multiply/divide before AVX-512
+    if constexpr (op == kArithmeticAdd || op == kArithmeticSub) {
+      for (; idx + 2 <= size; idx += 2) {
+        __m128i a = LoadSSE2(lhs, idx), b = LoadSSE2(rhs, idx);
+        __m128i r = op == kArithmeticAdd ? _mm_add_epi64(a, b) : _mm_sub_epi64(a, b);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + idx), r);
+      }
+    }
+    ScalarArithmetic<op>(lhs, rhs, dest, idx, size);
+  }
+
+  template <CompareOp op>
+  size_t CountIfSSE2(const double *src, double value, size_t size) {
+    __m128d target = _mm_set1_pd(value);
+    size_t result = 0, idx = 0;
+    for (; idx + 2 <= size; idx += 2) {
+      __m128d a = _mm_loadu_pd(src + idx), mask;
+      if constexpr (op == kCompareEqual) mask = _mm_cmpeq_pd(a, target);
+      else if constexpr (op == kCompareNotEqual) mask = _mm_cmpneq_pd(a, target);
+      else if constexpr (op == kCompareLess) mask = _mm_cmplt_pd(a, target);
+      else if constexpr (op == kCompareLessOrEqual) mask = _mm_cmple_pd(a, target);
+      else if constexpr (op == kCompareGreater) mask = _mm_cmpgt_pd(a, target);
+      else mask = _mm_cmpge_pd(a, target);
+      int bits = _mm_movemask_pd(mask);
+      result += (bits & 1) + ((bits >> 1) & 1);
+    }
+    return result + ScalarCountIf<op>(src + idx, value, size - idx);
+  }
+#endif
+
+#if defined(KERNEL_AVX2_AVAILABLE)
+  /* AVX2 implementations */
+  KERNEL_AVX2 inline __m256d LoadAVX2(const double *src, size_t idx) {
+    return _mm256_loadu_pd(src + idx);
+  }
+  KERNEL_AVX2 inline __m256d LoadAVX2(double value, size_t) {
+    return _mm256_set1_pd(value);
+  }
+  KERNEL_AVX2 inline __m256i LoadAVX2(const int64_t *src, size_t idx) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + idx));
+  }
+  KERNEL_AVX2 inline __m256i LoadAVX2(int64_t value, size_t) {
+    return _mm256_set1_epi64x(value);
+  }
+
+  KERNEL_AVX2 double SumAVX2(const double *src, size_t size) {
+    __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+    size_t idx = 0;
+    for (; idx + 8 <= size; idx += 8) {
+      acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(src + idx));
+      acc1 = _mm256_add_pd(acc1, _mm256_loadu_pd(src + idx + 4));
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_add_pd(acc0, acc1));
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) +
+      ScalarSum(src + idx, size - idx);
+  }
+
+  KERNEL_AVX2 int64_t SumAVX2(const int64_t *src, size_t size) {
+    __m256i acc = _mm256_setzero_si256();
+    size_t idx = 0;
+    for (; idx + 4 <= size; idx += 4) {
+      acc = _mm256_add_epi64(acc, LoadAVX2(src, idx));
+    }
+    int64_t lanes[4];
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(lanes), acc);
+    return Calculate<kArithmeticAdd>(ScalarSum(lanes, 4), ScalarSum(src + idx, size - idx));
+  }
+
+  KERNEL_AVX2 double DotAVX2(const double *lhs, const double *rhs, size_t size) {
+    __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+    size_t idx = 0;
+    for (; idx + 8 <= size; idx += 8) {
+      acc0 = _mm256_add_pd(acc0,
+        _mm256_mul_pd(_mm256_loadu_pd(lhs + idx), _mm256_loadu_pd(rhs + idx)));
+      acc1 = _mm256_add_pd(acc1,
+        _mm256_mul_pd(_mm256_loadu_pd(lhs + idx + 4), _mm256_loadu_pd(rhs + idx + 4)));
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_add_pd(acc0, acc1));
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) +
+      ScalarDot(lhs + idx, rhs + idx, size - idx);
+  }
+
+  template <bool is_min>
+  KERNEL_AVX2 double MinMaxAVX2(const double *src, size_t size) {
+    __m256d acc = _mm256_set1_pd(src[0]), unordered = _mm256_setzero_pd();
+    size_t idx = 0;
+    for (; idx + 4 <= size; idx += 4) {
+      __m256d value = _mm256_loadu_pd(src + idx);
+      unordered = _mm256_or_pd(unordered, _mm256_cmp_pd(value, value, _CMP_UNORD_Q));
+      acc = is_min ? _mm256_min_pd(acc, value) : _mm256_max_pd(acc, value);
+    }
+    if (_mm256_movemask_pd(unordered) != 0) return std::numeric_limits<double>::quiet_NaN();
+    double lanes[4];
+    _mm256_storeu_pd(lanes, acc);
+    return is_min ?
+      ScalarMin(src + idx, size - idx, ScalarMin(lanes, 4, lanes[0])) :
+      ScalarMax(src + idx, size - idx, ScalarMax(lanes, 4, lanes[0]));
+  }
+
+  template <ArithmeticOp op, typename Rhs>
+  KERNEL_AVX2 void ArithmeticAVX2(const double *lhs, Rhs rhs, double *dest, size_t size) {
+    size_t idx = 0;
+    for (; idx + 4 <= size; idx += 4) {
+      __m256d a = _mm256_loadu_pd(lhs + idx), b = LoadAVX2(rhs, idx), r;
+      if constexpr (op == kArithmeticAdd) r = _mm256_add_pd(a, b);
+      else if constexpr (op == kArithmeticSub) r = _mm256_sub_pd(a, b);
+      else if constexpr (op == kArithmeticMul) r = _mm256_mul_pd(a, b);
+      else r = _mm256_div_pd(a, b);
+      _mm256_storeu_pd(dest + idx, r);
+    }
+    ScalarArithmetic<op>(lhs, rhs, dest, idx, size);
+  }
+
+  template <ArithmeticOp op, typename Rhs>
+  KERNEL_AVX2 void ArithmeticAVX2(const int64_t *lhs, Rhs rhs, int64_t *dest, size_t size) {
+    size_t idx = 0;
+    if constexpr (op == kArithmeticAdd || op == kArithmeticSub) {
+      for (; idx + 4 <= size; idx += 4) {
+        __m256i a = LoadAVX2(lhs, idx), b = LoadAVX2(rhs, idx);
+        __m256i r = op == kArithmeticAdd ?
+          _mm256_add_epi64(a, b) : _mm256_sub_epi64(a, b);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dest + idx), r);
+      }
+    }
+    ScalarArithmetic<op>(lhs, rhs, dest, idx, size);
+  }
+
+  template <CompareOp op>
+  KERNEL_AVX2 size_t CountIfAVX2(const double *src, double value, size_t size) {
+    __m256d target = _mm256_set1_pd(value);
+    size_t result = 0, idx = 0;
+    for (; idx + 4 <= size; idx += 4) {
+      __m256d a = _mm256_loadu_pd(src + idx), mask;
+      if constexpr (op == kCompareEqual) mask = _mm256_cmp_pd(a, target, _CMP_EQ_OQ);
+      else if constexpr (op == kCompareNotEqual) mask = _mm256_cmp_pd(a, target, _CMP_NEQ_UQ);
+      else if constexpr (op == kCompareLess) mask = _mm256_cmp_pd(a, target, _CMP_LT_OQ);
+      else if constexpr (op == kCompareLessOrEqual) mask = _mm256_cmp_pd(a, target, _CMP_LE_OQ);
+      else if constexpr (op == kCompareGreater) mask = _mm256_cmp_pd(a, target, _CMP_GT_OQ);
+      else mask = _mm256_cmp_pd(a, target, _CMP_GE_OQ);
+      result += __builtin_popcount(_mm256_movemask_pd(mask));
+    }
+    return result + ScalarCountIf<op>(src + idx, value, size - idx);
+  }
+
+  template <CompareOp op>
+  KERNEL_AVX2 size_t CountIfAVX2(const int64_t *src, int64_t value, size_t size) {
+    __m256i target = _mm256_set1_epi64x(value);
+    size_t result = 0, idx = 0;
+    for (; idx + 4 <= size; idx += 4) {
+      __m256i a = LoadAVX2(src, idx), mask;
+      //AVX2 only provides == and >, others are derived from them
+      if constexpr (op == kCompareEqual || op == kCompareNotEqual) {
+        mask = _mm256_cmpeq_epi64(a, target);
+      }
+      else if constexpr (op == kCompareGreater || op == kCompareLessOrEqual) {
+        mask = _mm256_cmpgt_epi64(a, target);
+      }
+      else {
+        mask = _mm256_cmpgt_epi64(target, a);
+      }
+      int bits = __builtin_popcount(_mm256_movemask_pd(_mm256_castsi256_pd(mask)));
+      if constexpr (op == kCompareNotEqual || op == kCompareLessOrEqual
+        || op == kCompareGreaterOrEqual) {
+        bits = 4 - bits;
+      }
+      result += bits;
+    }
+    return result + ScalarCountIf<op>(src + idx, value, size - idx);
+  }
+#endif
+
+#if defined(KERNEL_AVX2_AVAILABLE)
+#define TRY_AVX2(_Call) if (UseAVX2()) return _Call;
+#else
+#define TRY_AVX2(_Call)
+#endif
+
+#if defined(KERNEL_SSE2_AVAILABLE)
+#define TRY_SSE2(_Call) return _Call;
+#else
+#define TRY_SSE2(_Call)
+#endif
+
+  int64_t Sum(const int64_t *src, size_t size) {
+    TRY_AVX2(SumAVX2(src, size));
+    TRY_SSE2(SumSSE2(src, size));
+    return ScalarSum(src, size);
+  }
+
+  double Sum(const double *src, size_t size) {
+    TRY_AVX2(SumAVX2(src, size));
+    TRY_SSE2(SumSSE2(src, size));
+    return ScalarSum(src, size);
+  }
+
+  //Packed 64-bit integer min/max needs AVX-512, leave it to compiler
+  int64_t Min(const int64_t *src, size_t size) {
+    return ScalarMin(src, size, src[0]);
+  }
+
+  double Min(const double *src, size_t size) {
+    TRY_AVX2(MinMaxAVX2<true>(src, size));
+    TRY_SSE2(MinMaxSSE2<true>(src, size));
+    return ScalarMin(src, size, src[0]);
+  }
+
+  int64_t Max(const int64_t *src, size_t size) {
+    return ScalarMax(src, size, src[0]);
+  }
+
+  double Max(const double *src, size_t size) {
+    TRY_AVX2(MinMaxAVX2<false>(src, size));
+    TRY_SSE2(MinMaxSSE2<false>(src, size));
+    return ScalarMax(src, size, src[0]);
+  }
+
+  int64_t Dot(const int64_t *lhs, const int64_t *rhs, size_t size) {
+    return ScalarDot(lhs, rhs, size);
+  }
+
+  double Dot(const double *lhs, const double *rhs, size_t size) {
+    TRY_AVX2(DotAVX2(lhs, rhs, size));
+    TRY_SSE2(DotSSE2(lhs, rhs, size));
+    return ScalarDot(lhs, rhs, size);
+  }
+
+  template <ArithmeticOp op, typename T, typename Rhs>
+  void ArithmeticImpl(const T *lhs, Rhs rhs, T *dest, size_t size) {
+    TRY_AVX2(ArithmeticAVX2<op>(lhs, rhs, dest, size));
+    TRY_SSE2(ArithmeticSSE2<op>(lhs, rhs, dest, size));
+    ScalarArithmetic<op>(lhs, rhs, dest, 0, size);
+  }
+
+  template <typename T, typename Rhs>
+  void ArithmeticDispatch(ArithmeticOp op, const T *lhs, Rhs rhs, T *dest, size_t size) {
+    switch (op) {
+    case kArithmeticAdd:ArithmeticImpl<kArithmeticAdd>(lhs, rhs, dest, size); break;
+    case kArithmeticSub:ArithmeticImpl<kArithmeticSub>(lhs, rhs, dest, size); break;
+    case kArithmeticMul:ArithmeticImpl<kArithmeticMul>(lhs, rhs, dest, size); break;
+    case kArithmeticDiv:ArithmeticImpl<kArithmeticDiv>(lhs, rhs, dest, size); break;
+    default:break;
+    }
+  }
+
+  void Arithmetic(ArithmeticOp op, const int64_t *lhs, const int64_t *rhs,
+    int64_t *dest, size_t size) {
+    ArithmeticDispatch(op, lhs, rhs, dest, size);
+  }
+
+  void Arithmetic(ArithmeticOp op, const double *lhs, const double *rhs,
+    double *dest, size_t size) {
+    ArithmeticDispatch(op, lhs, rhs, dest, size);
+  }
+
+  void Arithmetic(ArithmeticOp op, const int64_t *lhs, int64_t rhs,
+    int64_t *dest, size_t size) {
+    ArithmeticDispatch(op, lhs, rhs, dest, size);
+  }
+
+  void Arithmetic(ArithmeticOp op, const double *lhs, double rhs,
+    double *dest, size_t size) {
+    ArithmeticDispatch(op, lhs, rhs, dest, size);
+  }
+
+  template <CompareOp op>
+  size_t CountIfImpl(const int64_t *src, int64_t value, size_t size) {
+    TRY_AVX2(CountIfAVX2<op>(src, value, size));
+    return ScalarCountIf<op>(src, value, size);
+  }
+
+  template <CompareOp op>
+  size_t CountIfImpl(const double *src, double value, size_t size) {
+    TRY_AVX2(CountIfAVX2<op>(src, value, size));
+    TRY_SSE2(CountIfSSE2<op>(src, value, size));
+    return ScalarCountIf<op>(src, value, size);
+  }
+
+  template <typename T>
+  size_t CountIfDispatch(CompareOp op, const T *src, T value, size_t size) {
+    size_t result = 0;
+
+    switch (op) {
+    case kCompareEqual:
+      result = CountIfImpl<kCompareEqual>(src, value, size); break;
+    case kCompareNotEqual:
+      result = CountIfImpl<kCompareNotEqual>(src, value, size); break;
+    case kCompareLess:
+      result = CountIfImpl<kCompareLess>(src, value, size); break;
+    case kCompareLessOrEqual:
+      result = CountIfImpl<kCompareLessOrEqual>(src, value, size); break;
+    case kCompareGreater:
+      result = CountIfImpl<kCompareGreater>(src, value, size); break;
+    case kCompareGreaterOrEqual:
+      result = CountIfImpl<kCompareGreaterOrEqual>(src, value, size); break;
+    default:break;
+    }
+
+    return result;
+  }
+
+  size_t CountIf(CompareOp op, const int64_t *src, int64_t value, size_t size) {
+    return CountIfDispatch(op, src, value, size);
+  }
+
+  size_t CountIf(CompareOp op, const double *src, double value, size_t size) {
+    return CountIfDispatch(op, src, value, size);
+  }
+
+  /*
+    Substring search compares first and last byte of target with a whole
+    block of source at once, and only candidates matching both bytes are
+    checked with memcmp.
+  */
+  constexpr size_t kNotFound = string_view::npos;
+
+  inline size_t ScalarFindLastChar(const char *src, size_t size, char value) {
+    for (size_t idx = size; idx > 0; --idx) {
+      if (src[idx - 1] == value) return idx - 1;
+    }
+    return kNotFound;
+  }
+
+  inline size_t ScalarFindString(const char *src, size_t size, const char *target,
+    size_t length, size_t begin) {
+    return string_view(src, size).find(string_view(target, length), begin);
+  }
+
+  //bits must not be zero
+  inline int HighestBit(uint32_t bits) {
+#if defined(__GNUC__)
+    return 31 - __builtin_clz(bits);
+#else
+    int result = 31;
+    while ((bits & (uint32_t(1) << result)) == 0) --result;
+    return result;
+#endif
+  }
+
+  inline int LowestBit(uint32_t bits) {
+#if defined(__GNUC__)
+    return __builtin_ctz(bits);
+#else
+    int result = 0;
+    while ((bits & (uint32_t(1) << result)) == 0) ++result;
+    return result;
+#endif
+  }
+
+  inline int PopCount(uint32_t bits) {
+#if defined(__GNUC__)
+    return __builtin_popcount(bits);
+#else
+    int result = 0;
+    for (; bits != 0; bits &= bits - 1) ++result;
+    return result;
+#endif
+  }
+
+#if defined(KERNEL_SSE2_AVAILABLE)
+  size_t FindLastCharSSE2(const char *src, size_t size, char value) {
+    __m128i target = _mm_set1_epi8(value);
+    size_t idx = size;
+    for (; idx >= 16; idx -= 16) {
+      __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + idx - 16));
+      uint32_t bits = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, target)));
+      if (bits != 0) return idx - 16 + HighestBit(bits);
+    }
+    return ScalarFindLastChar(src, idx, value);
+  }
+
+  size_t FindStringSSE2(const char *src, size_t size, const char *target, size_t length) {
+    __m128i first = _mm_set1_epi8(target[0]);
+    __m128i last = _mm_set1_epi8(target[length - 1]);
+    size_t idx = 0;
+    for (; idx + length - 1 + 16 <= size; idx += 16) {
+      __m128i block_first = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + idx));
+      __m128i block_last = _mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(src + idx + length - 1));
+      uint32_t bits = static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(
+        _mm_cmpeq_epi8(block_first, first), _mm_cmpeq_epi8(block_last, last))));
+      while (bits != 0) {
+        int offset = LowestBit(bits);
+        if (memcmp(src + idx + offset + 1, target + 1, length - 2) == 0) {
+          return idx + offset;
+        }
+        bits &= bits - 1;
+      }
+    }
+    return ScalarFindString(src, size, target, length, idx);
+  }
+#endif
+
+#if defined(KERNEL_AVX2_AVAILABLE)
+  KERNEL_AVX2 size_t FindStringAVX2(const char *src, size_t size, const char *target,
+    size_t length) {
+    __m256i first = _mm256_set1_epi8(target[0]);
+    __m256i last = _mm256_set1_epi8(target[length - 1]);
+    size_t idx = 0;
+    for (; idx + length - 1 + 32 <= size; idx += 32) {
+      __m256i block_first = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + idx));
+      __m256i block_last = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i *>(src + idx + length - 1));
+      uint32_t bits = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(
+        _mm256_cmpeq_epi8(block_first, first), _mm256_cmpeq_epi8(block_last, last))));
+      while (bits != 0) {
+        int offset = LowestBit(bits);
+        if (memcmp(src + idx + offset + 1, target + 1, length - 2) == 0) {
+          return idx + offset;
+        }
+        bits &= bits - 1;
+      }
+    }
+    return ScalarFindString(src, size, target, length, idx);
+  }
+#endif
+
+  //memchr is vectorized by C runtime already
+  size_t FindChar(const char *src, size_t size, char value) {
+    auto *result = static_cast<const char *>(memchr(src, value, size));
+    return result == nullptr ? kNotFound : size_t(result - src);
+  }
+
+  size_t FindLastChar(const char *src, size_t size, char value) {
+    TRY_SSE2(FindLastCharSSE2(src, size, value));
+    return ScalarFindLastChar(src, size, value);
+  }
+
+  size_t FindString(const char *src, size_t size, const char *target, size_t length) {
+    if (length == 0) return 0;
+    if (length > size) return kNotFound;
+    if (length == 1) return FindChar(src, size, target[0]);
+    TRY_AVX2(FindStringAVX2(src, size, target, length));
+    TRY_SSE2(FindStringSSE2(src, size, target, length));
+    return ScalarFindString(src, size, target, length, 0);
+  }
+
+  size_t FindLastString(const char *src, size_t size, const char *target, size_t length) {
+    if (length == 1) return FindLastChar(src, size, target[0]);
+    return string_view(src, size).rfind(string_view(target, length));
+  }
+
+  /*
+    UTF-8 kernels. Text is usually dominated by ASCII runs, those runs are
+    detected with byte sign mask of a whole block and copied/widened at once.
+    Multi-byte sequences are decoded one by one.
+  */
+  inline size_t ScalarASCIIPrefix(const char *src, size_t size) {
+    size_t idx = 0;
+    while (idx < size && static_cast<uint8_t>(src[idx]) < 0x80) ++idx;
+    return idx;
+  }
+
+  //Continuation bytes are 0x80-0xBF, which are -128 to -65 as signed char
+  inline size_t ScalarCountCodePoints(const char *src, size_t size) {
+    size_t result = 0;
+    for (size_t idx = 0; idx < size; ++idx) {
+      if (static_cast<signed char>(src[idx]) > -65) ++result;
+    }
+    return result;
+  }
+
+  template <typename Unit>
+  inline void ScalarWiden(const char *src, size_t size, Unit *dest) {
+    for (size_t idx = 0; idx < size; ++idx) {
+      dest[idx] = static_cast<Unit>(static_cast<uint8_t>(src[idx]));
+    }
+  }
+
+  //Returns length of sequence, or zero if sequence is malformed
+  inline size_t DecodeSequence(const char *src, size_t size, uint32_t &code) {
+    auto *bytes = reinterpret_cast<const uint8_t *>(src);
+    uint8_t lead = bytes[0];
+    size_t length;
+    uint32_t min;
+
+    if (lead < 0x80) { code = lead; return 1; }
+    else if ((lead & 0xE0) == 0xC0) { length = 2; code = lead & 0x1F; min = 0x80; }
+    else if ((lead & 0xF0) == 0xE0) { length = 3; code = lead & 0x0F; min = 0x800; }
+    else if ((lead & 0xF8) == 0xF0) { length = 4; code = lead & 0x07; min = 0x10000; }
+    else return 0;
+
+    if (length > size) return 0;
+
+    for (size_t idx = 1; idx < length; ++idx) {
+      if ((bytes[idx] & 0xC0) != 0x80) return 0;
+      code = (code << 6) | (bytes[idx] & 0x3F);
+    }
+
+    //Overlong form, surrogate and out of range code point
+    if (code < min || code > 0x10FFFF || (code >= 0xD800 && code <= 0xDFFF)) return 0;
+    return length;
+  }
+
+#if defined(KERNEL_SSE2_AVAILABLE)
+  size_t ASCIIPrefixSSE2(const char *src, size_t size) {
+    size_t idx = 0;
+    for (; idx + 16 <= size; idx += 16) {
+      __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + idx));
+      uint32_t bits = static_cast<uint32_t>(_mm_movemask_epi8(block));
+      if (bits != 0) return idx + LowestBit(bits);
+    }
+    return idx + ScalarASCIIPrefix(src + idx, size - idx);
+  }
+
+  size_t CountCodePointsSSE2(const char *src, size_t size) {
+    __m128i bound = _mm_set1_epi8(-65);
+    size_t result = 0;
+    size_t idx = 0;
+    for (; idx + 16 <= size; idx += 16) {
+      __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + idx));
+      result += PopCount(static_cast<uint32_t>(
+        _mm_movemask_epi8(_mm_cmpgt_epi8(block, bound))));
+    }
+    return result + ScalarCountCodePoints(src + idx, size - idx);
+  }
+
+  //Zero extension of bytes, source must be ASCII
+  void WidenSSE2(const char *src, size_t size, wchar_t *dest) {
+    __m128i zero = _mm_setzero_si128();
+    size_t idx = 0;
+    for (; idx + 16 <= size; idx += 16) {
+      __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + idx));
+      __m128i low = _mm_unpacklo_epi8(block, zero);
+      __m128i high = _mm_unpackhi_epi8(block, zero);
+      auto *output = reinterpret_cast<__m128i *>(dest + idx);
+      if constexpr (sizeof(wchar_t) == 2) {
+        _mm_storeu_si128(output, low);
+        _mm_storeu_si128(output + 1, high);
+      }
+      else {
+        _mm_storeu_si128(output, _mm_unpacklo_epi16(low, zero));
+        _mm_storeu_si128(output + 1, _mm_unpackhi_epi16(low, zero));
+        _mm_storeu_si128(output + 2, _mm_unpacklo_epi16(high, zero));
+        _mm_storeu_si128(output + 3, _mm_unpackhi_epi16(high, zero));
+      }
+    }
+    ScalarWiden(src + idx, size - idx, dest + idx);
+  }
+#endif
+
+#if defined(KERNEL_AVX2_AVAILABLE)
+  KERNEL_AVX2 size_t ASCIIPrefixAVX2(const char *src, size_t size) {
+    size_t idx = 0;
+    for (; idx + 32 <= size; idx += 32) {
+      __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + idx));
+      uint32_t bits = static_cast<uint32_t>(_mm256_movemask_epi8(block));
+      if (bits != 0) return idx + LowestBit(bits);
+    }
+    return idx + ScalarASCIIPrefix(src + idx, size - idx);
+  }
+
+  KERNEL_AVX2 size_t CountCodePointsAVX2(const char *src, size_t size) {
+    __m256i bound = _mm256_set1_epi8(-65);
+    size_t result = 0;
+    size_t idx = 0;
+    for (; idx + 32 <= size; idx += 32) {
+      __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + idx));
+      result += PopCount(static_cast<uint32_t>(
+        _mm256_movemask_epi8(_mm256_cmpgt_epi8(block, bound))));
+    }
+    return result + ScalarCountCodePoints(src + idx, size - idx);
+  }
+#endif
+
+  size_t ASCIIPrefix(const char *src, size_t size) {
+    TRY_AVX2(ASCIIPrefixAVX2(src, size));
+    TRY_SSE2(ASCIIPrefixSSE2(src, size));
+    return ScalarASCIIPrefix(src, size);
+  }
+
+  size_t CountCodePoints(const char *src, size_t size) {
+    TRY_AVX2(CountCodePointsAVX2(src, size));
+    TRY_SSE2(CountCodePointsSSE2(src, size));
+    return ScalarCountCodePoints(src, size);
+  }
+
+  inline void Widen(const char *src, size_t size, wchar_t *dest) {
+#if defined(KERNEL_SSE2_AVAILABLE)
+    WidenSSE2(src, size, dest);
+#else
+    ScalarWiden(src, size, dest);
+#endif
+  }
+
+  bool ValidateUTF8(const char *src, size_t size) {
+    size_t idx = 0;
+    uint32_t code;
+
+    while (idx < size) {
+      if (static_cast<uint8_t>(src[idx]) < 0x80) {
+        idx += ASCIIPrefix(src + idx, size - idx);
+        continue;
+      }
+
+      size_t length = DecodeSequence(src + idx, size - idx, code);
+      if (length == 0) return false;
+      idx += length;
+    }
+
+    return true;
+  }
+
+  size_t DecodeUTF8(const char *src, size_t size, wchar_t *dest) {
+    size_t idx = 0;
+    size_t count = 0;
+    uint32_t code;
+
+    while (idx < size) {
+      if (static_cast<uint8_t>(src[idx]) < 0x80) {
+        size_t length = ASCIIPrefix(src + idx, size - idx);
+        Widen(src + idx, length, dest + count);
+        idx += length;
+        count += length;
+        continue;
+      }
+
+      size_t length = DecodeSequence(src + idx, size - idx, code);
+      if (length == 0) break;
+      idx += length;
+
+      if (sizeof(wchar_t) == 2 && code >= 0x10000) {
+        code -= 0x10000;
+        dest[count++] = static_cast<wchar_t>(0xD800 + (code >> 10));
+        dest[count++] = static_cast<wchar_t>(0xDC00 + (code & 0x3FF));
+      }
+      else {
+        dest[count++] = static_cast<wchar_t>(code);
+      }
+    }
+
+    return count;
+  }
+
+  void EncodeUTF8(const wchar_t *src, size_t size, string &dest) {
+    dest.reserve(dest.size() + size);
+
+    for (size_t idx = 0; idx < size; ++idx) {
+      auto code = static_cast<uint32_t>(src[idx]);
+
+      if (code < 0x80) {
+        dest.push_back(static_cast<char>(code));
+        continue;
+      }
+
+      //Surrogate pair of UTF-16 wchar_t
+      if (sizeof(wchar_t) == 2 && code >= 0xD800 && code <= 0xDBFF && idx + 1 < size) {
+        auto low = static_cast<uint32_t>(src[idx + 1]);
+        if (low >= 0xDC00 && low <= 0xDFFF) {
+          code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+          ++idx;
+        }
+      }
+
+      if ((code >= 0xD800 && code <= 0xDFFF) || code > 0x10FFFF) code = 0xFFFD;
+
+      if (code < 0x800) {
+        dest.push_back(static_cast<char>(0xC0 | (code >> 6)));
+      }
+      else if (code < 0x10000) {
+        dest.push_back(static_cast<char>(0xE0 | (code >> 12)));
+        dest.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+      }
+      else {
+        dest.push_back(static_cast<char>(0xF0 | (code >> 18)));
+        dest.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+        dest.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+      }
+      dest.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    }
+  }
+
+#undef TRY_AVX2
+#undef TRY_SSE2
+
+  //Prefix sum is a serial dependency chain, scalar loop is kept on purpose
+  template <typename T>
+  void PrefixSumImpl(const T *src, T *dest, size_t size) {
+    T acc = T();
+    for (size_t idx = 0; idx < size; ++idx) {
+      acc = Calculate<kArithmeticAdd>(acc, src[idx]);
+      dest[idx] = acc;
+    }
+  }
+
+  void PrefixSum(const int64_t *src, int64_t *dest, size_t size) {
+    PrefixSumImpl(src, dest, size);
+  }
+
+  void PrefixSum(const double *src, double *dest, size_t size) {
+    PrefixSumImpl(src, dest, size);
+  }
+
+  template <typename T>
+  void IotaImpl(T start, T step, T *dest, size_t size) {
+    for (size_t idx = 0; idx < size; ++idx) {
+      dest[idx] = Calculate<kArithmeticAdd>(start,
+        Calculate<kArithmeticMul>(static_cast<T>(idx), step));
+    }
+  }
+
+  void Iota(int64_t start, int64_t step, int64_t *dest, size_t size) {
+    IotaImpl(start, step, dest, size);
+  }
+
+  void Iota(double start, double step, double *dest, size_t size) {
+    IotaImpl(start, step, dest, size);
+  }
+}
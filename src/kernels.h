@@ -0,0 +1,74 @@
+#pragma once
+#include "common.h"
+/*
+  Bulk kernels for packed numeric arrays and byte strings.
+  SSE2 is the baseline on x86 targets, AVX2 is selected at runtime when
+  the processor supports it. Other targets use the scalar implementation.
+*/
+namespace kagami::kernel {
+  enum ArithmeticOp {
+    kArithmeticAdd,
+    kArithmeticSub,
+    kArithmeticMul,
+    kArithmeticDiv
+  };
+
+  enum CompareOp {
+    kCompareEqual,
+    kCompareNotEqual,
+    kCompareLess,
+    kCompareLessOrEqual,
+    kCompareGreater,
+    kCompareGreaterOrEqual
+  };
+
+  bool UseAVX2();
+
+  int64_t Sum(const int64_t *src, size_t size);
+  double Sum(const double *src, size_t size);
+
+  //size must be greater than zero
+  int64_t Min(const int64_t *src, size_t size);
+  double Min(const double *src, size_t size);
+  int64_t Max(const int64_t *src, size_t size);
+  double Max(const double *src, size_t size);
+
+  int64_t Dot(const int64_t *lhs, const int64_t *rhs, size_t size);
+  double Dot(const double *lhs, const double *rhs, size_t size);
+
+  //Integer overflow wraps around in every kernel.
+  //Integer division by zero must be rejected by caller
+  void Arithmetic(ArithmeticOp op, const int64_t *lhs, const int64_t *rhs,
+    int64_t *dest, size_t size);
+  void Arithmetic(ArithmeticOp op, const double *lhs, const double *rhs,
+    double *dest, size_t size);
+  void Arithmetic(ArithmeticOp op, const int64_t *lhs, int64_t rhs,
+    int64_t *dest, size_t size);
+  void Arithmetic(ArithmeticOp op, const double *lhs, double rhs,
+    double *dest, size_t size);
+
+  size_t CountIf(CompareOp op, const int64_t *src, int64_t value, size_t size);
+  size_t CountIf(CompareOp op, const double *src, double value, size_t size);
+
+  void PrefixSum(const int64_t *src, int64_t *dest, size_t size);
+  void PrefixSum(const double *src, double *dest, size_t size);
+  //dest[idx] = start + idx * step
+  void Iota(int64_t start, int64_t step, int64_t *dest, size_t size);
+  void Iota(double start, double step, double *dest, size_t size);
+
+  //Byte string search, returns string_view::npos if nothing is found
+  size_t FindChar(const char *src, size_t size, char value);
+  size_t FindLastChar(const char *src, size_t size, char value);
+  size_t FindString(const char *src, size_t size, const char *target, size_t length);
+  size_t FindLastString(const char *src, size_t size, const char *target, size_t length);
+
+  //UTF-8 text
+  size_t ASCIIPrefix(const char *src, size_t size);
+  bool ValidateUTF8(const char *src, size_t size);
+  //Following functions expect valid UTF-8 source
+  size_t CountCodePoints(const char *src, size_t size);
+  //dest must hold at least size units, returns count of written units
+  size_t DecodeUTF8(const char *src, size_t size, wchar_t *dest);
+  //Unpaired surrogates and invalid code points are written as U+FFFD
+  void EncodeUTF8(const wchar_t *src, size_t size, string &dest);
+}
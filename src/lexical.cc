@@ -1,9 +1,17 @@
 #include "lexical.h"
+#include "kernels.h"
 
 namespace kagami {
+  //ASCII text is converted without locale dependent multibyte functions
   wstring s2ws(const string &s) {
     if (s.empty()) return wstring();
     size_t length = s.size();
+    if (kernel::ASCIIPrefix(s.data(), length) == length) {
+      wstring result(length, L'\0');
+      kernel::DecodeUTF8(s.data(), length, result.data());
+      return result;
+    }
+
     //wchar_t *wc = (wchar_t *)malloc(sizeof(wchar_t) * (length + 2));
     wchar_t *wc = (wchar_t *)calloc(length + 64, sizeof(wchar_t));
     auto res = mbstowcs(wc, s.data(), s.length() + 1);
@@ -15,6 +23,9 @@ namespace kagami {
   string ws2s(const wstring &s) {
     if (s.empty()) return string();
     size_t length = s.size();
+    if (std::all_of(s.begin(), s.end(), [](wchar_t unit) { return unit >= 0 && unit < 0x80; })) {
+      return string(s.begin(), s.end());
+    }
     //char *c = (char *)malloc(sizeof(char) * (length + 1) * 2);
     char *c = (char *)calloc((length + 64) * 2, sizeof(char));
     auto res = wcstombs(c, s.data(), (length + 64) * 2);
@@ -210,6 +221,31 @@ namespace kagami::lexical {
     return kKeywordNull;
   }
 
+  string GetKeywordName(Keyword token) {
+    using T = pair<Keyword, string>;
+    static unordered_map<Keyword, string> names = [] {
+      //Commands without source keyword
+      unordered_map<Keyword, string> result = {
+        T(kKeywordUsing              ,kStrUsing),
+        T(kKeywordExt                ,kStrExt),
+        T(kKeywordExpList            ,"!exp_list"),
+        T(kKeywordBind               ,"!bind"),
+        T(kKeywordDelivering         ,"!delivering"),
+        T(kKeywordInitialArray       ,"!initial_array"),
+        T(kKeywordForRange           ,"!for_range"),
+        T(kKeywordDomainAssertCommand,"!domain_assert"),
+        T(kKeywordNull               ,"!null")
+      };
+
+      for (auto &unit : GetKeywordBase()) result.emplace(unit.second, unit.first);
+      return result;
+    }();
+
+    auto it = names.find(token);
+    if (it != names.end()) return it->second;
+    return "!keyword_" + to_string(token);
+  }
+
   bool IsString(string target) {
     if (target.empty()) return false;
     if (target.size() == 1) return false;
@@ -87,6 +87,7 @@ namespace kagami {
     kKeywordOptionalParamRange,
     kKeywordIsSameCopy,
     kKeywordAttribute,
+    kKeywordForRange,
     kKeywordNull
   };
 
@@ -144,6 +145,7 @@ namespace kagami {
     kStrCommentEnd     = "=end",
     kStrFor            = "for",
     kStrIn             = "in",
+    kStrRange          = "range",
     kStrElse           = "else",
     kStrElif           = "elif",
     kStrWhile          = "while",
@@ -222,6 +224,7 @@ namespace kagami::lexical {
   bool IsOperator(Keyword token);
   int GetTokenPriority(Keyword token);
   Keyword GetKeywordCode(string src);
+  string GetKeywordName(Keyword token);
   string GetRawString(string target);
   bool IsString(string target);
   bool IsIdentifier(string target);
@@ -1,4 +1,5 @@
 #include "machine.h"
+#include "containers.h"
 
 #define EXPECTED_COUNT(_Count) (args.size() == _Count)
 
@@ -248,12 +249,6 @@ namespace kagami {
     disable_step = true;
   }
 
-  void RuntimeFrame::AddJumpRecord(size_t target_idx) {
-    if (jump_stack.empty() || jump_stack.top() != target_idx) {
-      jump_stack.push(target_idx);
-    }
-  }
-
   void RuntimeFrame::MakeError(string str) {
     error = true;
     msg_string = str;
@@ -904,13 +899,20 @@ namespace kagami {
     return result;
   }
 
-  Object *Machine::FetchLiteralObject(Argument &arg) {
+  Object *Machine::FetchLiteralObject(const Argument &arg) {
     using namespace mgmt;
-    auto value = arg.GetData();
+    auto &value = arg.GetData();
 
-    auto *ptr = GetConstantObject(value);
+    if (auto *cached = arg.GetConstant(); cached != nullptr) return cached;
 
-    if (ptr != nullptr) return ptr;
+    //Identifier may be the name of a built-in constant
+    auto *ptr = arg.GetSymbol() != kSymbolNull ?
+      GetConstantObject(arg.GetSymbol()) : nullptr;
+
+    if (ptr != nullptr) {
+      arg.SetConstant(ptr);
+      return ptr;
+    }
 
     auto type = arg.GetStringType();
     if (type == kStringTypeInt) {
@@ -945,10 +947,11 @@ namespace kagami {
       }
     }
 
+    arg.SetConstant(ptr);
     return ptr;
   }
 
-  Object Machine::FetchFunctionObject(string id) {
+  Object Machine::FetchFunctionObject(SymbolId id) {
     Object obj;
     auto &frame = frame_stack_.top();
     auto ptr = FindFunction(id);
@@ -961,7 +964,7 @@ namespace kagami {
     return obj;
   }
 
-  Object Machine::FetchObject(Argument &arg) {
+  Object Machine::FetchObject(const Argument &arg) {
     if (arg.GetType() == kArgumentLiteral) {
       auto obj = *FetchLiteralObject(arg);
       return obj.SetDeliveringFlag();
@@ -986,7 +989,7 @@ namespace kagami {
       if (!arg.option.domain.empty() || arg.option.use_last_assert) {
         if (arg.option.use_last_assert) {
           auto &base = frame.assert_rc_copy.Cast<ObjectStruct>();
-          ptr = base.Find(arg.GetData());
+          ptr = base.Find(arg.GetSymbol());
 
           if (ptr != nullptr) {
             if (!ptr->IsAlive()) OBJECT_DEAD_MSG;
@@ -997,7 +1000,7 @@ namespace kagami {
           if (arg.option.assert_chain_tail) frame.assert_rc_copy = Object();
         }
         else if (arg.option.domain_type == kArgumentObjectStack) {
-          ptr = obj_stack_.Find(arg.GetData(), arg.option.domain);
+          ptr = obj_stack_.Find(arg.GetSymbol(), arg.option.domain_symbol);
 
           if (ptr != nullptr) {
             if (!ptr->IsAlive()) OBJECT_DEAD_MSG;
@@ -1009,7 +1012,7 @@ namespace kagami {
           auto &sub_container = return_stack.back()->IsObjectView() ?
             dynamic_cast<ObjectView *>(return_stack.back())->Seek().Cast<ObjectStruct>() :
             dynamic_cast<ObjectPointer>(return_stack.back())->Cast<ObjectStruct>();
-          ptr = sub_container.Find(arg.GetData());
+          ptr = sub_container.Find(arg.GetSymbol());
           //keep object alive
           if (ptr != nullptr) {
             if (!ptr->IsAlive()) OBJECT_DEAD_MSG;
@@ -1021,18 +1024,18 @@ namespace kagami {
         }
       }
       else {
-        if (ptr = obj_stack_.Find(arg.GetData()); ptr != nullptr) {
+        if (ptr = obj_stack_.Find(arg.GetSymbol()); ptr != nullptr) {
           if (!ptr->IsAlive()) OBJECT_DEAD_MSG;
           obj.PackObject(*ptr);
           return obj;
         }
 
-        if (ptr = GetConstantObject(arg.GetData()); ptr != nullptr) {
+        if (ptr = GetConstantObject(arg.GetSymbol()); ptr != nullptr) {
           obj.PackObject(*ptr);
           return obj;
         }
 
-        obj = FetchFunctionObject(arg.GetData());
+        obj = FetchFunctionObject(arg.GetSymbol());
 
         if (obj.Null()) {
           frame.MakeError("Object is not found: " + arg.GetData());
@@ -1058,7 +1061,7 @@ namespace kagami {
     return obj;
   }
 
-  ObjectView Machine::FetchObjectView(Argument &arg) {
+  ObjectView Machine::FetchObjectView(const Argument &arg) {
 #define OBJECT_DEAD_MSG {                           \
       frame.MakeError("Referenced object is dead"); \
       return ObjectView();                          \
@@ -1082,7 +1085,7 @@ namespace kagami {
       if (!arg.option.domain.empty() || arg.option.use_last_assert) {
         if (arg.option.use_last_assert) {
           auto &base = frame.assert_rc_copy.Cast<ObjectStruct>();
-          ptr = base.Find(arg.GetData());
+          ptr = base.Find(arg.GetSymbol());
 
           if (ptr != nullptr) {
             if (!ptr->IsAlive()) OBJECT_DEAD_MSG;
@@ -1093,7 +1096,7 @@ namespace kagami {
           if (arg.option.assert_chain_tail) frame.assert_rc_copy = Object();
         }
         else if (arg.option.domain_type == kArgumentObjectStack) {
-          ptr = obj_stack_.Find(arg.GetData(), arg.option.domain);
+          ptr = obj_stack_.Find(arg.GetSymbol(), arg.option.domain_symbol);
 
           if (ptr != nullptr) {
             if (!ptr->IsAlive()) OBJECT_DEAD_MSG;
@@ -1105,7 +1108,7 @@ namespace kagami {
           auto &sub_container = return_stack.back()->IsObjectView() ?
             dynamic_cast<ObjectView *>(return_stack.back())->Seek().Cast<ObjectStruct>() :
             dynamic_cast<ObjectPointer>(return_stack.back())->Cast<ObjectStruct>();
-          ptr = sub_container.Find(arg.GetData());
+          ptr = sub_container.Find(arg.GetSymbol());
           //keep object alive
           if (ptr != nullptr) {
             if (!ptr->IsAlive()) OBJECT_DEAD_MSG;
@@ -1118,15 +1121,15 @@ namespace kagami {
         }
       }
       else {
-        if (ptr = obj_stack_.Find(arg.GetData()); ptr != nullptr) {
+        if (ptr = obj_stack_.Find(arg.GetSymbol()); ptr != nullptr) {
           if (!ptr->IsAlive()) OBJECT_DEAD_MSG;
           view = ObjectView(ptr);
         }
-        else if (ptr = GetConstantObject(arg.GetData()); ptr != nullptr) {
+        else if (ptr = GetConstantObject(arg.GetSymbol()); ptr != nullptr) {
           view = ObjectView(ptr);
         }
         else {
-          auto obj = FetchFunctionObject(arg.GetData());
+          auto obj = FetchFunctionObject(arg.GetSymbol());
           if (obj.Null()) {
             frame.MakeError("Object is not found: " + arg.GetData());
           }
@@ -1221,30 +1224,36 @@ namespace kagami {
     return true;
   }
 
-  bool Machine::FetchFunctionImpl(FunctionImplPointer &impl, CommandPointer &command, ObjectMap &obj_map) {
+  bool Machine::FetchFunctionImpl(FunctionImplPointer &impl, CommandPointer &command,
+    ObjectMap &obj_map, ObjectView &domain_view) {
     auto &frame = frame_stack_.top();
-    auto id = command->first.GetInterfaceId();
-    auto domain = command->first.GetInterfaceDomain();
+    auto &id = command->first.GetInterfaceId();
+    auto symbol = command->first.GetInterfaceSymbol();
+    auto &domain = command->first.GetInterfaceDomain();
 
     auto has_domain = domain.GetType() != kArgumentNull ||
       command->first.option.use_last_assert;
 
     if (has_domain) {
-      auto view = command->first.option.use_last_assert ?
-        ObjectView(&frame.assert_rc_copy) :
-        FetchObjectView(domain);
+      auto view = domain_view;
+
+      if (!view.IsValid()) {
+        view = command->first.option.use_last_assert ?
+          ObjectView(&frame.assert_rc_copy) :
+          FetchObjectView(domain);
+      }
 
       if (frame.error) return false;
 
       //find method in sub-container    
       if (view.Seek().IsSubContainer()) {
         //CXX function from components
-        impl = mgmt::FindFunction(id, view.Seek().GetTypeId());
+        impl = mgmt::FindFunction(symbol, view.Seek().GetTypeId());
 
         //not found, try to find VMCode function
         if (impl == nullptr) {
           auto &base = view.Seek().Cast<ObjectStruct>();
-          auto *ptr = base.Find(id);
+          auto *ptr = base.Find(symbol);
           if (ptr == nullptr) {
             frame.MakeError("Method is not found: " + id); 
             return false;                                  
@@ -1262,7 +1271,7 @@ namespace kagami {
         impl = it->second;
       }
       else {
-        impl = mgmt::FindFunction(id, view.Seek().GetTypeId());
+        impl = mgmt::FindFunction(symbol, view.Seek().GetTypeId());
         if (impl != nullptr) {
           impl_cache_.emplace(std::make_pair(frame.idx, impl));
         }
@@ -1284,8 +1293,8 @@ namespace kagami {
         impl = it->second;
       }
       //not found,  try to find VMCode function
-      else if (impl = FindFunction(id); impl == nullptr) {
-        ObjectPointer ptr = obj_stack_.Find(id);
+      else if (impl = FindFunction(symbol); impl == nullptr) {
+        ObjectPointer ptr = obj_stack_.Find(symbol);
 
         if (ptr == nullptr) {
           frame.MakeError("Function is not found: " + id);
@@ -1329,7 +1338,7 @@ namespace kagami {
 
   void Machine::CheckDomainObject(FunctionImpl &impl, Request &req, bool first_assert) {
     auto &frame = frame_stack_.top();
-    auto domain = req.GetInterfaceDomain();
+    auto &domain = req.GetInterfaceDomain();
     auto keyword = req.GetKeywordValue();
     auto need_catching = domain.GetType() == kArgumentObjectStack
       && ((keyword != kKeywordDomainAssertCommand)
@@ -1382,26 +1391,18 @@ namespace kagami {
     }
   }
 
-  void Machine::ClosureCatching(ArgumentList &args, size_t nest_end, bool closure) {
-    auto &frame = frame_stack_.top();
-    auto &obj_list = obj_stack_.GetBase();
-    auto &origin_code = *code_stack_.back();
+  //Function object of 'fn' block at nest, its body ends before end.
+  //Body of lazy one is copied from origin_code on first call.
+  static FunctionImpl CompileFunctionImpl(VMCode &origin_code, ArgumentList &args,
+    size_t nest, size_t end, bool lazy = false) {
     size_t counter = 0;
     size_t size = args.size();
-    size_t nest = frame.idx;
     bool optional = false;
     bool variable = false;
-    bool not_assert_before = false;
-    bool first_assert = false;
     ParameterPattern argument_mode = kParamFixed;
     vector<string> params;
-    VMCode code(&origin_code);
     string return_value_constraint;
 
-    for (size_t idx = nest + 1; idx < nest_end - frame.jump_offset; ++idx) {
-      code.push_back(origin_code[idx]);
-    }
-
     for (size_t idx = 1; idx < size; idx += 1) {
       auto id = args[idx].GetData();
 
@@ -1423,13 +1424,42 @@ namespace kagami {
     if (optional) argument_mode = kParamAutoFill;
     if (variable) argument_mode = kParamAutoSize;
 
-    FunctionImpl impl(nest + 1, code, args[0].GetData(), params, argument_mode);
+    FunctionImpl impl;
+
+    if (lazy) {
+      impl = FunctionImpl(nest + 1, origin_code, end, args[0].GetData(), params, argument_mode);
+    }
+    else {
+      VMCode code(&origin_code);
+
+      for (size_t idx = nest + 1; idx < end; ++idx) {
+        code.push_back(origin_code[idx]);
+      }
+
+      impl = FunctionImpl(nest + 1, std::move(code), args[0].GetData(), params, argument_mode);
+    }
 
     if (optional) {
       impl.SetLimit(params.size() - counter);
     }
 
+    if (!return_value_constraint.empty()) {
+      impl.AppendClosureRecord(kStrReturnValueConstrantObj, Object(return_value_constraint));
+    }
+
+    return impl;
+  }
+
+  void Machine::ClosureCatching(ArgumentList &args, size_t nest_end, bool closure) {
+    auto &frame = frame_stack_.top();
+    bool not_assert_before = false;
+    bool first_assert = false;
+    FunctionImpl impl = CompileFunctionImpl(*code_stack_.back(), args,
+      frame.idx, nest_end - frame.jump_offset);
+
     if (closure) {
+      auto &code = impl.GetCode();
+
       for (auto it = code.begin(); it != code.end(); ++it) {
         first_assert = not_assert_before && it->first.GetKeywordValue() == kKeywordDomainAssertCommand;
         not_assert_before = it->first.GetKeywordValue() != kKeywordDomainAssertCommand;
@@ -1438,16 +1468,58 @@ namespace kagami {
       }
     }
 
-    if (!return_value_constraint.empty()) {
-      impl.AppendClosureRecord(kStrReturnValueConstrantObj, Object(return_value_constraint));
-    }
-
     obj_stack_.CreateObject(args[0].GetData(),
-      Object(make_shared<FunctionImpl>(impl), kTypeIdFunction));
+      Object(make_shared<FunctionImpl>(impl), kTypeIdFunction), args[0].GetSymbol());
 
     frame.Goto(nest_end + 1);
   }
 
+  //Innermost machine in Run(), modules are executed by their own machines
+  static Machine *running_machine = nullptr;
+
+  Message InvokeFunctionObject(Object &func, vector<Object> &args) {
+    if (running_machine == nullptr) {
+      return Message("Function object can't be called outside of script", kStateError);
+    }
+
+    return running_machine->CallFunctionObject(func, args);
+  }
+
+  Message Machine::CallFunctionObject(Object &func, vector<Object> &args) {
+    if (func.GetTypeId() != kTypeIdFunction) {
+      return Message("Invalid function object - " + func.GetTypeId(), kStateError);
+    }
+
+    auto &impl = func.Cast<FunctionImpl>();
+    auto &params = impl.GetParameters();
+    ObjectMap obj_map;
+
+    if (impl.GetPattern() != kParamFixed || params.size() != args.size()) {
+      return Message("Function object must accept " + to_string(args.size()) +
+        " argument(s)", kStateError);
+    }
+
+    for (size_t idx = 0; idx < params.size(); ++idx) {
+      obj_map.emplace(NamedObject(params[idx], args[idx]));
+    }
+
+    if (impl.GetType() == kFunctionCXX) {
+      return impl.GetActivity()(obj_map);
+    }
+
+    if (impl.GetType() != kFunctionVMCode) {
+      return Message("Unsupported function variant", kStateError);
+    }
+
+    auto result = CallVMCFunction(impl, obj_map);
+
+    if (frame_stack_.top().error) {
+      return Message(frame_stack_.top().msg_string, kStateError);
+    }
+
+    return result;
+  }
+
   Message Machine::CallMethod(Object &obj, string id, ObjectMap &args) {
     FunctionImplPointer impl;
     auto &frame = frame_stack_.top();
@@ -1518,10 +1590,9 @@ namespace kagami {
     return result;
   }
 
-  void Machine::CommandIfOrWhile(Keyword token, ArgumentList &args, size_t nest_end) {
+  void Machine::CommandIfOrWhile(Keyword token, ArgumentList &args, 
+    size_t nest_end, size_t jump_target) {
     auto &frame = frame_stack_.top();
-    auto &code = code_stack_.front();
-    bool has_jump_record = false;
     bool state = false;
 
     if (!EXPECTED_COUNT(1)) {
@@ -1529,11 +1600,6 @@ namespace kagami {
       return;
     }
 
-    if (token == kKeywordIf || token == kKeywordWhile) {
-      frame.AddJumpRecord(nest_end);
-      has_jump_record = code->FindJumpRecord(frame.idx + frame.jump_offset, frame.branch_jump_stack);
-    }
-    
     if (frame.is_there_a_cond) {
       state = frame.reserved_cond;
       frame.is_there_a_cond = false;
@@ -1559,15 +1625,15 @@ namespace kagami {
       };
 
       if (!state) {
-        if (frame.branch_jump_stack.empty()) {
-          frame.Goto(frame.jump_stack.top());
+        //No branch to go, skip the whole block
+        if (jump_target == nest_end) {
           frame.cancel_cleanup = true;
         }
         else {
           create_env();
-          frame.Goto(frame.branch_jump_stack.top());
-          frame.branch_jump_stack.pop();
         }
+
+        frame.Goto(jump_target);
       }
       else {
         create_env();
@@ -1580,20 +1646,14 @@ namespace kagami {
       }
 
       if (frame.condition_stack.top()) {
-        frame.Goto(frame.jump_stack.top());
+        frame.Goto(nest_end);
       }
       else {
         if (state) {
           frame.condition_stack.top() = true;
         }
         else {
-          if (frame.branch_jump_stack.empty()) {
-            frame.Goto(frame.jump_stack.top());
-          }
-          else {
-            frame.Goto(frame.branch_jump_stack.top());
-            frame.branch_jump_stack.pop();
-          }
+          frame.Goto(jump_target);
         }
       }
     }
@@ -1613,12 +1673,161 @@ namespace kagami {
     }
   }
 
+  /* Cursor actions for for-each loop over built-in containers */
+  inline bool IsCursorFinished(monostate &) { return true; }
+
+  template <typename T>
+  inline bool IsCursorFinished(SequenceCursor<T> &cursor) {
+    return cursor.index >= cursor.base->size();
+  }
+
+  template <typename T>
+  inline bool IsCursorFinished(TableCursor<T> &cursor) {
+    return cursor.current == cursor.base->end();
+  }
+
+  //end() of hash table is moved back by clear(), index may be past it
+  inline bool IsCursorFinished(TableCursor<ObjectTable> &cursor) {
+    return cursor.current.IsEnd();
+  }
+
+  inline bool IsCursorFinished(TableCursor<ObjectSet> &cursor) {
+    return cursor.current.IsEnd();
+  }
+
+  //Node-based sorted table can't be modified during iteration,
+  //hash table/set can't be cleared during iteration
+  template <typename T>
+  inline bool IsCursorValid(T &) { return true; }
+
+  template <typename T>
+  inline bool IsCursorValid(TableCursor<T> &cursor) {
+    return cursor.current.IsValid();
+  }
+
+  inline void StepCursor(monostate &) {}
+
+  template <typename T>
+  inline void StepCursor(SequenceCursor<T> &cursor) { ++cursor.index; }
+
+  template <typename T>
+  inline void StepCursor(TableCursor<T> &cursor) { ++cursor.current; }
+
+  inline Object GetCursorElement(monostate &) { return Object(); }
+
+  template <typename T>
+  inline Object GetCursorElement(SequenceCursor<T> &cursor) {
+    return PackElement((*cursor.base)[cursor.index]);
+  }
+
+  inline Object GetCursorElement(SequenceCursor<ByteArray> &cursor) {
+    return Object(static_cast<int64_t>((*cursor.base)[cursor.index]), kTypeIdInt);
+  }
+
+  //Elements of heap/set can't be modified in place
+  inline Object GetCursorElement(SequenceCursor<ObjectHeap> &cursor) {
+    return management::type::CreateObjectCopy((*cursor.base)[cursor.index]);
+  }
+
+  inline Object GetCursorElement(TableCursor<ObjectSet> &cursor) {
+    return management::type::CreateObjectCopy(*cursor.current);
+  }
+
+  //Int keys can be modified in place by += and -=, they get a fresh object.
+  //Other plain type keys share stored content. Remaining keys are copied,
+  //modifying them would break the order of table
+  template <typename T>
+  inline Object GetCursorKeyObject(TableCursor<T> &cursor) {
+    Object key = (*cursor.current).first;
+    auto &type_id = key.GetTypeId();
+    if (type_id == kTypeIdInt) return Object(key.Cast<int64_t>(), kTypeIdInt);
+    if (lexical::IsPlainType(type_id)) return key;
+    return management::type::CreateObjectCopy(key);
+  }
+
+  //Value is bound as reference, no copy is created
+  template <typename T>
+  inline Object GetCursorElement(TableCursor<T> &cursor) {
+    ManagedPair base = make_shared<ObjectPair>(
+      GetCursorKeyObject(cursor), Object().PackObject((*cursor.current).second));
+    return Object(base, kTypeIdPair);
+  }
+
+  //Only tables provide key and value, checked before binding
+  template <typename T>
+  inline Object GetCursorKey(T &) { return Object(); }
+  template <typename T>
+  inline Object GetCursorValue(T &) { return Object(); }
+  inline Object GetCursorKey(TableCursor<ObjectSet> &) { return Object(); }
+  inline Object GetCursorValue(TableCursor<ObjectSet> &) { return Object(); }
+
+  template <typename T>
+  inline Object GetCursorKey(TableCursor<T> &cursor) { return GetCursorKeyObject(cursor); }
+
+  template <typename T>
+  inline Object GetCursorValue(TableCursor<T> &cursor) {
+    return Object().PackObject((*cursor.current).second);
+  }
+
+  inline bool IsKeyValueCursor(CursorPosition &position) {
+    return std::holds_alternative<TableCursor<ObjectTable>>(position) ||
+      std::holds_alternative<TableCursor<SortedTable>>(position);
+  }
+
+  bool CreateContainerCursor(Object &container, ContainerCursor &cursor) {
+    auto &type_id = container.GetTypeId();
+
+    if (type_id == kTypeIdArray || type_id == kTypeIdDeque) {
+      cursor.position = SequenceCursor<ObjectArray>{ &container.Cast<ObjectArray>(), 0 };
+    }
+    else if (type_id == kTypeIdArraySlice) {
+      cursor.position = SequenceCursor<ArraySlice>{ &container.Cast<ArraySlice>(), 0 };
+    }
+    else if (type_id == kTypeIdIntArray) {
+      cursor.position = SequenceCursor<IntArray>{ &container.Cast<IntArray>(), 0 };
+    }
+    else if (type_id == kTypeIdFloatArray) {
+      cursor.position = SequenceCursor<FloatArray>{ &container.Cast<FloatArray>(), 0 };
+    }
+    else if (type_id == kTypeIdBoolArray) {
+      cursor.position = SequenceCursor<BoolArray>{ &container.Cast<BoolArray>(), 0 };
+    }
+    else if (type_id == kTypeIdBytes) {
+      cursor.position = SequenceCursor<ByteArray>{ &container.Cast<ByteArray>(), 0 };
+    }
+    else if (type_id == kTypeIdTable) {
+      auto &base = container.Cast<ObjectTable>();
+      cursor.position = TableCursor<ObjectTable>{ &base, base.begin() };
+    }
+    else if (type_id == kTypeIdSortedTable) {
+      auto &base = container.Cast<SortedTable>();
+      cursor.position = TableCursor<SortedTable>{ &base, base.begin() };
+    }
+    else if (type_id == kTypeIdSet) {
+      auto &base = container.Cast<ObjectSet>();
+      cursor.position = TableCursor<ObjectSet>{ &base, base.begin() };
+    }
+    else if (type_id == kTypeIdHeap) {
+      cursor.position = SequenceCursor<ObjectHeap>{ &container.Cast<ObjectHeap>(), 0 };
+    }
+    else if (type_id == kTypeIdTableView) {
+      auto &view = container.Cast<TableView>();
+      if (!CreateContainerCursor(view.table, cursor)) return false;
+      cursor.binding = view.kind == kTableViewValues ? kBindValue : kBindElement;
+      return true;
+    }
+    else {
+      return false;
+    }
+
+    cursor.container = container;
+    return true;
+  }
+
   void Machine::CommandForEach(ArgumentList &args, size_t nest_end) {
     auto &frame = frame_stack_.top();
     ObjectMap obj_map;
 
-    frame.AddJumpRecord(nest_end);
-
     if (frame.jump_from_end) {
       ForEachChecking(args, nest_end);
       frame.jump_from_end = false;
@@ -1627,10 +1836,43 @@ namespace kagami {
 
     auto unit_id = FetchObjectView(args[0]).Seek().Cast<string>();
     //keep alive
-    auto container_obj = FetchObjectView(args[1]).Seek();
+    auto container_obj = FetchObjectView(args.back()).Seek();
+    bool key_value = args.size() == 3;
 
     if (frame.error) return;
 
+    //Built-in containers are iterated without iterator object
+    if (ContainerCursor cursor; CreateContainerCursor(container_obj, cursor)) {
+      if (key_value) {
+        if (cursor.binding != kBindElement || !IsKeyValueCursor(cursor.position)) {
+          frame.MakeError("Key-value binding requires table or items() view");
+          return;
+        }
+
+        cursor.binding = kBindKeyValue;
+      }
+
+      frame.cursor_stack.push(std::move(cursor));
+      frame.scope_stack.push(true);
+      obj_stack_.Push(true);
+
+      auto &position = frame.cursor_stack.top().position;
+
+      if (std::visit([](auto &pos) { return IsCursorFinished(pos); }, position)) {
+        frame.Goto(nest_end);
+        frame.final_cycle = true;
+        return;
+      }
+
+      BindCursorUnits(args, frame.cursor_stack.top());
+      return;
+    }
+
+    if (key_value) {
+      frame.MakeError("Key-value binding requires table or items() view");
+      return;
+    }
+
     if (!type::CheckBehavior(container_obj, kContainerBehavior)) {
       frame.MakeError("Invalid container object");
       return;
@@ -1654,6 +1896,7 @@ namespace kagami {
       frame.final_cycle = true;
       obj_stack_.Push(true); //avoid error
       frame.scope_stack.push(false);
+      frame.cursor_stack.push(ContainerCursor());
       return;
     }
 
@@ -1667,14 +1910,35 @@ namespace kagami {
     if (frame.error) return;
 
     frame.scope_stack.push(true);
+    frame.cursor_stack.push(ContainerCursor());
     obj_stack_.Push(true);
     obj_stack_.CreateObject(kStrIteratorObj, iterator_obj);
     obj_stack_.CreateObject(kStrContainerKeepAliveSlot, container_obj);
-    obj_stack_.CreateObject(unit_id, unit);
+    obj_stack_.CreateObject(unit_id, unit, args[0].GetSymbol());
   }
 
   void Machine::ForEachChecking(ArgumentList &args, size_t nest_end) {
     auto &frame = frame_stack_.top();
+
+    if (auto &position = frame.cursor_stack.top().position; position.index() != 0) {
+      if (!std::visit([](auto &pos) { return IsCursorValid(pos); }, position)) {
+        frame.MakeError("Container is modified during iteration");
+        return;
+      }
+
+      std::visit([](auto &pos) { StepCursor(pos); }, position);
+
+      if (std::visit([](auto &pos) { return IsCursorFinished(pos); }, position)) {
+        frame.Goto(nest_end);
+        frame.final_cycle = true;
+      }
+      else {
+        BindCursorUnits(args, frame.cursor_stack.top());
+      }
+
+      return;
+    }
+
     auto unit_id = FetchObjectView(args[0]).Seek().Cast<string>();
     if (frame.error) return;
 
@@ -1708,23 +1972,127 @@ namespace kagami {
     else {
       auto unit = CallMethod(*iterator, "obj").GetObj();
       if (frame.error) return;
-      obj_stack_.CreateObject(unit_id, unit);
+      obj_stack_.CreateObject(unit_id, unit, args[0].GetSymbol());
     }
   }
 
-  void Machine::CommandCase(ArgumentList &args, size_t nest_end) {
+  void Machine::BindCursorUnits(ArgumentList &args, ContainerCursor &cursor) {
+    auto &position = cursor.position;
+
+    switch (cursor.binding) {
+    case kBindKeyValue:
+      obj_stack_.CreateObject(args[0].GetData(),
+        std::visit([](auto &pos) { return GetCursorKey(pos); }, position),
+        args[0].GetSymbol());
+      obj_stack_.CreateObject(args[1].GetData(),
+        std::visit([](auto &pos) { return GetCursorValue(pos); }, position),
+        args[1].GetSymbol());
+      break;
+    case kBindValue:
+      obj_stack_.CreateObject(args[0].GetData(),
+        std::visit([](auto &pos) { return GetCursorValue(pos); }, position),
+        args[0].GetSymbol());
+      break;
+    default:
+      obj_stack_.CreateObject(args[0].GetData(),
+        std::visit([](auto &pos) { return GetCursorElement(pos); }, position),
+        args[0].GetSymbol());
+      break;
+    }
+  }
+
+  inline bool IsRangeFinished(RangeCounter &counter) {
+    return counter.step > 0 ?
+      counter.current >= counter.stop :
+      counter.current <= counter.stop;
+  }
+
+  void Machine::CommandForRange(ArgumentList &args, size_t nest_end) {
     auto &frame = frame_stack_.top();
-    auto &code = code_stack_.back();
 
-    if (args.empty()) {
-      frame.MakeError("Empty argument list");
+    if (frame.jump_from_end) {
+      ForRangeChecking(args, nest_end);
+      frame.jump_from_end = false;
+      return;
+    }
+
+    //Same order as Generate_Fixed for return stack arguments
+    auto step_view = FetchObjectView(args[3]);
+    auto stop_view = FetchObjectView(args[2]);
+    auto start_view = FetchObjectView(args[1]);
+
+    if (frame.error) return;
+
+    auto &start = start_view.Seek();
+    auto &stop = stop_view.Seek();
+    auto &step = step_view.Seek();
+
+    if (start.GetTypeId() != kTypeIdInt || stop.GetTypeId() != kTypeIdInt ||
+      step.GetTypeId() != kTypeIdInt) {
+      frame.MakeError("Invalid argument type for range()");
+      return;
+    }
+
+    if (step.Cast<int64_t>() == 0) {
+      frame.MakeError("Step of range() can't be zero");
+      return;
+    }
+
+    auto &unit_id = args[0].GetData();
+    frame.range_stack.push(RangeCounter{ unit_id,
+      start.Cast<int64_t>(), stop.Cast<int64_t>(), step.Cast<int64_t>() });
+    frame.scope_stack.push(true);
+    obj_stack_.Push(true);
+
+    auto &counter = frame.range_stack.top();
+
+    if (IsRangeFinished(counter)) {
+      frame.Goto(nest_end);
+      frame.final_cycle = true;
+      return;
+    }
+
+    obj_stack_.CreateObject(unit_id, Object(counter.current, kTypeIdInt),
+      args[0].GetSymbol());
+  }
+
+  void Machine::ForRangeChecking(ArgumentList &args, size_t nest_end) {
+    auto &frame = frame_stack_.top();
+    auto &counter = frame.range_stack.top();
+    //Stop before counter overflows
+    bool overflow = counter.step > 0 ?
+      counter.current > std::numeric_limits<int64_t>::max() - counter.step :
+      counter.current < std::numeric_limits<int64_t>::min() - counter.step;
+
+    if (!overflow) counter.current += counter.step;
+
+    if (overflow || IsRangeFinished(counter)) {
+      frame.Goto(nest_end);
+      frame.final_cycle = true;
       return;
     }
 
-    frame.AddJumpRecord(nest_end);
+    auto &scope = obj_stack_.GetCurrent();
+    auto *unit = scope.Find(args[0].GetSymbol(), false);
 
-    bool has_jump_list = 
-      code->FindJumpRecord(frame.idx + frame.jump_offset, frame.branch_jump_stack);
+    //Value of loop variable is rewritten if it isn't shared with others
+    if (unit != nullptr && unit->GetMode() == kObjectNormal &&
+      unit->GetTypeId() == kTypeIdInt && unit->use_count() == 1) {
+      unit->Cast<int64_t>() = counter.current;
+    }
+    else {
+      scope.Replace(counter.unit_id, Object(counter.current, kTypeIdInt),
+        args[0].GetSymbol());
+    }
+  }
+
+  void Machine::CommandCase(ArgumentList &args, size_t jump_target) {
+    auto &frame = frame_stack_.top();
+
+    if (args.empty()) {
+      frame.MakeError("Empty argument list");
+      return;
+    }
 
     auto view = FetchObjectView(args[0]);
     if (frame.error) return;
@@ -1740,18 +2108,11 @@ namespace kagami {
     obj_stack_.Push(true);
     obj_stack_.CreateObject(kStrCaseObj, view.Seek());
     frame.condition_stack.push(false);
-
-    if (has_jump_list) {
-      frame.Goto(frame.branch_jump_stack.top());
-      frame.branch_jump_stack.pop();
-    }
-    else {
-      //although I think no one will write case block without condition branch...
-      frame.Goto(frame.jump_stack.top());
-    }
+    //although I think no one will write case block without condition branch...
+    frame.Goto(jump_target);
   }
 
-  void Machine::CommandElse() {
+  void Machine::CommandElse(size_t nest_end) {
     auto &frame = frame_stack_.top();
 
     if (frame.condition_stack.empty()) {
@@ -1760,14 +2121,14 @@ namespace kagami {
     }
 
     if (frame.condition_stack.top() == true) {
-      frame.Goto(frame.jump_stack.top());
+      frame.Goto(nest_end);
     }
     else {
       frame.condition_stack.top() = true;
     }
   }
 
-  void Machine::CommandWhen(ArgumentList &args) {
+  void Machine::CommandWhen(ArgumentList &args, size_t nest_end, size_t jump_target) {
     auto &frame = frame_stack_.top();
     bool result = false;
 
@@ -1777,7 +2138,7 @@ namespace kagami {
     }
 
     if (frame.condition_stack.top()) {
-      frame.Goto(frame.jump_stack.top());
+      frame.Goto(nest_end);
       return;
     }
 
@@ -1825,24 +2186,23 @@ namespace kagami {
         frame.condition_stack.top() = true;
       }
       else {
-        if (!frame.branch_jump_stack.empty()) {
-          frame.Goto(frame.branch_jump_stack.top());
-          frame.branch_jump_stack.pop();
-        }
-        else {
-          frame.Goto(frame.jump_stack.top());
-        }
+        frame.Goto(jump_target);
       }
     }
   }
 
-  void Machine::CommandContinueOrBreak(Keyword token, size_t escape_depth) {
+  void Machine::CommandContinueOrBreak(Keyword token, size_t escape_depth, size_t nest_end) {
     auto &frame = frame_stack_.top();
     auto &scope_stack = frame.scope_stack;
 
+    //Not resolved, cycle is out of current function
+    if (nest_end == 0) {
+      frame.MakeError("Invalid cycle escaper");
+      return;
+    }
+
     while (escape_depth != 0) {
       frame.condition_stack.pop();
-      frame.jump_stack.pop();
       if (!scope_stack.empty() && scope_stack.top()) {
         obj_stack_.Pop();
       }
@@ -1850,7 +2210,7 @@ namespace kagami {
       escape_depth -= 1;
     }
 
-    frame.Goto(frame.jump_stack.top());
+    frame.Goto(nest_end);
 
     switch (token) {
     case kKeywordContinue:
@@ -1915,11 +2275,9 @@ namespace kagami {
       frame.condition_stack.pop();
       frame.scope_stack.pop();
       obj_stack_.Pop();
-      while (!frame.branch_jump_stack.empty()) frame.branch_jump_stack.pop();
-      frame.cancel_cleanup = false;
     }
 
-    frame.jump_stack.pop();
+    frame.cancel_cleanup = false;
   }
 
   void Machine::CommandLoopEnd(size_t nest) {
@@ -1939,7 +2297,6 @@ namespace kagami {
           delete frame.return_stack.back();
           frame.return_stack.pop_back();
         }
-        frame.jump_stack.pop();
         obj_stack_.Pop();
       }
       frame.scope_stack.pop();
@@ -1957,29 +2314,54 @@ namespace kagami {
     }
   }
 
-  void Machine::CommandForEachEnd(size_t nest) {
+  void Machine::CommandForEachEnd(size_t loop_idx) {
     auto &frame = frame_stack_.top();
 
+    frame.activated_continue = false;
+
     if (frame.final_cycle) {
-      if (frame.activated_continue) {
-        frame.Goto(nest);
-        frame.activated_continue = false;
-        obj_stack_.GetCurrent().ClearExcept(kForEachExceptions);
-        frame.jump_from_end = true;
-      }
-      else {
-        if (frame.activated_break) frame.activated_break = false;
-        frame.jump_stack.pop();
-        obj_stack_.Pop();
-      }
-      if(!frame.scope_stack.empty()) frame.scope_stack.pop();
+      frame.activated_break = false;
       frame.final_cycle = false;
+      frame.cursor_stack.pop();
+      if (!frame.scope_stack.empty()) frame.scope_stack.pop();
+      obj_stack_.Pop();
+      return;
+    }
+
+    //Cursor is kept in frame, so nothing in scope needs to survive
+    if (frame.cursor_stack.top().position.index() != 0) {
+      obj_stack_.ClearCurrent();
     }
     else {
-      frame.Goto(nest);
       obj_stack_.GetCurrent().ClearExcept(kForEachExceptions);
-      frame.jump_from_end = true;
     }
+
+    frame.Goto(loop_idx);
+    frame.jump_from_end = true;
+  }
+
+  void Machine::CommandForRangeEnd(size_t loop_idx) {
+    auto &frame = frame_stack_.top();
+
+    frame.activated_continue = false;
+
+    if (frame.final_cycle) {
+      frame.activated_break = false;
+      frame.final_cycle = false;
+      frame.range_stack.pop();
+      frame.scope_stack.pop();
+      obj_stack_.Pop();
+      return;
+    }
+
+    //Objects created by loop body are dropped, loop variable is reused
+    auto &scope = obj_stack_.GetCurrent();
+    if (scope.GetContent().size() > 1) {
+      scope.ClearExcept(frame.range_stack.top().unit_id);
+    }
+
+    frame.Goto(loop_idx);
+    frame.jump_from_end = true;
   }
 
   void Machine::CommandStructEnd() {
@@ -2167,7 +2549,7 @@ namespace kagami {
         break;
       }
 
-      obj_stack_.CreateObject(unit.GetData(), Object());
+      obj_stack_.CreateObject(unit.GetData(), Object(), unit.GetSymbol());
     }
 
     if (error) {
@@ -2423,8 +2805,13 @@ namespace kagami {
         return;
       }
 
+      //Name of literal argument is interned by frontend already
+      SymbolId symbol = args[0].GetType() == kArgumentLiteral ?
+        args[0].GetSymbol() : kSymbolNull;
+
       if (!local_value && frame.struct_id.empty()) {
-        ObjectPointer ptr = obj_stack_.Find(id);
+        ObjectPointer ptr = symbol != kSymbolNull ?
+          obj_stack_.Find(symbol) : obj_stack_.Find(id);
 
         if (ptr != nullptr) {
           if (!ptr->IsAlive()) {
@@ -2437,7 +2824,7 @@ namespace kagami {
         }
       }
 
-      if (!obj_stack_.CreateObject(id, CreateObjectCopy(rhs.Seek()))) {
+      if (!obj_stack_.CreateObject(id, CreateObjectCopy(rhs.Seek()), symbol)) {
         frame.MakeError("Object binding is failed");
         return;
       }
@@ -2483,8 +2870,13 @@ namespace kagami {
         return;
       }
 
+      //Name of literal argument is interned by frontend already
+      SymbolId symbol = args[0].GetType() == kArgumentLiteral ?
+        args[0].GetSymbol() : kSymbolNull;
+
       if (!local_value && frame.struct_id.empty()) {
-        ObjectPointer ptr = obj_stack_.Find(id);
+        ObjectPointer ptr = symbol != kSymbolNull ?
+          obj_stack_.Find(symbol) : obj_stack_.Find(id);
 
         if (ptr != nullptr) {
           if (!ptr->IsAlive()) {
@@ -2500,7 +2892,7 @@ namespace kagami {
 
       rhs.Seek().Unpack() = Object();
 
-      if (!obj_stack_.CreateObject(id, rhs.Seek().Unpack())) {
+      if (!obj_stack_.CreateObject(id, rhs.Seek().Unpack(), symbol)) {
         frame.MakeError("Object delivering is failed");
         return;
       }
@@ -2679,51 +3071,136 @@ namespace kagami {
     }
   }
 
-  void Machine::CommandUsing(ArgumentList &args) {
-    auto &frame = frame_stack_.top();
+  //Absolute path of script file, or empty string for other file types
+  //TODO:Smarter directory strategy
+  static string GetScriptModulePath(const string &path) {
+    fs::path path_cls(path);
+    string extension_name = lexical::ToLower(path_cls.extension().string());
 
-    if (!EXPECTED_COUNT(1)) {
-      frame.MakeError("Argument mismatching: load(obj)");
-      return;
-    }
+    if (extension_name != ".kagami" && !extension_name.empty()) return string();
 
-    auto path_obj = FetchObject(args[0]);
-    if (frame.error) return;
+    string absolute_path = fs::absolute(path_cls).string();
+    if (extension_name.empty()) absolute_path.append(".kagami");
+    return absolute_path;
+  }
 
-    if (path_obj.GetTypeId() != kTypeIdString) {
-      frame.MakeError("Invalid path");
-      return;
+  //Export table is only built for module of which top level just defines
+  //functions and loads other scripts by literal path. Other modules are
+  //executed by their own machine.
+  static bool BuildModuleExports(management::script::ModuleUnit &module) {
+    auto &code = *module.code;
+
+    for (size_t idx = 0; idx < code.size(); ++idx) {
+      auto &request = code[idx].first;
+      auto &args = code[idx].second;
+
+      if (request.type != kRequestCommand) return false;
+
+      auto keyword = request.GetKeywordValue();
+
+      if (keyword == kKeywordFn) {
+        auto impl = CompileFunctionImpl(code, args, idx, request.option.nest_end, true);
+        module.exports.push_back({ args[0].GetData(),
+          Object(make_shared<FunctionImpl>(impl), kTypeIdFunction),
+          args[0].GetSymbol(), false, request.idx });
+        idx = request.option.nest_end;
+      }
+      else if (keyword == kKeywordUsing && args.size() == 1
+        && args[0].GetType() == kArgumentLiteral
+        && args[0].GetStringType() == kStringTypeLiteralStr) {
+        string path = ParseRawString(args[0].GetData());
+        if (GetScriptModulePath(path).empty()) return false;
+        module.exports.push_back({ path, Object(), kSymbolNull, true, request.idx });
+      }
+      else {
+        return false;
+      }
     }
 
-    //TODO:Smarter directory strategy
+    return true;
+  }
 
-    string path = path_obj.Cast<string>();
-    fs::path path_cls(path);
-    string extension_name = lexical::ToLower(path_cls.extension().string());
+  bool Machine::LoadModule(const string &path, ObjectContainer &root,
+    unordered_set<string> &bound) {
+    auto &frame = frame_stack_.top();
+    string absolute_path = GetScriptModulePath(path);
 
-    if (extension_name == ".kagami" || extension_name.empty()) {
-      string absolute_path = fs::absolute(fs::path(path)).string();
-      if (extension_name.empty()) absolute_path.append(".kagami");
+    //Loaded twice in one 'using', or cyclic loading
+    if (!bound.insert(absolute_path).second) return true;
+
+    auto *module = management::script::FindModule(absolute_path);
+
+    if (module == nullptr) {
       VMCode &script_file = management::script::AppendBlankScript(absolute_path);
 
-      if (!script_file.empty()) return;
+      //Main script, or module which is executed already
+      if (!script_file.empty()) return true;
 
       VMCodeFactory factory(absolute_path, script_file, logger_);
 
-      if (factory.Start()) {
+      if (!factory.Start() || !factory.Optimize(true)) {
+        frame.MakeError("Invalid script - " + path);
+        return false;
+      }
+
+      management::script::ModuleUnit unit{ &script_file, {} };
+
+      if (!BuildModuleExports(unit)) {
         Machine sub_machine(script_file, logger_);
-        auto &obj_base = obj_stack_.GetBase();
-        sub_machine.SetDelegatedRoot(obj_base.front());
+        sub_machine.SetDelegatedRoot(root);
         sub_machine.Run();
 
         if (sub_machine.ErrorOccurred()) {
           frame.MakeError("Error is occurred in loaded script");
+          return false;
         }
+
+        return true;
       }
-      else {
-        frame.MakeError("Invalid script - " + path);
+
+      module = &management::script::AppendModule(absolute_path, std::move(unit));
+    }
+
+    //Names which are already bound are kept, they may be reassigned by
+    //importer or bound by another module
+    for (auto &unit : module->exports) {
+      if (!unit.import) {
+        root.Add(unit.id, unit.obj, unit.symbol);
+      }
+      else if (!LoadModule(unit.id, root, bound)) {
+        //Same report as the one from machine of this module
+        AppendMessage(frame.msg_string, kStateError, logger_, unit.idx);
+        frame.MakeError("Error is occurred in loaded script");
+        return false;
       }
     }
+
+    return true;
+  }
+
+  void Machine::CommandUsing(ArgumentList &args) {
+    auto &frame = frame_stack_.top();
+
+    if (!EXPECTED_COUNT(1)) {
+      frame.MakeError("Argument mismatching: load(obj)");
+      return;
+    }
+
+    auto path_obj = FetchObject(args[0]);
+    if (frame.error) return;
+
+    if (path_obj.GetTypeId() != kTypeIdString) {
+      frame.MakeError("Invalid path");
+      return;
+    }
+
+    string path = path_obj.Cast<string>();
+    string extension_name = lexical::ToLower(fs::path(path).extension().string());
+
+    if (extension_name == ".kagami" || extension_name.empty()) {
+      unordered_set<string> bound;
+      LoadModule(path, obj_stack_.GetBase().front(), bound);
+    }
     else if (extension_name == ".toml") {
       ConfigProcessor config_proc(obj_stack_, frame_stack_, path_obj.Cast<string>());
       if (frame.error) return;
@@ -2839,8 +3316,16 @@ namespace kagami {
     frame.RefreshReturnStack(Object(CODENAME));
   }
 
+  //Operand types are inferred by optimizer from names without scope information,
+  //a name may reach another object in runtime (e.g. object of outer scope or a
+  //literal constant after leaving the scope of an object). This is a guarded
+  //fast path: it is taken only if both type ids match the inferred type.
+  inline bool IsSpecializedOperand(ObjectView &lhs, ObjectView &rhs, const string &type_id) {
+    return lhs.Seek().GetTypeId() == type_id && rhs.Seek().GetTypeId() == type_id;
+  }
+
   template <Keyword op_code>
-  void Machine::BinaryMathOperatorImpl(ArgumentList &args) {
+  void Machine::BinaryMathOperatorImpl(ArgumentList &args, PlainType operand_type) {
     auto &frame = frame_stack_.top();
 
     if (!EXPECTED_COUNT(2)) {
@@ -2852,6 +3337,22 @@ namespace kagami {
     auto lhs = FetchObjectView(args[0]);
     if (frame.error) return;
 
+#define SPECIALIZED_PROCESSING(_Type, _TypeId)                                     \
+  if (IsSpecializedOperand(lhs, rhs, _TypeId)) {                                   \
+    _Type result = MathBox<_Type, op_code>()                                       \
+      .Do(lhs.Seek().Cast<_Type>(), rhs.Seek().Cast<_Type>());                     \
+    frame.RefreshReturnStack(Object(result, _TypeId));                             \
+    return;                                                                        \
+  }
+
+    if (operand_type == kPlainInt) {
+      SPECIALIZED_PROCESSING(int64_t, kTypeIdInt);
+    }
+    else if (operand_type == kPlainFloat) {
+      SPECIALIZED_PROCESSING(double, kTypeIdFloat);
+    }
+#undef SPECIALIZED_PROCESSING
+
     auto type_rhs = FindTypeCode(rhs.Seek().GetTypeId());
     auto type_lhs = FindTypeCode(lhs.Seek().GetTypeId());
 
@@ -2889,7 +3390,7 @@ namespace kagami {
   }
 
   template <Keyword op_code>
-  void Machine::BinaryLogicOperatorImpl(ArgumentList &args) {
+  void Machine::BinaryLogicOperatorImpl(ArgumentList &args, PlainType operand_type) {
     using namespace type;
     auto &frame = frame_stack_.top();
 
@@ -2902,6 +3403,24 @@ namespace kagami {
     auto lhs = FetchObjectView(args[0]);
     if (frame.error) return;
 
+#define SPECIALIZED_PROCESSING(_Type, _TypeId)                                     \
+  if (IsSpecializedOperand(lhs, rhs, _TypeId)) {                                   \
+    frame.RefreshReturnStack(LogicBox<_Type, op_code>()                            \
+      .Do(lhs.Seek().Cast<_Type>(), rhs.Seek().Cast<_Type>()));                    \
+    return;                                                                        \
+  }
+
+    if (operand_type == kPlainInt) {
+      SPECIALIZED_PROCESSING(int64_t, kTypeIdInt);
+    }
+    else if (operand_type == kPlainFloat) {
+      SPECIALIZED_PROCESSING(double, kTypeIdFloat);
+    }
+    else if (operand_type == kPlainBool) {
+      SPECIALIZED_PROCESSING(bool, kTypeIdBool);
+    }
+#undef SPECIALIZED_PROCESSING
+
     auto type_rhs = FindTypeCode(rhs.Seek().GetTypeId());
     auto type_lhs = FindTypeCode(lhs.Seek().GetTypeId());
     bool result = false;
@@ -3322,40 +3841,40 @@ namespace kagami {
 
     switch (token) {
     case kKeywordPlus:
-      BinaryMathOperatorImpl<kKeywordPlus>(args);
+      BinaryMathOperatorImpl<kKeywordPlus>(args, request.option.operand_type);
       break;
     case kKeywordMinus:
-      BinaryMathOperatorImpl<kKeywordMinus>(args);
+      BinaryMathOperatorImpl<kKeywordMinus>(args, request.option.operand_type);
       break;
     case kKeywordTimes:
-      BinaryMathOperatorImpl<kKeywordTimes>(args);
+      BinaryMathOperatorImpl<kKeywordTimes>(args, request.option.operand_type);
       break;
     case kKeywordDivide:
-      BinaryMathOperatorImpl<kKeywordDivide>(args);
+      BinaryMathOperatorImpl<kKeywordDivide>(args, request.option.operand_type);
       break;
     case kKeywordEquals:
-      BinaryLogicOperatorImpl<kKeywordEquals>(args);
+      BinaryLogicOperatorImpl<kKeywordEquals>(args, request.option.operand_type);
       break;
     case kKeywordLessOrEqual:
-      BinaryLogicOperatorImpl<kKeywordLessOrEqual>(args);
+      BinaryLogicOperatorImpl<kKeywordLessOrEqual>(args, request.option.operand_type);
       break;
     case kKeywordGreaterOrEqual:
-      BinaryLogicOperatorImpl<kKeywordGreaterOrEqual>(args);
+      BinaryLogicOperatorImpl<kKeywordGreaterOrEqual>(args, request.option.operand_type);
       break;
     case kKeywordNotEqual:
-      BinaryLogicOperatorImpl<kKeywordNotEqual>(args);
+      BinaryLogicOperatorImpl<kKeywordNotEqual>(args, request.option.operand_type);
       break;
     case kKeywordGreater:
-      BinaryLogicOperatorImpl<kKeywordGreater>(args);
+      BinaryLogicOperatorImpl<kKeywordGreater>(args, request.option.operand_type);
       break;
     case kKeywordLess:
-      BinaryLogicOperatorImpl<kKeywordLess>(args);
+      BinaryLogicOperatorImpl<kKeywordLess>(args, request.option.operand_type);
       break;
     case kKeywordAnd:
-      BinaryLogicOperatorImpl<kKeywordAnd>(args);
+      BinaryLogicOperatorImpl<kKeywordAnd>(args, request.option.operand_type);
       break;
     case kKeywordOr:
-      BinaryLogicOperatorImpl<kKeywordOr>(args);
+      BinaryLogicOperatorImpl<kKeywordOr>(args, request.option.operand_type);
       break;
     case kKeywordIncrease:
       OperatorIncreasing(args);
@@ -3372,6 +3891,9 @@ namespace kagami {
     case kKeywordFor:
       CommandForEach(args, request.option.nest_end);
       break;
+    case kKeywordForRange:
+      CommandForRange(args, request.option.nest_end);
+      break;
     case kKeywordNullObj:
       CommandNullObj(args);
       break;
@@ -3435,10 +3957,10 @@ namespace kagami {
       ClosureCatching(args, request.option.nest_end, frame_stack_.size() > 1);
       break;
     case kKeywordCase:
-      CommandCase(args, request.option.nest_end);
+      CommandCase(args, request.option.jump_target);
       break;
     case kKeywordWhen:
-      CommandWhen(args);
+      CommandWhen(args, request.option.nest_end, request.option.jump_target);
       break;
     case kKeywordEnd:
       switch (request.option.nest_root) {
@@ -3446,7 +3968,10 @@ namespace kagami {
         CommandLoopEnd(request.option.nest);
         break;
       case kKeywordFor:
-        CommandForEachEnd(request.option.nest);
+        CommandForEachEnd(request.option.jump_target);
+        break;
+      case kKeywordForRange:
+        CommandForRangeEnd(request.option.jump_target);
         break;
       case kKeywordIf:
       case kKeywordCase:
@@ -3463,15 +3988,15 @@ namespace kagami {
       break;
     case kKeywordContinue:
     case kKeywordBreak:
-      CommandContinueOrBreak(token, request.option.escape_depth);
+      CommandContinueOrBreak(token, request.option.escape_depth, request.option.nest_end);
       break;
     case kKeywordElse:
-      CommandElse();
+      CommandElse(request.option.nest_end);
       break;
     case kKeywordIf:
     case kKeywordElif:
     case kKeywordWhile:
-      CommandIfOrWhile(token, args, request.option.nest_end);
+      CommandIfOrWhile(token, args, request.option.nest_end, request.option.jump_target);
       break;
     case kKeywordHandle:
       CommandHandle(args);
@@ -3737,112 +4262,93 @@ namespace kagami {
     frame.struct_base = Object();
   }
 
-  bool Machine::BuiltinContainerAction(Command &command) {
+  auto &GetIntrinsicRegistry() {
+    static unordered_map<SymbolId, IntrinsicGroup> registry;
+    return registry;
+  }
+
+  IntrinsicGroup *FindIntrinsicGroup(SymbolId id) {
+    auto &base = GetIntrinsicRegistry();
+    auto it = base.find(id);
+    return it != base.end() ? &it->second : nullptr;
+  }
+
+  void CreateIntrinsics(initializer_list<IntrinsicImpl> &&impls) {
+    auto &base = GetIntrinsicRegistry();
+    for (auto &unit : impls) {
+      base[InternSymbol(unit.id)].push_back(unit);
+    }
+  }
+
+  bool Machine::BuiltinContainerAction(Command &command, ObjectView &domain_view) {
     auto &frame = frame_stack_.top();
-    auto id = command.first.GetInterfaceId();
-    auto domain = command.first.GetInterfaceDomain();
+    auto &domain = command.first.GetInterfaceDomain();
     auto has_domain = domain.GetType() != kArgumentNull ||
       command.first.option.use_last_assert;
     auto &args = command.second;
-    bool wrapped = false;
 
-    if (!has_domain) return wrapped;
+    if (!has_domain) return false;
+
+    auto *group = FindIntrinsicGroup(command.first.GetInterfaceSymbol());
+    if (group == nullptr) return false;
 
-    auto view = command.first.option.use_last_assert ?
+    //Domain object is kept for FetchFunctionImpl if there's no intrinsic
+    //for its type, because object from return stack can't be fetched twice.
+    domain_view = command.first.option.use_last_assert ?
       ObjectView(&frame.assert_rc_copy) :
       FetchObjectView(domain);
-    if (frame.error) return wrapped;
-
-    auto type_id = view.Seek().GetTypeId();
-
-    if (type_id == kTypeIdArray) {
-      if (id == kStrAt) {
-        if (args.size() != 1) {
-          frame.MakeError("Invalid array index");
-          return wrapped;
-        }
-
-        auto &base = view.Seek().Cast<ObjectArray>();
-        auto index_view = FetchObjectView(args[0]);
-
-        if (frame.error) { return wrapped; }
-
-        if (index_view.Seek().GetTypeId() != kTypeIdInt) {
-          frame.MakeError("Invalid array index type");
-          return wrapped;
-        }
-
-        int64_t index = index_view.Seek().Cast<int64_t>();
-        if (size_t(index) > base.size() - 1) {
-          frame.MakeError("Index is out of range");
-          return wrapped;
-        }
-
-        frame.RefreshReturnStack(ObjectView(&base[index]));
-        wrapped = true;
+    if (frame.error) return false;
+
+    //Temporary container is disposed at the beginning of next tick
+    bool temporary_domain = !command.first.option.use_last_assert &&
+      domain.GetType() == kArgumentReturnStack && !view_delegator_.empty() &&
+      !view_delegator_.back()->IsObjectView();
+    auto &me = domain_view.Seek();
+    auto &type_id = me.GetTypeId();
+    IntrinsicImpl *impl = nullptr;
+
+    for (auto &unit : *group) {
+      if (unit.type_id == type_id) {
+        impl = &unit;
+        break;
       }
-      else if (id == kStrSize) {
-        if (args.size() != 0) {
-          frame.MakeError("Unknown argument for array.size()");
-          return wrapped;
-        }
+    }
 
-        auto &base = view.Seek().Cast<ObjectArray>();
-        frame.RefreshReturnStack(Object(int64_t(base.size()), kTypeIdInt));
-        wrapped = true;
-      }
-      else if (id == kStrEmpty) {
-        if (args.size() != 0) {
-          frame.MakeError("Unknown argument for array.empty()");
-          return wrapped;
-        }
+    if (impl == nullptr) return false;
 
-        auto &base = view.Seek().Cast<ObjectArray>();
-        frame.RefreshReturnStack(Object(int64_t(base.empty()), kTypeIdBool));
-        wrapped = true;
-      }
+    if (args.size() > impl->arity) {
+      frame.MakeError("Too many arguments");
+      return false;
     }
-    else if (type_id == kTypeIdTable) {
-      if (id == kStrAt) {
-        if (args.size() != 1) {
-          frame.MakeError("Invalid table index");
-          return wrapped;
-        }
 
-        auto &base = view.Seek().Cast<ObjectTable>();
-        auto index_view = FetchObjectView(args[0]);
+    if (args.size() < impl->arity) {
+      frame.MakeError("Minimum argument amount is " + to_string(impl->arity));
+      return false;
+    }
 
-        if (frame.error) { return wrapped; }
+    ObjectView arg_views[kMaxIntrinsicArity];
 
-        auto &result = base[index_view.Seek()];
-        frame.RefreshReturnStack(ObjectView(&result));
-        wrapped = true;
-      }
-      else if (id == kStrSize) {
-        if (args.size() != 0) {
-          frame.MakeError("Unknown argument for array.size()");
-          return wrapped;
-        }
+    //Same order as Generate_Fixed
+    for (size_t idx = args.size(); idx > 0; --idx) {
+      arg_views[idx - 1] = FetchObjectView(args[idx - 1]);
+      if (frame.error) return false;
+      arg_views[idx - 1].Seek().RemoveDeliveringFlag();
+    }
 
-        auto &base = view.Seek().Cast<ObjectTable>();
-        frame.RefreshReturnStack(Object(int64_t(base.size()), kTypeIdInt));
-        wrapped = true;
-      }
-      else if (id == kStrEmpty) {
-        if (args.size() != 0) {
-          frame.MakeError("Unknown argument for table.empty()");
-          return wrapped;
-        }
+    size_t stack_size = frame.return_stack.size();
+    impl->handler(me, arg_views, frame);
+    if (frame.error) return false;
 
-        auto &base = view.Seek().Cast<ObjectTable>();
-        frame.RefreshReturnStack(Object(int64_t(base.empty()), kTypeIdBool));
-        wrapped = true;
-      }
+    //Element reference can't outlive temporary container, keep its content
+    if (temporary_domain && frame.return_stack.size() > stack_size &&
+      frame.return_stack.back()->IsObjectView()) {
+      auto *view = dynamic_cast<ObjectView *>(frame.return_stack.back());
+      frame.return_stack.back() = new Object(view->Seek());
+      delete view;
     }
-    //todo: more methods
 
-    if (wrapped && !frame.assert_rc_copy.Null()) frame.assert_rc_copy = Object();
-    return wrapped;
+    if (!frame.assert_rc_copy.Null()) frame.assert_rc_copy = Object();
+    return true;
   }
 
   void Machine::GenerateErrorMessages(size_t stop_index) {
@@ -3877,9 +4383,26 @@ namespace kagami {
     frame.MakeError(msg);
   }
 
+  void Machine::DumpAllocationStats() {
+    auto stats = accounting::CollectAllocationStats();
+    size_t total = 0;
+
+    for (auto &unit : stats) total += unit.bytes;
+
+    AppendMessage("Memory usage:" + to_string(total) + " bytes", kStateNormal, logger_);
+
+    for (auto &unit : stats) {
+      AppendMessage("  " + unit.type_id + " count=" + to_string(unit.count) 
+        + " bytes=" + to_string(unit.bytes), logger_);
+    }
+  }
+
   void Machine::Run(bool invoke) {
     if (code_stack_.empty()) return;
 
+    Machine *last_running_machine = running_machine;
+    running_machine = this;
+
     bool                next_tick;
     bool                wrapped;
     size_t              script_idx = 0;
@@ -4038,6 +4561,59 @@ namespace kagami {
       return failed;
     };
 
+    //Load next calling of script callback, or push the result of
+    //higher-order builtin after all elements are processed
+    auto drive_callback = [&]() -> void {
+      auto driver = frame->callback_driver;
+      obj_map.clear();
+
+      if (driver->Prepare(obj_map)) {
+        auto &func = driver->GetImpl();
+        bool event_processing = frame->event_processing;
+        code_stack_.push_back(&func.GetCode());
+        frame_stack_.emplace(func.GetId());
+        obj_stack_.Push();
+        obj_stack_.CreateObject(kStrUserFunc, Object(func.GetId()));
+        obj_stack_.MergeMap(obj_map);
+        obj_stack_.MergeMap(func.GetClosureRecord());
+        refresh_tick();
+        frame->jump_offset = func.GetOffset();
+        frame->event_processing = event_processing;
+        impl_cache_.clear();
+        return;
+      }
+
+      frame->callback_driver.reset();
+      frame->void_call = driver->caller_void_call;
+      frame->RefreshReturnStack(driver->GetResult());
+      frame->Stepping();
+    };
+
+    //Take returning value of script callback back to its driver
+    auto resume_callback = [&]() -> void {
+      auto &driver = *frame->callback_driver;
+      auto &return_stack = frame->return_stack;
+      Object value;
+
+      if (return_stack.size() > driver.caller_stack_base) {
+        value = return_stack.back()->IsObjectView() ?
+          dynamic_cast<ObjectView *>(return_stack.back())->Seek() :
+          *dynamic_cast<ObjectPointer>(return_stack.back());
+      }
+
+      while (return_stack.size() > driver.caller_stack_base) {
+        delete return_stack.back();
+        return_stack.pop_back();
+      }
+
+      if (!driver.Feed(value)) {
+        frame->MakeError(driver.GetMessage());
+        return;
+      }
+
+      drive_callback();
+    };
+
     auto is_required_by_cond = [&]() -> bool {
       bool main_trigger = lexical::IsOperator(command->first.GetKeywordValue());
       if (frame->idx >= size - 1) return false;
@@ -4079,6 +4655,10 @@ namespace kagami {
     while (frame->idx < size || frame_stack_.size() > 1 || hanging_) {
       cleanup_cache();
 
+      if (allocation_accounting && accounting::IsDumpRequired()) {
+        DumpAllocationStats();
+      }
+
       //break at stop point.
       if (frame->stop_point) break;
       //freeze mainloop to keep querying events
@@ -4110,6 +4690,13 @@ namespace kagami {
         //Update register data
         refresh_tick();
         impl_cache_.clear();
+
+        if (frame->callback_driver != nullptr) {
+          resume_callback();
+          if (frame->error) break;
+          continue;
+        }
+
         if (!freezing_ && !frame->stop_point) frame->Stepping();
         continue;
       }
@@ -4127,6 +4714,13 @@ namespace kagami {
         
         if (command->first.GetKeywordValue() == kKeywordReturn) refresh_tick();
         if (frame->error) break;
+
+        if (frame->callback_driver != nullptr) {
+          resume_callback();
+          if (frame->error) break;
+          continue;
+        }
+
         if (!frame->stop_point) frame->Stepping();
         continue;
       }
@@ -4138,13 +4732,14 @@ namespace kagami {
         //Query function(Interpreter built-in or user-defined)
         //error string will be generated in FetchFunctionImpl.
         if (command->first.type == kRequestFunction) {
-          wrapped = BuiltinContainerAction(*command);
+          ObjectView domain_view;
+          wrapped = BuiltinContainerAction(*command, domain_view);
           if (frame->error) break;
           if (wrapped) {
             frame->Stepping();
             continue;
           }
-          else if (!FetchFunctionImpl(impl, command, obj_map)) {
+          else if (!FetchFunctionImpl(impl, command, obj_map, domain_view)) {
             break;
           }
         }
@@ -4168,6 +4763,16 @@ namespace kagami {
           if (next_tick) continue;
         }
 
+        //Script callback of higher-order builtin, driven by this loop
+        if (msg.IsDrivingRequest()) {
+          frame->callback_driver = static_pointer_cast<CallbackDriver>(msg.GetPtr());
+          frame->callback_driver->caller_void_call = frame->void_call;
+          frame->callback_driver->caller_stack_base = frame->return_stack.size();
+          frame->void_call = false;
+          drive_callback();
+          continue;
+        }
+
         //Pushing returning value to returning stack.
         if (msg.HasObject()) frame->RefreshReturnStack(msg.GetObjectInfo(), msg.GetPtr());
         else frame->RefreshReturnStack(Object());
@@ -4182,6 +4787,11 @@ namespace kagami {
         logger_, script_idx);
     }
 
+    if (allocation_accounting && is_logger_host_ && !invoke) {
+      DumpAllocationStats();
+    }
+
     error_ = frame->error;
+    running_machine = last_running_machine;
   }
 }
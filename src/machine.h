@@ -190,6 +190,113 @@ namespace kagami {
   using EventHandlerMark = pair<Uint32, Uint32>;
   using EventHandler = pair<EventHandlerMark, FunctionImpl>;
 
+  //Counter of range-for loop, kept outside of object stack
+  struct RangeCounter {
+    string unit_id;
+    int64_t current;
+    int64_t stop;
+    int64_t step;
+  };
+
+  //Position of for-each loop over sequence type, index is checked against
+  //size on each step so appending elements in loop body is safe
+  template <typename SequenceType>
+  struct SequenceCursor {
+    SequenceType *base;
+    size_t index;
+  };
+
+  template <typename TableType>
+  struct TableCursor {
+    TableType *base;
+    typename TableType::iterator current;
+  };
+
+  using CursorPosition = variant<monostate,
+    SequenceCursor<ObjectArray>,
+    SequenceCursor<ArraySlice>,
+    SequenceCursor<IntArray>,
+    SequenceCursor<FloatArray>,
+    SequenceCursor<BoolArray>,
+    SequenceCursor<ByteArray>,
+    SequenceCursor<ObjectHeap>,
+    TableCursor<ObjectTable>,
+    TableCursor<SortedTable>,
+    TableCursor<ObjectSet>>;
+
+  //Loop variables of for-each loop over built-in containers
+  enum CursorBinding {
+    kBindElement,
+    kBindValue,
+    kBindKeyValue
+  };
+
+  //Cursor of for-each loop over built-in containers. Elements are bound
+  //as references to stored objects without calling iterator methods.
+  //Position is monostate for containers implemented by script.
+  struct ContainerCursor {
+    Object container; //keep alive
+    CursorPosition position;
+    CursorBinding binding = kBindElement;
+  };
+
+  enum CallbackDriverKind {
+    kDriverMap,
+    kDriverFilter,
+    kDriverReduce,
+    kDriverAny,
+    kDriverAll,
+    kDriverSortBy
+  };
+
+  //State of higher-order builtin over array elements. C++ callbacks are
+  //called in place, script callbacks are called by pushing a frame per
+  //element from main loop of machine without entering Run() again.
+  class CallbackDriver {
+  public:
+    //Access to source container, selected by its type
+    using SizeGetter = size_t(*)(Object &);
+    using ElementGetter = Object(*)(Object &, size_t);
+
+  private:
+    CallbackDriverKind kind_;
+    Object source_; //keep alive
+    SizeGetter size_getter_;
+    ElementGetter element_getter_;
+    Object callback_;
+    Object current_;
+    Object accumulator_;
+    ObjectArray results_;
+    vector<SortKey> keys_;
+    size_t idx_;
+    size_t end_;
+    bool finished_;
+    string msg_;
+
+  public:
+    //Caller state saved while script callback is running
+    bool caller_void_call;
+    size_t caller_stack_base;
+
+    //Type of source must be accepted by SelectSourceAccess()
+    CallbackDriver(CallbackDriverKind kind, Object &source, Object &callback,
+      Object &init, size_t start);
+
+    static bool SelectSourceAccess(const string &type_id,
+      SizeGetter &size_getter, ElementGetter &element_getter);
+
+    //Build arguments of next calling, returns false if there's nothing to do
+    bool Prepare(ObjectMap &args);
+    //Consume returning value of last calling, returns false on error
+    bool Feed(Object &value);
+    Object GetResult();
+
+    FunctionImpl &GetImpl() { return callback_.Cast<FunctionImpl>(); }
+    const string &GetMessage() const { return msg_; }
+  };
+
+  using ManagedDriver = shared_ptr<CallbackDriver>;
+
   class RuntimeFrame {
   public:
     bool error;
@@ -220,9 +327,10 @@ namespace kagami {
     string super_struct_id;
     stack<bool> condition_stack; //preserved
     stack<bool> scope_stack;
-    stack<size_t> jump_stack;
-    stack<size_t> branch_jump_stack;
+    stack<RangeCounter> range_stack;
+    stack<ContainerCursor> cursor_stack;
     vector<ObjectCommonSlot> return_stack;
+    ManagedDriver callback_driver;
 
     RuntimeFrame(string scope = kStrRootScope) :
       error(false),
@@ -251,14 +359,14 @@ namespace kagami {
       struct_id(),
       super_struct_id(),
       condition_stack(),
-      jump_stack(),
-      branch_jump_stack(),
-      return_stack() {}
+      range_stack(),
+      cursor_stack(),
+      return_stack(),
+      callback_driver() {}
 
     void Stepping();
     void Goto(size_t taget_idx);
 
-    void AddJumpRecord(size_t target_idx);
     void MakeError(string str);
     void MakeWarning(string str);
     void RefreshReturnStack(Object &obj);
@@ -290,7 +398,30 @@ namespace kagami {
     }
   };
 
-  using FrameStack = stack<RuntimeFrame, vector<RuntimeFrame>>;
+  //Frames are not relocated by push, references to outer frames stay valid
+  //while native code is calling function objects
+  using FrameStack = stack<RuntimeFrame, deque<RuntimeFrame>>;
+
+  //Native handler of built-in method. Machine passes domain object and views
+  //of arguments without building ObjectMap, and handler pushes returning
+  //value into return stack of frame directly.
+  using IntrinsicHandler = void(*)(Object &me, ObjectView *args, RuntimeFrame &frame);
+
+  const size_t kMaxIntrinsicArity = 2;
+
+  struct IntrinsicImpl {
+    string id;
+    string type_id;
+    size_t arity;
+    IntrinsicHandler handler;
+  };
+
+  using IntrinsicGroup = vector<IntrinsicImpl>;
+
+  //Register intrinsics from component initializers
+  void CreateIntrinsics(initializer_list<IntrinsicImpl> &&impls);
+  //Intrinsics sharing the same method id, or nullptr
+  IntrinsicGroup *FindIntrinsicGroup(SymbolId id);
 
   struct _IgnoredException : std::exception {};
   struct _CustomError : std::exception {
@@ -367,39 +498,47 @@ namespace kagami {
     bool IsTailRecursion(size_t idx, VMCode *code);
     bool IsTailCall(size_t idx);
 
-    Object *FetchLiteralObject(Argument &arg);
-    Object FetchFunctionObject(string id);
+    Object *FetchLiteralObject(const Argument &arg);
+    Object FetchFunctionObject(SymbolId id);
     //deprecated
-    Object FetchObject(Argument &arg);
-    ObjectView FetchObjectView(Argument &arg);
+    Object FetchObject(const Argument &arg);
+    ObjectView FetchObjectView(const Argument &arg);
 
     bool FetchFunctionImplEx(FunctionImplPointer &dest, string id, string type_id = kTypeIdNull, 
       Object *obj_ptr = nullptr);
 
+    //domain_view is domain object fetched by BuiltinContainerAction, if it's valid
     bool FetchFunctionImpl(FunctionImplPointer &impl, CommandPointer &command,
-      ObjectMap &obj_map);
+      ObjectMap &obj_map, ObjectView &domain_view);
 
     void CheckDomainObject(FunctionImpl &impl, Request &req, bool first_assert);
     void CheckArgrumentList(FunctionImpl &impl, ArgumentList &args);
     void ClosureCatching(ArgumentList &args, size_t nest_end, bool closure);
+    //Load script module and bind its exports into root scope.
+    //Modules which are already in 'bound' are skipped.
+    bool LoadModule(const string &path, ObjectContainer &root, unordered_set<string> &bound);
 
     Message CallMethod(Object &obj, string id, ObjectMap &args);
     Message CallMethod(Object &obj, string id,
       const initializer_list<NamedObject> &&args = {});
     Message CallVMCFunction(FunctionImpl &impl, ObjectMap &obj_map);
 
-    void CommandIfOrWhile(Keyword token, ArgumentList &args, size_t nest_end);
+    void CommandIfOrWhile(Keyword token, ArgumentList &args, size_t nest_end, size_t jump_target);
     void CommandForEach(ArgumentList &args, size_t nest_end);
     void ForEachChecking(ArgumentList &args, size_t nest_end);
-    void CommandCase(ArgumentList &args, size_t nest_end);
-    void CommandElse();
-    void CommandWhen(ArgumentList &args);
-    void CommandContinueOrBreak(Keyword token, size_t escape_depth);
+    void BindCursorUnits(ArgumentList &args, ContainerCursor &cursor);
+    void CommandForRange(ArgumentList &args, size_t nest_end);
+    void ForRangeChecking(ArgumentList &args, size_t nest_end);
+    void CommandCase(ArgumentList &args, size_t jump_target);
+    void CommandElse(size_t nest_end);
+    void CommandWhen(ArgumentList &args, size_t nest_end, size_t jump_target);
+    void CommandContinueOrBreak(Keyword token, size_t escape_depth, size_t nest_end);
     void CommandStructBegin(ArgumentList &args);
     void CommandModuleBegin(ArgumentList &args);
     void CommandConditionEnd();
     void CommandLoopEnd(size_t nest);
-    void CommandForEachEnd(size_t nest);
+    void CommandForEachEnd(size_t loop_idx);
+    void CommandForRangeEnd(size_t loop_idx);
     void CommandStructEnd();
     void CommandModuleEnd();
     void CommandInclude(ArgumentList &args);
@@ -428,11 +567,13 @@ namespace kagami {
     void CommandVersion();
     void CommandMachineCodeName();
 
+    //operand_type is inferred plain type of both operands(RequestOption::operand_type),
+    //it is checked against actual operands before taking the fast path
     template <Keyword op_code>
-    void BinaryMathOperatorImpl(ArgumentList &args);
+    void BinaryMathOperatorImpl(ArgumentList &args, PlainType operand_type = kNotPlainType);
 
     template <Keyword op_code>
-    void BinaryLogicOperatorImpl(ArgumentList &args);
+    void BinaryLogicOperatorImpl(ArgumentList &args, PlainType operand_type = kNotPlainType);
 
     void OperatorIncreasing(ArgumentList &args);
     void OperatorDecreasing(ArgumentList &args);
@@ -464,11 +605,12 @@ namespace kagami {
     void LoadEventInfo(SDL_Event &event, ObjectMap &obj_map, FunctionImpl &impl, Uint32 id);
     void CallExtensionFunction(ObjectMap &p, FunctionImpl &impl);
     //void CallExtensionFunctionEx
-    bool BuiltinContainerAction(Command &command);
+    bool BuiltinContainerAction(Command &command, ObjectView &domain_view);
 
     void GenerateStructInstance(ObjectMap &p);
 
     void GenerateErrorMessages(size_t stop_index);
+    void DumpAllocationStats();
   private:
     struct ImplCacheHash {
       size_t operator()(size_t const &rhs) const {
@@ -541,8 +683,14 @@ namespace kagami {
 
     void Run(bool invoke = false);
 
+    //Call function object with positional arguments from native code
+    Message CallFunctionObject(Object &func, vector<Object> &args);
+
     bool ErrorOccurred() const {
       return error_;
     }
   };
+
+  //Function object calling for native code, handled by innermost running machine
+  Message InvokeFunctionObject(Object &func, vector<Object> &args);
 }
@@ -19,7 +19,7 @@ namespace kagami::management {
     auto &col = GetFunctionImplCollections().at(domain);
 
     for (auto &unit : col) {
-      base[domain].insert(make_pair(unit.first, &unit.second));
+      base[domain].insert(make_pair(InternSymbol(unit.first), &unit.second));
     }
   }
 
@@ -39,6 +39,12 @@ namespace kagami::management {
   }
 
   FunctionImpl *FindFunction(string id, string domain) {
+    auto symbol = FindSymbol(id);
+    if (symbol == kSymbolNull) return nullptr;
+    return FindFunction(symbol, domain);
+  }
+
+  FunctionImpl *FindFunction(SymbolId id, const string &domain) {
     auto &cache = GetFunctionImplCache();
     auto it = cache.find(domain);
 
@@ -67,7 +73,7 @@ namespace kagami::management {
     lock_guard<mutex> guard(constant_creation_gate);
     ObjectContainer &base = GetConstantBase();
 
-    if (base.Find(id) != nullptr) return nullptr;
+    if (auto *ptr = base.Find(id); ptr != nullptr) return ptr;
 
     base.Add(id, object);
     auto result = base.Find(id);
@@ -78,14 +84,14 @@ namespace kagami::management {
     lock_guard<mutex> guard(constant_creation_gate);
     ObjectContainer &base = GetConstantBase();
 
-    if (base.Find(id) != nullptr) return nullptr;
+    if (auto *ptr = base.Find(id); ptr != nullptr) return ptr;
 
     base.Add(id, std::move(object));
     auto result = base.Find(id);
     return result;
   }
 
-  Object *GetConstantObject(string &id) {
+  Object *GetConstantObject(SymbolId id) {
     ObjectContainer &base = GetConstantBase();
     auto ptr = base.Find(id);
     return ptr;
@@ -203,7 +209,13 @@ namespace kagami::management::type {
     }
     else if (it != GetObjectTraitsCollection().end()) {
       auto deliver = it->second.GetDeliveringImpl();
-      result.PackContent(deliver(object.Get()), object.GetTypeId());
+      auto ptr = deliver(object.Get());
+
+      if (allocation_accounting && deliver != ShallowDelivery) {
+        ptr = accounting::TrackAllocation(ptr, object.GetTypeId(), 0);
+      }
+
+      result.PackContent(ptr, object.GetTypeId());
     }
 
     return result;
@@ -263,7 +275,12 @@ namespace kagami::management::type {
   }
 
   ObjectTraitsSetup &ObjectTraitsSetup::InitMethods(initializer_list<FunctionImpl> && rhs) {
-    impl_ = rhs;
+    impl_.clear();
+    return AppendMethods(std::move(rhs));
+  }
+
+  ObjectTraitsSetup &ObjectTraitsSetup::AppendMethods(initializer_list<FunctionImpl> &&rhs) {
+    impl_.insert(impl_.end(), rhs.begin(), rhs.end());
     string method_list("");
 
     for (auto &unit : impl_) {
@@ -278,7 +295,8 @@ namespace kagami::management::type {
   }
 
   ObjectTraitsSetup::~ObjectTraitsSetup() {
-    CreateObjectTraits(type_id_, ObjectTraits(delivering_impl_, methods_, hasher_, comparator_));
+    CreateObjectTraits(type_id_, 
+      ObjectTraits(delivering_impl_, methods_, hasher_, comparator_, sizer_));
     CreateImpl(delivering_);
     for (auto &unit : impl_) {
       CreateImpl(unit, type_id_);
@@ -286,6 +304,119 @@ namespace kagami::management::type {
   }
 }
 
+namespace kagami::management::accounting {
+  struct AllocationRecord;
+
+  /* Owner of tracked payload, linked into the record of its type */
+  struct AllocationGuard {
+    shared_ptr<void> ptr;
+    AllocationRecord *record;
+    size_t size;
+    SizerFunction sizer;
+    AllocationGuard *prev;
+    AllocationGuard *next;
+
+    ~AllocationGuard();
+  };
+
+  struct AllocationRecord {
+    size_t count;
+    size_t unit_size;
+    AllocationGuard *head;
+  };
+
+  static mutex accounting_gate;
+  static int64_t dump_interval = 0;
+  static std::chrono::steady_clock::time_point last_dump;
+
+  //Never released, payloads of constant objects can be destroyed after this
+  auto &GetAllocationRecords() {
+    static auto *records = new unordered_map<string, AllocationRecord>();
+    return *records;
+  }
+
+  AllocationGuard::~AllocationGuard() {
+    lock_guard<mutex> guard(accounting_gate);
+    if (prev != nullptr) prev->next = next;
+    else record->head = next;
+    if (next != nullptr) next->prev = prev;
+    record->count -= 1;
+  }
+
+  shared_ptr<void> TrackAllocation(shared_ptr<void> ptr, const string &type_id,
+    size_t size, SizerFunction sizer) {
+    if (ptr == nullptr) return ptr;
+
+    auto *raw_ptr = ptr.get();
+    auto guard = make_shared<AllocationGuard>();
+    lock_guard<mutex> lock(accounting_gate);
+    auto &record = GetAllocationRecords()[type_id];
+
+    if (size != 0) record.unit_size = size;
+
+    guard->ptr = std::move(ptr);
+    guard->record = &record;
+    guard->size = size;
+    guard->sizer = sizer;
+    guard->prev = nullptr;
+    guard->next = record.head;
+    if (record.head != nullptr) record.head->prev = guard.get();
+    record.head = guard.get();
+    record.count += 1;
+
+    //Aliasing pointer, payload is released with the guard
+    return shared_ptr<void>(guard, raw_ptr);
+  }
+
+  void EnableAccounting(int64_t interval) {
+    allocation_accounting = true;
+    dump_interval = interval;
+    last_dump = std::chrono::steady_clock::now();
+  }
+
+  bool IsDumpRequired() {
+    if (dump_interval <= 0) return false;
+
+    auto now = std::chrono::steady_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(now - last_dump);
+
+    if (duration.count() < dump_interval) return false;
+
+    last_dump = now;
+    return true;
+  }
+
+  vector<AllocationStat> CollectAllocationStats() {
+    vector<AllocationStat> result;
+    auto &traits = type::GetObjectTraitsCollection();
+    lock_guard<mutex> lock(accounting_gate);
+
+    for (auto &unit : GetAllocationRecords()) {
+      if (unit.second.count == 0) continue;
+
+      auto it = traits.find(unit.first);
+      auto type_sizer = it != traits.end() ? it->second.GetSizer() : nullptr;
+      AllocationStat stat{ unit.first, unit.second.count, 0 };
+
+      for (auto *guard = unit.second.head; guard != nullptr; guard = guard->next) {
+        if (type_sizer != nullptr) stat.bytes += type_sizer(guard->ptr);
+        else if (guard->sizer != nullptr) stat.bytes += guard->sizer(guard->ptr);
+        else if (guard->size != 0) stat.bytes += guard->size;
+        else stat.bytes += unit.second.unit_size;
+      }
+
+      result.emplace_back(stat);
+    }
+
+    std::sort(result.begin(), result.end(), 
+      [](const AllocationStat &lhs, const AllocationStat &rhs) -> bool {
+        return lhs.bytes > rhs.bytes;
+      });
+
+    return result;
+  }
+}
+
 namespace kagami::management::script {
   mutex script_storage_gate;
 
@@ -337,6 +468,32 @@ namespace kagami::management::script {
 
     return it->second;
   }
+
+  static mutex module_storage_gate;
+
+  ModuleStorage &GetModuleStorage() {
+    static ModuleStorage storage;
+    return storage;
+  }
+
+  ModuleUnit *FindModule(string path) {
+    lock_guard<mutex> guard(module_storage_gate);
+    auto &storage = GetModuleStorage();
+    auto it = storage.find(path);
+
+    if (it != storage.end()) return &(it->second);
+
+    return nullptr;
+  }
+
+  ModuleUnit &AppendModule(string path, ModuleUnit &&module) {
+    lock_guard<mutex> guard(module_storage_gate);
+    auto &storage = GetModuleStorage();
+    //Keep the first one if another VM has loaded the same module
+    auto result = storage.emplace(path, std::move(module));
+
+    return result.first->second;
+  }
 }
 
 namespace kagami::management::extension {
@@ -394,9 +551,44 @@ namespace kagami::management::extension {
   }
 
   size_t GetArrayObjectCapacity(Descriptor desc) {
-    if (desc.type != kExtTypeArray) return 0;
     auto &arr = *static_cast<Object *>(desc.ptr);
-    return arr.Cast<ObjectArray>().size();
+    size_t result = 0;
+
+    switch (desc.type) {
+    case kExtTypeArray:result = arr.Cast<ObjectArray>().size(); break;
+    case kExtTypeIntArray:result = arr.Cast<IntArray>().size(); break;
+    case kExtTypeFloatArray:result = arr.Cast<FloatArray>().size(); break;
+    case kExtTypeBoolArray:result = arr.Cast<BoolArray>().size(); break;
+    default:break;
+    }
+
+    return result;
+  }
+
+  //Expose packed array storage as raw buffer(no copy)
+  // -1 : type mismatch
+  // 1 : success
+  int FetchArrayBuffer(Descriptor *arr_desc, void **dest, size_t *size) {
+    auto &arr = *static_cast<Object *>(arr_desc->ptr);
+
+    switch (arr_desc->type) {
+    case kExtTypeIntArray:
+      *dest = arr.Cast<IntArray>().data();
+      *size = arr.Cast<IntArray>().size();
+      break;
+    case kExtTypeFloatArray:
+      *dest = arr.Cast<FloatArray>().data();
+      *size = arr.Cast<FloatArray>().size();
+      break;
+    case kExtTypeBoolArray:
+      *dest = arr.Cast<BoolArray>().data();
+      *size = arr.Cast<BoolArray>().size();
+      break;
+    default:
+      return -1;
+    }
+
+    return 1;
   }
 
   template <typename _Type>
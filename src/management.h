@@ -2,18 +2,23 @@
 #include "function.h"
 #include "extension.h"
 #include "filestream.h"
+#include "table.h"
+#include "btree.h"
+#include "collections.h"
 
 namespace kagami::management {
   using FunctionImplCollection = map<string, FunctionImpl>;
-  using FunctionHashMap = unordered_map<string, FunctionImpl *>;
+  using FunctionHashMap = unordered_map<SymbolId, FunctionImpl *>;
   
 
   void CreateImpl(FunctionImpl impl, string domain = kTypeIdNull);
   FunctionImpl *FindFunction(string id, string domain = kTypeIdNull);
+  FunctionImpl *FindFunction(SymbolId id, const string &domain = kTypeIdNull);
 
+  //Existing constant is kept and returned if id is already used
   Object *CreateConstantObject(string id, Object &object);
   Object *CreateConstantObject(string id, Object &&object);
-  Object *GetConstantObject(string &id);
+  Object *GetConstantObject(SymbolId id);
 
   bool IsAlive(initializer_list<Object> &&objects);
 }
@@ -46,6 +51,7 @@ namespace kagami::management::type {
     DeliveryImpl delivering_impl_;
     Comparator comparator_;
     HasherFunction hasher_;
+    SizerFunction sizer_;
     vector<FunctionImpl> impl_;
     FunctionImpl delivering_;  //deprecated
 
@@ -59,11 +65,12 @@ namespace kagami::management::type {
       type_id_(type_name),
       delivering_impl_(dlvy),
       comparator_(nullptr),
-      hasher_(hasher) {}
+      hasher_(hasher),
+      sizer_(nullptr) {}
 
     ObjectTraitsSetup(string type_name, DeliveryImpl dlvy) :
       type_id_(type_name), delivering_impl_(dlvy), 
-      comparator_(nullptr), hasher_(nullptr) {}
+      comparator_(nullptr), hasher_(nullptr), sizer_(nullptr) {}
 
     //TODO:multi constructor injector
     ObjectTraitsSetup &InitConstructor(FunctionImpl impl) {
@@ -75,11 +82,28 @@ namespace kagami::management::type {
       comparator_ = comparator; return *this; 
     }
 
+    ObjectTraitsSetup &InitSizer(SizerFunction sizer) {
+      sizer_ = sizer; return *this;
+    }
+
     ObjectTraitsSetup &InitMethods(initializer_list<FunctionImpl> &&rhs);
+    ObjectTraitsSetup &AppendMethods(initializer_list<FunctionImpl> &&rhs);
     ~ObjectTraitsSetup();
   };
 }
 
+namespace kagami::management::accounting {
+  struct AllocationStat {
+    string type_id;
+    size_t count;
+    size_t bytes;
+  };
+
+  void EnableAccounting(int64_t dump_interval);
+  bool IsDumpRequired();
+  vector<AllocationStat> CollectAllocationStats();
+}
+
 namespace kagami::management::script {
   using ProcessedScript = pair<string, VMCode>;
   using ScriptStorage = unordered_map<string, VMCode>;
@@ -87,6 +111,29 @@ namespace kagami::management::script {
   VMCode *FindScriptByPath(string path);
   VMCode &AppendScript(string path, VMCode &code);
   VMCode &AppendBlankScript(string path);
+
+  /* Binding made by top level of module, in order of execution */
+  struct ModuleBinding {
+    string id;
+    Object obj;
+    SymbolId symbol;
+    //id is the path of another module which is loaded here
+    bool import;
+    //Line index in module script
+    size_t idx;
+  };
+
+  /* Compiled module and its export table */
+  struct ModuleUnit {
+    VMCode *code;
+    vector<ModuleBinding> exports;
+  };
+
+  using ModuleStorage = unordered_map<string, ModuleUnit>;
+
+  //Modules are shared by all VM instances in this process
+  ModuleUnit *FindModule(string path);
+  ModuleUnit &AppendModule(string path, ModuleUnit &&module);
 }
 
 namespace kagami::management::extension {
@@ -94,6 +141,7 @@ namespace kagami::management::extension {
   int FetchDescriptor(Descriptor *descriptor, void *obj_map, const char *id);
   int FetchArrayElementDescriptor(Descriptor *arr_desc, Descriptor *dest, size_t index);
   size_t GetArrayObjectCapacity(Descriptor desc);
+  int FetchArrayBuffer(Descriptor *arr_desc, void **dest, size_t *size);
   int DumpObjectFromDescriptor(Descriptor *descriptor, void **dest);
   int FetchObjectType(void *obj_map, const char *id);
 }
@@ -140,8 +188,10 @@ namespace std {
 }
 
 namespace kagami {
-  using ObjectTable = unordered_map<Object, Object>;
   using ManagedTable = shared_ptr<ObjectTable>;
+  using ManagedSortedTable = shared_ptr<SortedTable>;
+  using ManagedSet = shared_ptr<ObjectSet>;
+  using ManagedHeap = shared_ptr<ObjectHeap>;
 }
 
 namespace mgmt = kagami::management;
@@ -17,6 +17,7 @@ namespace kagami {
   class Message {
   private:
     bool invoking_msg_;
+    bool driving_msg_;
     StateLevel level_;
     string detail_;
     optional<ObjectPrototype> slot_;
@@ -25,6 +26,7 @@ namespace kagami {
   public:
     Message() :
       invoking_msg_(false),
+      driving_msg_(false),
       level_(kStateNormal), 
       detail_(""), 
       slot_(std::nullopt),
@@ -32,6 +34,7 @@ namespace kagami {
 
     Message(Message &msg) :
       invoking_msg_(msg.invoking_msg_),
+      driving_msg_(msg.driving_msg_),
       level_(msg.level_),
       detail_(msg.detail_),
       slot_(msg.slot_),
@@ -39,6 +42,7 @@ namespace kagami {
 
     Message(Message &&msg) :
       invoking_msg_(msg.invoking_msg_),
+      driving_msg_(msg.driving_msg_),
       level_(msg.level_),
       detail_(std::forward<string>(msg.detail_)),
       slot_(std::forward<optional<ObjectPrototype>>(msg.slot_)),
@@ -46,12 +50,14 @@ namespace kagami {
 
     Message(string detail, StateLevel level = kStateNormal) :
       invoking_msg_(false),
+      driving_msg_(false),
       level_(level), 
       detail_(detail), 
       idx_(0) {}
 
     Message &operator=(Message &msg) {
       invoking_msg_ = msg.invoking_msg_;
+      driving_msg_ = msg.driving_msg_;
       level_ = msg.level_;
       detail_ = msg.detail_;
       slot_ = msg.slot_;
@@ -68,6 +74,7 @@ namespace kagami {
     size_t GetIndex() const { return idx_; }
     bool HasObject() const { return slot_.has_value(); }
     bool IsInvokingRequest() const { return invoking_msg_; }
+    bool IsDrivingRequest() const { return driving_msg_; }
 
     Object GetObj() const {
       if (slot_.has_value()) {
@@ -155,6 +162,17 @@ namespace kagami {
       return this->SetInvokingSign(obj);
     }
 
+    //Object holds callback driver which is taken over by machine
+    Message &SetDrivingSign(Object &obj) {
+      SetObject(obj);
+      driving_msg_ = true;
+      return *this;
+    }
+
+    Message &SetDrivingSign(Object &&obj) {
+      return this->SetDrivingSign(obj);
+    }
+
     void Clear() {
       level_ = kStateNormal;
       detail_.clear();
@@ -1,6 +1,69 @@
 #include "object.h"
+#include "kernels.h"
 
 namespace kagami {
+  bool allocation_accounting = false;
+
+  //Data is valid UTF-8, lead byte is enough to determine sequence length
+  inline size_t SequenceLength(char lead) {
+    auto value = static_cast<uint8_t>(lead);
+    if (value < 0x80) return 1;
+    if (value < 0xE0) return 2;
+    if (value < 0xF0) return 3;
+    return 4;
+  }
+
+  UTF8String::UTF8String(string data) :
+    data_(std::move(data)), length_(0), index_() {
+    length_ = kernel::CountCodePoints(data_.data(), data_.size());
+  }
+
+  void UTF8String::BuildIndex() {
+    index_.reserve(length_ / kIndexStride + 1);
+    size_t count = 0;
+
+    for (size_t offset = 0; offset < data_.size(); offset += SequenceLength(data_[offset])) {
+      if (count % kIndexStride == 0) index_.push_back(offset);
+      ++count;
+    }
+  }
+
+  size_t UTF8String::Offset(size_t idx) {
+    if (IsASCII()) return idx;
+    if (idx >= length_) return data_.size();
+    if (index_.empty()) BuildIndex();
+
+    size_t offset = index_[idx / kIndexStride];
+    for (size_t count = idx % kIndexStride; count > 0; --count) {
+      offset += SequenceLength(data_[offset]);
+    }
+
+    return offset;
+  }
+
+  string_view UTF8String::At(size_t idx) {
+    size_t offset = Offset(idx);
+    return string_view(data_).substr(offset, SequenceLength(data_[offset]));
+  }
+
+  string_view UTF8String::Sub(size_t start, size_t length) {
+    size_t begin = Offset(start);
+    size_t end = Offset(start + length);
+    return string_view(data_).substr(begin, end - begin);
+  }
+
+  uint32_t UTF8String::CodePointAt(size_t idx) {
+    auto sequence = At(idx);
+    auto lead = static_cast<uint8_t>(sequence[0]);
+    uint32_t result = sequence.size() == 1 ? lead : lead & (0x7F >> sequence.size());
+
+    for (size_t pos = 1; pos < sequence.size(); ++pos) {
+      result = (result << 6) | (static_cast<uint8_t>(sequence[pos]) & 0x3F);
+    }
+
+    return result;
+  }
+
   vector<string> BuildStringVector(string source) {
     vector<string> result;
     string temp;
@@ -25,6 +88,45 @@ namespace kagami {
     return result;
   }
 
+  struct SymbolTable {
+    shared_mutex gate;
+    unordered_map<string, SymbolId> ids;
+    //Slot 0 is reserved for kSymbolNull
+    deque<string> names = { string() };
+  };
+
+  static SymbolTable &GetSymbolTable() {
+    static SymbolTable table;
+    return table;
+  }
+
+  SymbolId InternSymbol(const string &id) {
+    auto &table = GetSymbolTable();
+    {
+      shared_lock<shared_mutex> guard(table.gate);
+      auto it = table.ids.find(id);
+      if (it != table.ids.end()) return it->second;
+    }
+
+    lock_guard<shared_mutex> guard(table.gate);
+    auto result = table.ids.emplace(id, static_cast<SymbolId>(table.names.size()));
+    if (result.second) table.names.push_back(id);
+    return result.first->second;
+  }
+
+  SymbolId FindSymbol(const string &id) {
+    auto &table = GetSymbolTable();
+    shared_lock<shared_mutex> guard(table.gate);
+    auto it = table.ids.find(id);
+    return it != table.ids.end() ? it->second : kSymbolNull;
+  }
+
+  const string &GetSymbolString(SymbolId id) {
+    auto &table = GetSymbolTable();
+    shared_lock<shared_mutex> guard(table.gate);
+    return id < table.names.size() ? table.names[id] : table.names.front();
+  }
+
   size_t PointerHasher(shared_ptr<void> ptr) {
     auto hasher = std::hash<shared_ptr<void>>();
     return hasher(ptr);
@@ -34,6 +136,14 @@ namespace kagami {
     return target;
   }
 
+  //Tree node and cache entry of every member
+  size_t ContainerSizer(shared_ptr<void> ptr) {
+    auto &base = static_pointer_cast<ObjectContainer>(ptr)->GetContent();
+    size_t node_size = sizeof(pair<const string, Object>) 
+      + sizeof(pair<const SymbolId, ObjectPointer>) + 6 * sizeof(void *);
+    return sizeof(ObjectContainer) + base.size() * node_size;
+  }
+
   Object &Object::operator=(const Object &object) {
     info_ = object.info_;
 
@@ -94,57 +204,74 @@ namespace kagami {
     dest_map_.clear();
     const auto begin = base_.begin(), end = base_.end();
     for (auto it = begin; it != end; ++it) {
-      dest_map_.insert_or_assign(it->first, &it->second);
+      dest_map_.insert_or_assign(InternSymbol(it->first), &it->second);
     }
   }
 
-  void ObjectContainer::AppendRecent(const string &id, ObjectPointer ptr) {
+  void ObjectContainer::AppendRecent(SymbolId id, ObjectPointer ptr) {
     if (recent_.size() >= 5) recent_.pop_back();
     if (!recent_.empty() && recent_.front().first == id) return;
     recent_.emplace_front(ObjectCache(id, ptr));
   }
 
-  bool ObjectContainer::Add(string id, Object &source) {
-    if (IsDelegated()) return delegator_->Add(id, source);
+  inline SymbolId GetBindingSymbol(const string &id, SymbolId symbol) {
+    return symbol != kSymbolNull ? symbol : InternSymbol(id);
+  }
+
+  bool ObjectContainer::Add(string id, Object &source, SymbolId symbol) {
+    if (IsDelegated()) return delegator_->Add(id, source, symbol);
 
     if (CheckObject(id)) return false;
     auto result = base_.emplace(NamedObject(id, source));
     if (result.second) {
-      dest_map_.insert_or_assign(id, &result.first->second);
-      dest_map_.rehash(0);
+      dest_map_.insert_or_assign(GetBindingSymbol(id, symbol), &result.first->second);
     }
 
     return true;
   }
 
-  bool ObjectContainer::Add(string id, Object &&source) {
-    if (IsDelegated()) return delegator_->Add(id, std::move(source));
+  bool ObjectContainer::Add(string id, Object &&source, SymbolId symbol) {
+    if (IsDelegated()) return delegator_->Add(id, std::move(source), symbol);
 
     if (CheckObject(id)) return false;
     auto result = base_.emplace(NamedObject(id, std::move(source)));
     if (result.second) {
-      dest_map_.insert_or_assign(id, &result.first->second);
-      dest_map_.rehash(0);
+      dest_map_.insert_or_assign(GetBindingSymbol(id, symbol), &result.first->second);
     }
 
     return true;
   }
 
-  void ObjectContainer::Replace(string id, Object &source) {
-    if (IsDelegated()) delegator_->Replace(id, source);
+  void ObjectContainer::Replace(string id, Object &source, SymbolId symbol) {
+    if (IsDelegated()) {
+      delegator_->Replace(id, source, symbol);
+      return;
+    }
 
-    base_[id] = source;
-    dest_map_[id] = &base_[id];
+    auto &dest = base_[id];
+    dest = source;
+    dest_map_[GetBindingSymbol(id, symbol)] = &dest;
   }
 
-  void ObjectContainer::Replace(string id, Object &&source) {
-    if (IsDelegated()) delegator_->Replace(id, std::move(source));
+  void ObjectContainer::Replace(string id, Object &&source, SymbolId symbol) {
+    if (IsDelegated()) {
+      delegator_->Replace(id, std::move(source), symbol);
+      return;
+    }
 
-    base_[id] = source;
-    dest_map_[id] = &base_[id];
+    auto &dest = base_[id];
+    dest = std::move(source);
+    dest_map_[GetBindingSymbol(id, symbol)] = &dest;
   }
 
   Object *ObjectContainer::Find(const string &id, bool forward_seeking) {
+    //Names which are never interned can't be bound in any container
+    auto symbol = FindSymbol(id);
+    if (symbol == kSymbolNull) return nullptr;
+    return Find(symbol, forward_seeking);
+  }
+
+  Object *ObjectContainer::Find(SymbolId id, bool forward_seeking) {
     if (IsDelegated()) return delegator_->Find(id, forward_seeking);
     ObjectPointer ptr = nullptr;
 
@@ -171,8 +298,8 @@ namespace kagami {
     return ptr;
   }
 
-  Object *ObjectContainer::FindWithDomain(const string &id, 
-    const string &domain, bool forward_seeking) {
+  Object *ObjectContainer::FindWithDomain(SymbolId id, 
+    SymbolId domain, bool forward_seeking) {
     if (IsDelegated()) return delegator_->FindWithDomain(id, domain, forward_seeking);
   
     if (base_.empty() && prev_ == nullptr) return nullptr;
@@ -255,6 +382,12 @@ namespace kagami {
   }
 
   Object *ObjectStack::Find(const string &id) {
+    auto symbol = FindSymbol(id);
+    if (symbol == kSymbolNull) return nullptr;
+    return Find(symbol);
+  }
+
+  Object *ObjectStack::Find(SymbolId id) {
     if (base_.empty() && prev_ == nullptr) return nullptr;
     ObjectPointer ptr = base_.back().Find(id);
 
@@ -265,7 +398,7 @@ namespace kagami {
     return ptr;
   }
 
-  Object *ObjectStack::Find(const string &id, const string &domain) {
+  Object *ObjectStack::Find(SymbolId id, SymbolId domain) {
     if (base_.empty() && prev_ == nullptr) return nullptr;
     ObjectPointer ptr = base_.back().FindWithDomain(id, domain);
 
@@ -276,7 +409,7 @@ namespace kagami {
     return ptr;
   }
 
-  bool ObjectStack::CreateObject(string id, Object &obj) {
+  bool ObjectStack::CreateObject(string id, Object &obj, SymbolId symbol) {
     if (!creation_info_.empty() && !creation_info_.top().first) {
       ScopeCreation(creation_info_.top().second);
       creation_info_.top().first = true;
@@ -286,14 +419,14 @@ namespace kagami {
       if (prev_ == nullptr) {
         return false;
       }
-      return prev_->CreateObject(id, obj);
+      return prev_->CreateObject(id, obj, symbol);
     }
     auto &top = base_.back();
 
-    return top.Add(id, obj);
+    return top.Add(id, obj, symbol);
   }
 
-  bool ObjectStack::CreateObject(string id, Object &&obj) {
+  bool ObjectStack::CreateObject(string id, Object &&obj, SymbolId symbol) {
     if (!creation_info_.empty() && !creation_info_.top().first) {
       ScopeCreation(creation_info_.top().second);
       creation_info_.top().first = true;
@@ -303,10 +436,10 @@ namespace kagami {
       if (prev_ == nullptr) {
         return false;
       }
-      return prev_->CreateObject(id, std::move(obj));
+      return prev_->CreateObject(id, std::move(obj), symbol);
     }
     auto &top = base_.back();
     
-    return top.Add(id, std::move(obj));
+    return top.Add(id, std::move(obj), symbol);
   }
 }
\ No newline at end of file
@@ -27,6 +27,19 @@ namespace kagami {
   vector<string> BuildStringVector(string source);
   string CombineStringVector(vector<string> target);
 
+  /*
+    Interned identifiers.
+    Ids are process-local and never released. Interning is thread-safe,
+    so frontend threads can intern names while parsing.
+  */
+  using SymbolId = uint32_t;
+  const SymbolId kSymbolNull = 0;
+
+  SymbolId InternSymbol(const string &id);
+  //Returns kSymbolNull if id is never interned
+  SymbolId FindSymbol(const string &id);
+  const string &GetSymbolString(SymbolId id);
+
   enum ObjectMode {
     kObjectNormal    = 1,
     kObjectRef       = 2,
@@ -35,6 +48,7 @@ namespace kagami {
   };
 
   using HasherFunction = size_t(*)(shared_ptr<void>);
+  using SizerFunction = size_t(*)(shared_ptr<void>);
 
   template <typename T>
   size_t PlainHasher(shared_ptr<void> ptr) {
@@ -52,11 +66,39 @@ namespace kagami {
 
   shared_ptr<void> ShallowDelivery(shared_ptr<void> target);
 
+  /* Approximate memory size of struct instance */
+  size_t ContainerSizer(shared_ptr<void> ptr);
+
+  /*
+    Allocation accounting hooks.
+    Payloads are only wrapped while accounting is enabled by command line,
+    otherwise the cost is a single flag test.
+  */
+  extern bool allocation_accounting;
+
+  namespace management::accounting {
+    shared_ptr<void> TrackAllocation(shared_ptr<void> ptr, const string &type_id,
+      size_t size, SizerFunction sizer = nullptr);
+  }
+
+  template <typename T>
+  inline shared_ptr<void> AccountedPointer(shared_ptr<T> ptr, const string &type_id) {
+    if (!allocation_accounting) return ptr;
+
+    if constexpr (std::is_same_v<T, ObjectContainer>) {
+      return management::accounting::TrackAllocation(ptr, type_id, 0, ContainerSizer);
+    }
+    else {
+      return management::accounting::TrackAllocation(ptr, type_id, sizeof(T));
+    }
+  }
+
   class ObjectTraits {
   private:
     DeliveryImpl delivering_impl_;
     Comparator comparator_;
     HasherFunction hasher_;
+    SizerFunction sizer_;
     vector<string> methods_;
 
   public:
@@ -66,16 +108,19 @@ namespace kagami {
       DeliveryImpl dlvy,
       string methods,
       HasherFunction hasher = nullptr,
-      Comparator comparator = nullptr) :
+      Comparator comparator = nullptr,
+      SizerFunction sizer = nullptr) :
       delivering_impl_(dlvy),
       comparator_(comparator),
       methods_(BuildStringVector(methods)),
-      hasher_(hasher) {}
+      hasher_(hasher),
+      sizer_(sizer) {}
 
     vector<string> &GetMethods() { return methods_; }
     HasherFunction GetHasher() { return hasher_; }
     Comparator GetComparator() { return comparator_; }
     DeliveryImpl GetDeliveringImpl() { return delivering_impl_; }
+    SizerFunction GetSizer() { return sizer_; }
   };
 
   class ExternalRCContainer {
@@ -164,19 +209,24 @@ namespace kagami {
     template <typename T>
     Object(shared_ptr<T> ptr, string type_id) :
       info_{nullptr, kObjectNormal, false, type_id == kTypeIdStruct, true, type_id},
+      links_(), shared_ptr<void>(AccountedPointer(ptr, type_id)) {}
+
+    //Untyped pointer is shared from existing object, it is not accounted again
+    Object(shared_ptr<void> ptr, string type_id) :
+      info_{ nullptr, kObjectNormal, false, type_id == kTypeIdStruct, true, type_id },
       links_(), shared_ptr<void>(ptr) {}
 
     template <typename T>
     Object(T &t, string type_id) :
       info_{nullptr, kObjectNormal, false, type_id == kTypeIdStruct, true, type_id},
       links_(), 
-      shared_ptr<void>(make_shared<T>(t)) {}
+      shared_ptr<void>(AccountedPointer(make_shared<T>(t), type_id)) {}
 
     template <typename T>
     Object(T &&t, string type_id) :
       info_{ nullptr, kObjectNormal, false, type_id == kTypeIdStruct, true, type_id },
       links_(),
-      shared_ptr<void>(make_shared<T>(std::forward<T>(t))) {}
+      shared_ptr<void>(AccountedPointer(make_shared<T>(std::forward<T>(t)), type_id)) {}
 
     template <typename T>
     Object(T *ptr, string type_id) :
@@ -189,7 +239,7 @@ namespace kagami {
 
     Object(string str) :
       info_{nullptr, kObjectNormal, false, false, true, kTypeIdString},
-      links_(), shared_ptr<void>(make_shared<string>(str)) {}
+      links_(), shared_ptr<void>(AccountedPointer(make_shared<string>(str), kTypeIdString)) {}
 
     Object(const ObjectInfo &info, const shared_ptr<void> &ptr) :
       info_(info), links_(std::nullopt), shared_ptr<void>(ptr) {
@@ -281,7 +331,7 @@ namespace kagami {
     void *GetExternalPointer() { return info_.real_dest; }
     Object &operator=(const Object &&object) { return operator=(object); }
     Object &swap(Object &&obj) { return swap(obj); }
-    string GetTypeId() const { return info_.type_id; }
+    const string &GetTypeId() const { return info_.type_id; }
     bool IsRef() const { return info_.mode == kObjectRef; }
     bool Null() const { return !this->operator bool() && info_.real_dest == nullptr; }
     ObjectMode GetMode() const { return info_.mode; }
@@ -328,14 +378,124 @@ namespace kagami {
   using ManagedArray = shared_ptr<ObjectArray>;
   using ObjectPair = pair<Object, Object>;
   using ManagedPair = shared_ptr<ObjectPair>;
-  using ObjectCache = pair<string, ObjectPointer>;
+  using IntArray = vector<int64_t>;
+  using FloatArray = vector<double>;
+  using BoolArray = vector<uint8_t>;
+
+  //Raw bytes are separated from bool_array, elements are read as int
+  class ByteArray : public vector<uint8_t> {
+  public:
+    using vector<uint8_t>::vector;
+  };
+
+  /*
+    View of [start, start + length) in array, the view keeps array alive.
+    Elements are shared with source array, and length is clamped by size of
+    source array on each access.
+  */
+  class ArraySlice {
+  private:
+    Object source_;
+    size_t start_;
+    size_t length_;
+
+  public:
+    ArraySlice() = delete;
+    ArraySlice(Object source, size_t start, size_t length) :
+      source_(source), start_(start), length_(length) {}
+
+    ObjectArray &GetBase() { return source_.Cast<ObjectArray>(); }
+    Object &GetSource() { return source_; }
+    size_t GetStart() const { return start_; }
+
+    size_t size() {
+      size_t total = GetBase().size();
+      return start_ >= total ? 0 : std::min(length_, total - start_);
+    }
+
+    bool empty() { return size() == 0; }
+    Object &operator[](size_t idx) { return GetBase()[start_ + idx]; }
+
+    ObjectArray::iterator begin() {
+      auto &base = GetBase();
+      return base.begin() + std::min(start_, base.size());
+    }
+
+    ObjectArray::iterator end() { return begin() + size(); }
+  };
+
+  /* View of part of string, the view keeps string alive */
+  class StringSlice {
+  private:
+    Object source_;
+    size_t start_;
+    size_t length_;
+
+  public:
+    StringSlice() = delete;
+    StringSlice(Object source, size_t start, size_t length) :
+      source_(source), start_(start), length_(length) {}
+
+    string_view View() {
+      string_view str(source_.Cast<string>());
+      return start_ >= str.size() ? string_view() : str.substr(start_, length_);
+    }
+
+    //Slice of slice refers to source string directly
+    StringSlice Slice(size_t start, size_t length) {
+      return StringSlice(source_, start_ + start, length);
+    }
+
+    size_t size() { return View().size(); }
+  };
+
+  /*
+    UTF-8 text indexed by code point. Content must be valid UTF-8 and is
+    never modified, so byte offset of every kIndexStride-th code point is
+    recorded once at first indexed access and kept afterwards.
+  */
+  class UTF8String {
+  public:
+    static const size_t kIndexStride = 32;
+
+  private:
+    string data_;
+    size_t length_;
+    vector<size_t> index_;
+
+    void BuildIndex();
+
+  public:
+    UTF8String() : data_(), length_(0), index_() {}
+    explicit UTF8String(string data);
+
+    const string &Data() const { return data_; }
+    size_t size() const { return length_; }
+    bool IsASCII() const { return length_ == data_.size(); }
+
+    //Byte offset of code point, idx == size() is the end of data
+    size_t Offset(size_t idx);
+    string_view At(size_t idx);
+    string_view Sub(size_t start, size_t length);
+    uint32_t CodePointAt(size_t idx);
+  };
+
+  //string and string_view are both accepted where characters are only read
+  inline bool FetchStringView(Object &obj, string_view &dest) {
+    auto &type_id = obj.GetTypeId();
+    if (type_id == kTypeIdString) dest = obj.Cast<string>();
+    else if (type_id == kTypeIdStringView) dest = obj.Cast<StringSlice>().View();
+    else return false;
+    return true;
+  }
+  using ObjectCache = pair<SymbolId, ObjectPointer>;
 
   class ObjectContainer {
   private:
     ObjectContainer *delegator_;
     ObjectContainer *prev_;
     map<string, Object> base_;
-    unordered_map<string, ObjectPointer> dest_map_;
+    unordered_map<SymbolId, ObjectPointer> dest_map_;
     list<ObjectCache> recent_;
 
     bool IsDelegated() const { 
@@ -347,14 +507,16 @@ namespace kagami {
     }
 
     void BuildCache();
-    void AppendRecent(const string &id, ObjectPointer ptr);
+    void AppendRecent(SymbolId id, ObjectPointer ptr);
   public:
-    bool Add(string id, Object &source);
-    bool Add(string id, Object &&source);
-    void Replace(string id, Object &source);
-    void Replace(string id, Object &&source);
+    //symbol is interned id if caller holds it, otherwise id is interned here
+    bool Add(string id, Object &source, SymbolId symbol = kSymbolNull);
+    bool Add(string id, Object &&source, SymbolId symbol = kSymbolNull);
+    void Replace(string id, Object &source, SymbolId symbol = kSymbolNull);
+    void Replace(string id, Object &&source, SymbolId symbol = kSymbolNull);
     Object *Find(const string &id, bool forward_seeking = true);
-    Object *FindWithDomain(const string &id, const string &domain, bool forward_seeking = true);
+    Object *Find(SymbolId id, bool forward_seeking = true);
+    Object *FindWithDomain(SymbolId id, SymbolId domain, bool forward_seeking = true);
     bool IsInside(Object *ptr);
     void ClearExcept(string exceptions);
 
@@ -578,8 +740,9 @@ namespace kagami {
 
     void MergeMap(ObjectMap &p);
     Object *Find(const string &id);
-    Object *Find(const string &id, const string &domain);
-    bool CreateObject(string id, Object &obj);
-    bool CreateObject(string id, Object &&obj);
+    Object *Find(SymbolId id);
+    Object *Find(SymbolId id, SymbolId domain);
+    bool CreateObject(string id, Object &obj, SymbolId symbol = kSymbolNull);
+    bool CreateObject(string id, Object &&obj, SymbolId symbol = kSymbolNull);
   };
 }
@@ -0,0 +1,1262 @@
+#include "optimizer.h"
+#include "machine.h"
+
+namespace kagami {
+  /* Plain value of literal argument, converted as FetchLiteralObject() does */
+  struct LiteralValue {
+    PlainType type;
+    int64_t int_value;
+    double float_value;
+    bool bool_value;
+    string string_value;
+
+    LiteralValue() : type(kNotPlainType), int_value(0),
+      float_value(0), bool_value(false), string_value() {}
+  };
+
+  enum BranchState { kBranchUnknown, kBranchTaken, kBranchSkipped };
+
+  inline bool ReadLiteral(Argument &arg, LiteralValue &dest) {
+    if (arg.GetType() != kArgumentLiteral) return false;
+
+    auto &data = arg.GetData();
+    bool result = true;
+
+    switch (arg.GetStringType()) {
+    case kStringTypeInt: {
+      auto [ptr, ec] = from_chars(data.data(), data.data() + data.size(), dest.int_value);
+      result = ec == std::errc() && ptr == data.data() + data.size();
+      dest.type = kPlainInt;
+      break;
+    }
+    case kStringTypeFloat: {
+      char *end = nullptr;
+      errno = 0;
+      dest.float_value = strtod(data.data(), &end);
+      result = errno == 0 && end == data.data() + data.size();
+      dest.type = kPlainFloat;
+      break;
+    }
+    case kStringTypeBool:
+      dest.bool_value = data == kStrTrue;
+      dest.type = kPlainBool;
+      break;
+    case kStringTypeLiteralStr:
+      dest.string_value = lexical::IsString(data) ? lexical::GetRawString(data) : data;
+      dest.type = kPlainString;
+      break;
+    default:
+      result = false;
+      break;
+    }
+
+    return result;
+  }
+
+  //Producers below follow IntProducer/FloatProducer/... of machine.cc
+  inline int64_t LiteralToInt(LiteralValue &value) {
+    switch (value.type) {
+    case kPlainInt: return value.int_value;
+    case kPlainFloat: return static_cast<int64_t>(value.float_value);
+    case kPlainBool: return value.bool_value ? 1 : 0;
+    default: return 0;
+    }
+  }
+
+  inline double LiteralToFloat(LiteralValue &value) {
+    switch (value.type) {
+    case kPlainFloat: return value.float_value;
+    case kPlainInt: return static_cast<double>(value.int_value);
+    case kPlainBool: return value.bool_value ? 1.0 : 0.0;
+    default: return 0;
+    }
+  }
+
+  inline string LiteralToString(LiteralValue &value) {
+    switch (value.type) {
+    case kPlainString: return value.string_value;
+    case kPlainFloat: return to_string(value.float_value);
+    case kPlainBool: return value.bool_value ? kStrTrue : kStrFalse;
+    case kPlainInt: return to_string(value.int_value);
+    default: return string();
+    }
+  }
+
+  inline bool LiteralToBool(LiteralValue &value) {
+    switch (value.type) {
+    case kPlainBool: return value.bool_value;
+    case kPlainInt: return value.int_value > 0;
+    case kPlainFloat: return value.float_value > 0.0;
+    case kPlainString: return !value.string_value.empty();
+    default: return false;
+    }
+  }
+
+  inline bool IsFoldableStringOperator(Keyword keyword) {
+    return keyword == kKeywordPlus ||
+      keyword == kKeywordNotEqual ||
+      keyword == kKeywordEquals;
+  }
+
+  template <Keyword op_code>
+  bool FoldMathOperator(LiteralValue &lhs, LiteralValue &rhs, LiteralValue &dest) {
+    auto result_type = kResultDynamicTraits.at(ResultTraitKey(lhs.type, rhs.type));
+    dest.type = result_type;
+
+    if (result_type == kPlainString) {
+      //Illegal operators push null object in runtime
+      if (!IsFoldableStringOperator(op_code)) return false;
+      dest.string_value = MathBox<string, op_code>()
+        .Do(LiteralToString(lhs), LiteralToString(rhs));
+    }
+    else if (result_type == kPlainInt) {
+      int64_t rhs_value = LiteralToInt(rhs);
+
+      //Keep runtime behavior of these cases
+      if constexpr (op_code == kKeywordDivide) {
+        if (rhs_value == 0) return false;
+        if (rhs_value == -1 && LiteralToInt(lhs) == INT64_MIN) return false;
+      }
+
+      dest.int_value = MathBox<int64_t, op_code>().Do(LiteralToInt(lhs), rhs_value);
+    }
+    else if (result_type == kPlainFloat) {
+      dest.float_value = MathBox<double, op_code>()
+        .Do(LiteralToFloat(lhs), LiteralToFloat(rhs));
+      if (!std::isfinite(dest.float_value)) return false;
+    }
+    //Bool arithmetic(e.g. true / false) is left to runtime
+    else {
+      return false;
+    }
+
+    return true;
+  }
+
+  template <Keyword op_code>
+  bool FoldLogicOperator(LiteralValue &lhs, LiteralValue &rhs, LiteralValue &dest) {
+    auto result_type = kResultDynamicTraits.at(ResultTraitKey(lhs.type, rhs.type));
+    dest.type = kPlainBool;
+
+    if (result_type == kPlainString) {
+      if (!IsFoldableStringOperator(op_code)) return false;
+      dest.bool_value = LogicBox<string, op_code>()
+        .Do(LiteralToString(lhs), LiteralToString(rhs));
+    }
+    else if (result_type == kPlainInt) {
+      dest.bool_value = LogicBox<int64_t, op_code>()
+        .Do(LiteralToInt(lhs), LiteralToInt(rhs));
+    }
+    else if (result_type == kPlainFloat) {
+      dest.bool_value = LogicBox<double, op_code>()
+        .Do(LiteralToFloat(lhs), LiteralToFloat(rhs));
+    }
+    else if (result_type == kPlainBool) {
+      dest.bool_value = LogicBox<bool, op_code>()
+        .Do(LiteralToBool(lhs), LiteralToBool(rhs));
+    }
+
+    return true;
+  }
+
+  bool FoldCommand(Command &command, LiteralValue &dest) {
+    auto &request = command.first;
+    auto &args = command.second;
+
+    if (request.type != kRequestCommand || request.option.void_call) return false;
+
+    auto keyword = request.GetKeywordValue();
+    LiteralValue lhs, rhs;
+
+    if (keyword == kKeywordNot) {
+      if (args.size() != 1 || !ReadLiteral(args[0], rhs)) return false;
+      if (rhs.type != kPlainBool) return false;
+      dest.type = kPlainBool;
+      dest.bool_value = !rhs.bool_value;
+      return true;
+    }
+
+    if (keyword == kKeywordExpList) {
+      if (args.size() != 1) return false;
+      return ReadLiteral(args[0], dest);
+    }
+
+    if (args.size() != 2) return false;
+    if (!ReadLiteral(args[0], lhs) || !ReadLiteral(args[1], rhs)) return false;
+
+    bool result = false;
+
+#define MATH_OPERATOR(_Op)  case _Op: result = FoldMathOperator<_Op>(lhs, rhs, dest); break
+#define LOGIC_OPERATOR(_Op) case _Op: result = FoldLogicOperator<_Op>(lhs, rhs, dest); break
+
+    switch (keyword) {
+      MATH_OPERATOR(kKeywordPlus);
+      MATH_OPERATOR(kKeywordMinus);
+      MATH_OPERATOR(kKeywordTimes);
+      MATH_OPERATOR(kKeywordDivide);
+      LOGIC_OPERATOR(kKeywordEquals);
+      LOGIC_OPERATOR(kKeywordLessOrEqual);
+      LOGIC_OPERATOR(kKeywordGreaterOrEqual);
+      LOGIC_OPERATOR(kKeywordNotEqual);
+      LOGIC_OPERATOR(kKeywordGreater);
+      LOGIC_OPERATOR(kKeywordLess);
+      LOGIC_OPERATOR(kKeywordAnd);
+      LOGIC_OPERATOR(kKeywordOr);
+    default: break;
+    }
+
+#undef MATH_OPERATOR
+#undef LOGIC_OPERATOR
+
+    return result;
+  }
+
+  string MakeFloatLiteral(double value) {
+    char buf[32];
+
+    //Shortest text which is parsed back to the same value
+    for (int precision = 15; precision <= 17; ++precision) {
+      snprintf(buf, sizeof(buf), "%.*g", precision, value);
+      if (strtod(buf, nullptr) == value) break;
+    }
+
+    string result(buf);
+    //Keep it apart from integer literal in constant cache
+    if (result.find_first_of(".e") == string::npos) result.append(".0");
+    return result;
+  }
+
+  string MakeStringLiteral(const string &value) {
+    string result("'");
+
+    for (auto unit : value) {
+      switch (unit) {
+      case '\\':result.append("\\\\"); break;
+      case '\'':result.append("\\'"); break;
+      case '\t':result.append("\\t"); break;
+      case '\n':result.append("\\n"); break;
+      case '\r':result.append("\\r"); break;
+      default:result.append(1, unit); break;
+      }
+    }
+
+    result.append("'");
+    return result;
+  }
+
+  Argument MakeLiteralArgument(LiteralValue &value) {
+    switch (value.type) {
+    case kPlainInt:
+      return Argument(to_string(value.int_value), kArgumentLiteral, kStringTypeInt);
+    case kPlainFloat:
+      return Argument(MakeFloatLiteral(value.float_value), kArgumentLiteral, kStringTypeFloat);
+    case kPlainBool:
+      return Argument(value.bool_value ? kStrTrue : kStrFalse, kArgumentLiteral, kStringTypeBool);
+    default:
+      return Argument(MakeStringLiteral(value.string_value), kArgumentLiteral, kStringTypeLiteralStr);
+    }
+  }
+
+  //Argument which receives return value of previous command.
+  //Return stack is popped from the last argument, and domains are fetched before them.
+  Argument *FindReceivingArgument(Command &command) {
+    auto &request = command.first;
+    Argument *result = nullptr;
+    size_t count = 0;
+
+    if (request.type == kRequestNull) return nullptr;
+
+    auto keyword = request.GetKeywordValue();
+
+    //These commands refuse to modify a literal value
+    if (compare(keyword, kKeywordDelivering, kKeywordSwap, kKeywordSwapIf,
+      kKeywordCSwapIf, kKeywordDestroy)) {
+      return nullptr;
+    }
+
+    if (request.type == kRequestFunction &&
+      request.GetInterfaceDomain().GetType() == kArgumentReturnStack) {
+      return nullptr;
+    }
+
+    for (auto &unit : command.second) {
+      if (unit.GetType() == kArgumentReturnStack) {
+        result = &unit;
+        count += 1;
+      }
+      else if (unit.option.domain_type == kArgumentReturnStack) {
+        return nullptr;
+      }
+    }
+
+    if (count > 1 && !lexical::IsBinaryOperator(keyword)) return nullptr;
+
+    //Left hand side of assignment
+    if (compare(keyword, kKeywordBind, kKeywordIncrease, kKeywordDecrease) &&
+      result == &command.second.front()) {
+      return nullptr;
+    }
+
+    return result;
+  }
+
+  //Move kept commands to the front and fix all absolute indexes in VMCode.
+  //Targets in dead_branches are removed from jump records.
+  void CompactVMCode(VMCode &code, vector<bool> &keep,
+    unordered_set<size_t> &dead_branches) {
+    size_t size = code.size();
+    //Old index -> new index of the first kept command at or after it
+    vector<size_t> position(size + 1);
+    size_t count = 0;
+
+    for (size_t idx = 0; idx < size; ++idx) {
+      position[idx] = count;
+      if (keep[idx]) count += 1;
+    }
+
+    position[size] = count;
+
+    for (size_t idx = 0, dest = 0; idx < size; ++idx) {
+      if (!keep[idx]) continue;
+
+      auto &option = code[idx].first.option;
+      option.nest = position[std::min(option.nest, size)];
+      option.nest_end = position[std::min(option.nest_end, size)];
+      option.jump_target = position[std::min(option.jump_target, size)];
+
+      if (dest != idx) code[dest] = std::move(code[idx]);
+      dest += 1;
+    }
+
+    code.erase(code.begin() + count, code.end());
+
+    unordered_map<size_t, list<size_t>> jump_record;
+
+    for (auto &unit : code.GetJumpRecord()) {
+      if (!keep[unit.first]) continue;
+
+      list<size_t> targets;
+
+      for (auto target : unit.second) {
+        if (dead_branches.find(target) != dead_branches.end()) continue;
+        targets.push_back(position[target]);
+      }
+
+      //Empty record makes 'if' jump to nowhere
+      if (!targets.empty()) {
+        jump_record.emplace(position[unit.first], std::move(targets));
+      }
+    }
+
+    code.GetJumpRecord().swap(jump_record);
+  }
+
+  size_t FoldConstantExpressions(VMCode &code) {
+    vector<bool> keep(code.size(), true);
+    unordered_set<size_t> dead_branches;
+    size_t folded = 0;
+
+    //Folded value goes into next command, so chained expressions are
+    //folded one by one in this loop.
+    for (size_t idx = 0; idx + 1 < code.size(); ++idx) {
+      LiteralValue value;
+      auto &next = code[idx + 1];
+
+      if (next.first.idx != code[idx].first.idx) continue;
+      if (!FoldCommand(code[idx], value)) continue;
+
+      //Bool value of expression list is reserved for condition
+      if (code[idx].first.GetKeywordValue() == kKeywordExpList && value.type == kPlainBool &&
+        !compare(next.first.GetKeywordValue(), kKeywordIf, kKeywordElif, kKeywordWhile)) {
+        continue;
+      }
+
+      Argument *receiver = FindReceivingArgument(next);
+      if (receiver == nullptr) continue;
+
+      auto option = receiver->option;
+      *receiver = MakeLiteralArgument(value);
+      receiver->option = option;
+      keep[idx] = false;
+      folded += 1;
+    }
+
+    if (folded != 0) CompactVMCode(code, keep, dead_branches);
+
+    return folded;
+  }
+
+  inline bool IsBranchCommand(Command &command) {
+    return compare(command.first.GetKeywordValue(),
+      kKeywordElif, kKeywordElse, kKeywordWhen);
+  }
+
+  BranchState GetConditionState(Command &command) {
+    LiteralValue value;
+
+    if (command.second.size() != 1 || !ReadLiteral(command.second[0], value)) {
+      return kBranchUnknown;
+    }
+
+    //Non-bool value is an error in runtime
+    if (value.type != kPlainBool) return kBranchUnknown;
+
+    return value.bool_value ? kBranchTaken : kBranchSkipped;
+  }
+
+  //Same comparison as CommandWhen()
+  BranchState GetWhenState(Command &command, LiteralValue &subject) {
+    bool found = false;
+
+    for (auto &unit : command.second) {
+      LiteralValue value;
+
+      if (!ReadLiteral(unit, value)) return kBranchUnknown;
+      if (value.type != subject.type) continue;
+
+      switch (subject.type) {
+      case kPlainInt: found = found || value.int_value == subject.int_value; break;
+      case kPlainFloat: found = found || value.float_value == subject.float_value; break;
+      case kPlainString: found = found || value.string_value == subject.string_value; break;
+      case kPlainBool: found = found || value.bool_value == subject.bool_value; break;
+      default: break;
+      }
+    }
+
+    return found ? kBranchTaken : kBranchSkipped;
+  }
+
+  /*
+    Reaching next branch line from end of a taken branch evaluates its condition
+    expression before jumping to 'end', so it is only removed when the line
+    has no other command. Branch states are only decided on these lines.
+  */
+  size_t EliminateDeadBranches(VMCode &code) {
+    vector<bool> keep(code.size(), true);
+    unordered_set<size_t> dead_branches;
+    auto &jump_record = code.GetJumpRecord();
+    size_t removed = 0;
+
+    auto remove = [&](size_t begin, size_t end) -> void {
+      for (size_t idx = begin; idx < end; ++idx) {
+        if (keep[idx]) removed += 1;
+        keep[idx] = false;
+      }
+    };
+
+    auto is_pure_branch = [&](size_t idx) -> bool {
+      return IsBranchCommand(code[idx]);
+    };
+
+    for (size_t idx = 0; idx < code.size(); ++idx) {
+      auto keyword = code[idx].first.GetKeywordValue();
+
+      if (!keep[idx] || !compare(keyword, kKeywordIf, kKeywordCase)) continue;
+
+      size_t end = code[idx].first.option.nest_end;
+      if (end <= idx || end >= code.size()) continue;
+      if (code[end].first.GetKeywordValue() != kKeywordEnd) continue;
+
+      size_t head = code[end].first.option.nest;
+      BranchState root_state = kBranchUnknown;
+      LiteralValue subject;
+      bool subject_known = false;
+      vector<size_t> branches;
+      vector<BranchState> states;
+
+      if (auto it = jump_record.find(idx); it != jump_record.end()) {
+        branches.assign(it->second.begin(), it->second.end());
+      }
+
+      if (keyword == kKeywordIf) {
+        root_state = GetConditionState(code[idx]);
+      }
+      else if (head == idx && code[idx].second.size() == 1) {
+        subject_known = ReadLiteral(code[idx].second[0], subject);
+      }
+
+      for (auto unit : branches) {
+        auto &command = code[unit];
+        auto branch_keyword = command.first.GetKeywordValue();
+        BranchState state = kBranchUnknown;
+
+        if (!is_pure_branch(unit)) {
+          state = kBranchUnknown;
+        }
+        else if (branch_keyword == kKeywordElse) {
+          state = kBranchTaken;
+        }
+        else if (branch_keyword == kKeywordElif) {
+          state = GetConditionState(command);
+        }
+        else if (branch_keyword == kKeywordWhen && subject_known) {
+          state = GetWhenState(command, subject);
+        }
+
+        states.push_back(state);
+      }
+
+      //Branches after the first taken one are unreachable, except the
+      //condition line right behind it.
+      size_t count = branches.size();
+      size_t cut = count;
+
+      if (root_state == kBranchTaken) {
+        cut = 0;
+      }
+      else {
+        for (size_t pos = 0; pos < count; ++pos) {
+          if (states[pos] == kBranchTaken) {
+            cut = pos + 1;
+            break;
+          }
+        }
+      }
+
+      size_t alive = cut;
+      bool next_pure = true;
+
+      if (cut < count) {
+        size_t begin = branches[cut];
+
+        if (is_pure_branch(begin)) {
+          remove(begin, end);
+        }
+        else {
+          while (!IsBranchCommand(code[begin])) ++begin;
+          remove(begin + 1, end);
+          alive += 1;
+          next_pure = false;
+        }
+
+        for (size_t pos = alive; pos < count; ++pos) {
+          dead_branches.insert(branches[pos]);
+        }
+      }
+
+      //Skipped branch is removed when falling into the next one has
+      //the same effect as the jump to 'end'.
+      for (size_t pos = cut; pos-- > 0;) {
+        size_t segment_end = pos + 1 < count ? branches[pos + 1] : end;
+
+        if (states[pos] == kBranchSkipped && next_pure) {
+          remove(branches[pos], segment_end);
+          dead_branches.insert(branches[pos]);
+        }
+        else {
+          next_pure = is_pure_branch(branches[pos]);
+        }
+      }
+
+      if (root_state == kBranchSkipped) {
+        size_t body_end = end;
+
+        for (size_t pos = 0; pos < alive; ++pos) {
+          if (dead_branches.find(branches[pos]) == dead_branches.end()) {
+            body_end = branches[pos];
+            break;
+          }
+        }
+
+        remove(idx + 1, body_end);
+
+        //Whole block is gone if there's nothing left to jump to
+        if (body_end == end && head == idx) {
+          remove(head, end + 1);
+        }
+      }
+    }
+
+    if (removed != 0) CompactVMCode(code, keep, dead_branches);
+
+    return removed;
+  }
+
+  /*
+    Plain types of names are inferred without flow information: a name has
+    an inferred type only if every binding of it in VMCode assigns a value of
+    that type, and it is never written in any other way. kNotPlainType is
+    the top of this lattice, kTypeUnset means no binding is processed yet.
+  */
+  const PlainType kTypeUnset = static_cast<PlainType>(0);
+
+  inline PlainType JoinType(PlainType lhs, PlainType rhs) {
+    if (lhs == kTypeUnset) return rhs;
+    if (rhs == kTypeUnset) return lhs;
+    return lhs == rhs ? lhs : kNotPlainType;
+  }
+
+  inline PlainType GetConstraintType(const string &type_id) {
+    if (type_id == kTypeIdInt) return kPlainInt;
+    if (type_id == kTypeIdFloat) return kPlainFloat;
+    if (type_id == kTypeIdBool) return kPlainBool;
+    if (type_id == kTypeIdString) return kPlainString;
+    return kNotPlainType;
+  }
+
+  inline bool IsMathOperator(Keyword keyword) {
+    return compare(keyword, kKeywordPlus, kKeywordMinus, kKeywordTimes, kKeywordDivide);
+  }
+
+  inline bool IsLogicOperator(Keyword keyword) {
+    return compare(keyword, kKeywordEquals, kKeywordLessOrEqual, kKeywordGreaterOrEqual,
+      kKeywordNotEqual, kKeywordGreater, kKeywordLess, kKeywordAnd, kKeywordOr);
+  }
+
+  //Operand types which have specialized implementation in Machine
+  inline bool IsSpecializable(Keyword keyword, PlainType type) {
+    if (IsMathOperator(keyword)) {
+      return compare(type, kPlainInt, kPlainFloat);
+    }
+
+    if (compare(keyword, kKeywordEquals, kKeywordNotEqual)) {
+      return compare(type, kPlainInt, kPlainFloat, kPlainBool);
+    }
+
+    if (compare(keyword, kKeywordAnd, kKeywordOr)) {
+      return type == kPlainBool;
+    }
+
+    if (IsLogicOperator(keyword)) {
+      return compare(type, kPlainInt, kPlainFloat);
+    }
+
+    return false;
+  }
+
+  //Same result as BinaryMathOperatorImpl()/BinaryLogicOperatorImpl()
+  PlainType GetOperatorResultType(Keyword keyword, PlainType lhs, PlainType rhs) {
+    //Non-plain left hand side is compared by __compare()
+    if (compare(keyword, kKeywordEquals, kKeywordNotEqual)) return kPlainBool;
+    if (lhs == kTypeUnset || rhs == kTypeUnset) return kTypeUnset;
+
+    bool plain = lhs != kNotPlainType && rhs != kNotPlainType;
+    auto result = plain ? kResultDynamicTraits.at(ResultTraitKey(lhs, rhs)) : kNotPlainType;
+
+    //Illegal operators push null object
+    if (!plain || (result == kPlainString && !IsFoldableStringOperator(keyword))) {
+      return kNotPlainType;
+    }
+
+    return IsLogicOperator(keyword) ? kPlainBool : result;
+  }
+
+  class TypeInference {
+  private:
+    VMCode &code_;
+    unordered_map<string, PlainType> names_;
+    unordered_set<string> tainted_;
+    unordered_map<string, PlainType> functions_;
+    bool changed_;
+
+    void Taint(const string &id) {
+      tainted_.insert(id);
+    }
+
+    PlainType GetNameType(const string &id) {
+      if (tainted_.find(id) != tainted_.end()) return kNotPlainType;
+      auto it = names_.find(id);
+      return it == names_.end() ? kNotPlainType : it->second;
+    }
+
+    PlainType GetArgumentType(Argument &arg) {
+      if (arg.GetType() == kArgumentLiteral) {
+        switch (arg.GetStringType()) {
+        case kStringTypeInt: return kPlainInt;
+        case kStringTypeFloat: return kPlainFloat;
+        case kStringTypeBool: return kPlainBool;
+        case kStringTypeLiteralStr: return kPlainString;
+        default: return kNotPlainType;
+        }
+      }
+
+      if (arg.GetType() == kArgumentObjectStack && arg.option.domain.empty() &&
+        !arg.option.use_last_assert) {
+        return GetNameType(arg.GetData());
+      }
+
+      return kNotPlainType;
+    }
+
+    //A call at the end of function body replaces the frame of this function,
+    //its return value constraint is not checked in this case.
+    bool HasTailCall(size_t nest, size_t end) {
+      if (end <= nest + 1) return false;
+
+      if (code_[end - 1].first.type == kRequestFunction) return true;
+
+      if (end > nest + 2 && code_[end - 1].first.GetKeywordValue() == kKeywordReturn) {
+        auto &args = code_[end - 1].second;
+        if (args.size() == 1 && args.back().GetType() == kArgumentReturnStack &&
+          code_[end - 2].first.type == kRequestFunction) {
+          return true;
+        }
+      }
+
+      return false;
+    }
+
+    bool CollectFunction(size_t nest) {
+      auto &command = code_[nest];
+      auto &args = command.second;
+      PlainType type = kNotPlainType;
+
+      if (args.empty()) return true;
+
+      for (size_t idx = 1; idx < args.size(); ++idx) {
+        if (args[idx].option.optional_param || args[idx].option.variable_param) {
+          //Arguments of these functions may refer to objects of caller
+          return false;
+        }
+
+        if (args[idx].option.is_constraint) type = GetConstraintType(args[idx].GetData());
+        else Taint(args[idx].GetData());
+      }
+
+      auto &id = args[0].GetData();
+      size_t end = command.first.option.nest_end;
+
+      if (end == 0 || HasTailCall(nest, end)) type = kNotPlainType;
+
+      auto it = functions_.find(id);
+      functions_[id] = it == functions_.end() ? type : kNotPlainType;
+      return true;
+    }
+
+    //Names which may be written by anything other than plain binding are
+    //excluded from inference. Returns false if nothing can be inferred.
+    bool Prepare() {
+      for (size_t pos = 0; pos < code_.size(); ++pos) {
+        auto &request = code_[pos].first;
+        auto &args = code_[pos].second;
+        auto keyword = request.GetKeywordValue();
+
+        //Names are bound into root scope from outside of this VMCode
+        if (compare(keyword, kKeywordUsing, kKeywordUsingTable)) return false;
+
+        if (keyword == kKeywordFn) {
+          if (!CollectFunction(pos)) return false;
+          continue;
+        }
+
+        bool writer = compare(keyword, kKeywordDelivering, kKeywordSwap, kKeywordSwapIf,
+          kKeywordCSwapIf, kKeywordDestroy, kKeywordFor, kKeywordInitialArray);
+
+        for (size_t idx = 0; idx < args.size(); ++idx) {
+          auto &arg = args[idx];
+
+          //Members may share their names with plain objects
+          if (!arg.option.domain.empty() || arg.option.use_last_assert) {
+            Taint(arg.GetData());
+            continue;
+          }
+
+          bool identifier = arg.GetType() == kArgumentLiteral &&
+            arg.GetStringType() == kStringTypeIdentifier;
+
+          //Loop variable of range-for is always bound with int
+          if (compare(keyword, kKeywordBind, kKeywordForRange) && idx == 0 && identifier) {
+            names_.emplace(arg.GetData(), kTypeUnset);
+          }
+          else if (identifier || (writer && arg.GetType() == kArgumentObjectStack)) {
+            Taint(arg.GetData());
+          }
+        }
+      }
+
+      for (auto &unit : names_) {
+        auto symbol = FindSymbol(unit.first);
+
+        //Read before binding may reach built-in functions and constants
+        if (management::FindFunction(symbol) != nullptr ||
+          management::GetConstantObject(symbol) != nullptr) {
+          Taint(unit.first);
+        }
+      }
+
+      //Function objects can be replaced like other objects
+      for (auto &unit : functions_) {
+        auto symbol = FindSymbol(unit.first);
+
+        if (names_.find(unit.first) != names_.end() ||
+          tainted_.find(unit.first) != tainted_.end() ||
+          management::FindFunction(symbol) != nullptr) {
+          unit.second = kNotPlainType;
+        }
+      }
+
+      for (auto &unit : functions_) Taint(unit.first);
+
+      return true;
+    }
+
+    /*
+      Return stack of a line is simulated to get types of kArgumentReturnStack
+      arguments. Commands with unknown return stack behavior make all values
+      on this line untyped. Operators are only marked when mark is true.
+    */
+    size_t ProcessLine(size_t begin, size_t end, bool mark) {
+      vector<PlainType> stack;
+      vector<PlainType> types;
+      bool opaque = false;
+      size_t specialized = 0;
+
+      for (size_t idx = begin; idx < end; ++idx) {
+        auto &request = code_[idx].first;
+        auto &args = code_[idx].second;
+        auto keyword = request.GetKeywordValue();
+        PlainType result = kNotPlainType;
+        bool push = !request.option.void_call;
+
+        types.assign(args.size(), kNotPlainType);
+
+        if (request.type == kRequestFunction) {
+          opaque = opaque || request.option.use_last_assert ||
+            request.GetInterfaceDomain().GetType() == kArgumentReturnStack;
+
+          if (!opaque && request.GetInterfaceDomain().IsPlaceholder()) {
+            auto it = functions_.find(request.GetInterfaceId());
+            if (it != functions_.end()) result = it->second;
+          }
+        }
+        else if (keyword == kKeywordExpList) {
+          opaque = opaque || args.size() != 1;
+        }
+        else if (compare(keyword, kKeywordBind, kKeywordIf, kKeywordElif, kKeywordWhile,
+          kKeywordReturn, kKeywordCase, kKeywordWhen, kKeywordForRange)) {
+          //These commands don't push return value
+          push = false;
+        }
+        else if (!IsMathOperator(keyword) && !IsLogicOperator(keyword) &&
+          !compare(keyword, kKeywordNot, kKeywordInitialArray)) {
+          opaque = true;
+        }
+
+        for (size_t pos = args.size(); pos-- > 0;) {
+          if (args[pos].option.domain_type == kArgumentReturnStack) opaque = true;
+
+          if (args[pos].GetType() == kArgumentReturnStack) {
+            if (stack.empty()) opaque = true;
+            else {
+              types[pos] = stack.back();
+              stack.pop_back();
+            }
+          }
+          else {
+            types[pos] = GetArgumentType(args[pos]);
+          }
+        }
+
+        if (opaque) {
+          types.assign(args.size(), kNotPlainType);
+          result = kNotPlainType;
+        }
+
+        if (keyword == kKeywordExpList && !opaque) {
+          result = types.back();
+        }
+        else if ((IsMathOperator(keyword) || IsLogicOperator(keyword)) && args.size() == 2) {
+          result = GetOperatorResultType(keyword, types[0], types[1]);
+
+          if (mark && types[0] == types[1] && IsSpecializable(keyword, types[0])) {
+            request.option.operand_type = types[0];
+            specialized += 1;
+          }
+        }
+        else if (keyword == kKeywordNot && !opaque) {
+          result = kPlainBool;
+        }
+
+        if (keyword == kKeywordBind && args.size() == 2 &&
+          args[0].GetType() == kArgumentLiteral &&
+          args[0].GetStringType() == kStringTypeIdentifier) {
+          auto it = names_.find(args[0].GetData());
+
+          if (it != names_.end()) {
+            auto type = JoinType(it->second, types[1]);
+            changed_ = changed_ || type != it->second;
+            it->second = type;
+          }
+        }
+
+        if (keyword == kKeywordForRange) {
+          auto it = names_.find(args[0].GetData());
+
+          if (it != names_.end()) {
+            auto type = JoinType(it->second, kPlainInt);
+            changed_ = changed_ || type != it->second;
+            it->second = type;
+          }
+        }
+
+        if (push) stack.push_back(result);
+      }
+
+      return specialized;
+    }
+
+    size_t ProcessCode(bool mark) {
+      size_t specialized = 0;
+
+      for (size_t begin = 0; begin < code_.size();) {
+        size_t end = begin + 1;
+        while (end < code_.size() && code_[end].first.idx == code_[begin].first.idx) ++end;
+        specialized += ProcessLine(begin, end, mark);
+        begin = end;
+      }
+
+      return specialized;
+    }
+
+  public:
+    TypeInference(VMCode &code) :
+      code_(code), names_(), tainted_(), functions_(), changed_(false) {}
+
+    size_t Run() {
+      for (auto &unit : code_) unit.first.option.operand_type = kNotPlainType;
+
+      if (!Prepare()) return 0;
+
+      //Types only go up in the lattice, so this loop ends
+      do {
+        changed_ = false;
+        ProcessCode(false);
+      } while (changed_);
+
+      //Names which are only bound from themselves
+      for (auto &unit : names_) {
+        if (unit.second == kTypeUnset) unit.second = kNotPlainType;
+      }
+
+      return ProcessCode(true);
+    }
+  };
+
+  size_t SpecializeOperators(VMCode &code) {
+    return TypeInference(code).Run();
+  }
+
+  pair<size_t, size_t> GetSpecializationCoverage(VMCode &code) {
+    size_t total = 0, specialized = 0;
+
+    for (auto &unit : code) {
+      auto &request = unit.first;
+      auto keyword = request.GetKeywordValue();
+
+      if (request.type != kRequestCommand) continue;
+      if (!IsMathOperator(keyword) && !IsLogicOperator(keyword)) continue;
+
+      total += 1;
+      if (request.option.operand_type != kNotPlainType) specialized += 1;
+    }
+
+    return make_pair(total, specialized);
+  }
+
+  size_t optimization_level = kDefaultOptimizationLevel;
+  bool vmcode_dump = false;
+  bool optimizer_verbose = false;
+
+  void SetOptimizationLevel(size_t level) {
+    optimization_level = std::min(level, kMaxOptimizationLevel);
+  }
+
+  size_t GetOptimizationLevel() {
+    return optimization_level;
+  }
+
+  void SetVMCodeDump(bool enable) {
+    vmcode_dump = enable;
+  }
+
+  bool IsVMCodeDumpEnabled() {
+    return vmcode_dump;
+  }
+
+  void SetOptimizerVerbose(bool verbose) {
+    optimizer_verbose = verbose;
+  }
+
+  inline bool IsLineHead(VMCode &code, size_t idx) {
+    return idx == 0 || code[idx - 1].first.idx != code[idx].first.idx;
+  }
+
+  inline size_t GetLineTail(VMCode &code, size_t idx) {
+    while (idx + 1 < code.size() && code[idx + 1].first.idx == code[idx].first.idx) ++idx;
+    return idx;
+  }
+
+  size_t ResolveJumpTargets(VMCode &code) {
+    auto &jump_record = code.GetJumpRecord();
+    //Root keyword and 'end' index of unclosed blocks
+    vector<pair<Keyword, size_t>> blocks;
+    size_t resolved = 0;
+
+    for (size_t idx = 0; idx < code.size(); ++idx) {
+      auto &option = code[idx].first.option;
+      Keyword keyword = code[idx].first.GetKeywordValue();
+
+      if (keyword == kKeywordEnd) {
+        if (!blocks.empty()) blocks.pop_back();
+
+        //Loop arguments are evaluated once, so 'end' goes back to
+        //loop command instead of line head
+        if (compare(option.nest_root, kKeywordFor, kKeywordForRange)) {
+          option.jump_target = GetLineTail(code, option.nest);
+          resolved += 1;
+        }
+
+        continue;
+      }
+
+      if (compare(keyword, kKeywordContinue, kKeywordBreak)) {
+        option.nest_end = 0;
+
+        for (size_t depth = 0; depth < blocks.size(); ++depth) {
+          auto &block = blocks[blocks.size() - 1 - depth];
+          //Function body is executed in another frame
+          if (block.first == kKeywordFn) break;
+          if (depth == option.escape_depth) {
+            if (compare(block.first, kKeywordWhile, kKeywordFor, kKeywordForRange)) {
+              option.nest_end = block.second;
+              resolved += 1;
+            }
+            break;
+          }
+        }
+
+        continue;
+      }
+
+      if (option.nest_end == 0 || !compare(keyword, kKeywordIf, kKeywordWhile,
+        kKeywordFn, kKeywordCase, kKeywordStruct, kKeywordModule, kKeywordFor,
+        kKeywordForRange)) {
+        continue;
+      }
+
+      blocks.emplace_back(keyword, option.nest_end);
+
+      if (!compare(keyword, kKeywordIf, kKeywordCase)) continue;
+
+      auto it = jump_record.find(idx);
+      option.jump_target = it == jump_record.end() ? 
+        option.nest_end : it->second.front();
+      resolved += 1;
+
+      if (it == jump_record.end()) continue;
+
+      //Taken branch jumps to 'end', skipped branch jumps to the next one
+      for (auto target = it->second.begin(); target != it->second.end(); ++target) {
+        auto next = std::next(target);
+        auto &branch = code[GetLineTail(code, *target)].first.option;
+        branch.nest_end = option.nest_end;
+        branch.jump_target = next == it->second.end() ? option.nest_end : *next;
+        resolved += 1;
+      }
+    }
+
+    return resolved;
+  }
+
+  bool VerifyVMCode(VMCode &code, string &msg) {
+    size_t size = code.size();
+
+    for (size_t idx = 0; idx < size; ++idx) {
+      auto &request = code[idx].first;
+
+      if (request.GetKeywordValue() == kKeywordEnd) {
+        size_t nest = request.option.nest;
+
+        if (nest >= idx || !IsLineHead(code, nest) ||
+          code[GetLineTail(code, nest)].first.option.nest_end != idx) {
+          msg = "Invalid nest head of 'end' at " + to_string(idx);
+          return false;
+        }
+      }
+      else if (request.option.nest_end != 0) {
+        size_t end = request.option.nest_end;
+
+        if (end <= idx || end >= size || code[end].first.GetKeywordValue() != kKeywordEnd) {
+          msg = "Invalid nest end of command at " + to_string(idx);
+          return false;
+        }
+      }
+
+      if (size_t target = request.option.jump_target; target != 0) {
+        //'end' of for-each jumps back to loop command
+        if (request.GetKeywordValue() == kKeywordEnd &&
+          compare(request.option.nest_root, kKeywordFor, kKeywordForRange)) {
+          if (target != GetLineTail(code, request.option.nest)) {
+            msg = "Invalid jump target of command at " + to_string(idx);
+            return false;
+          }
+
+          continue;
+        }
+
+        if (target <= idx || target >= size ||
+          (code[target].first.GetKeywordValue() != kKeywordEnd &&
+          (!IsLineHead(code, target) || !IsBranchCommand(code[GetLineTail(code, target)])))) {
+          msg = "Invalid jump target of command at " + to_string(idx);
+          return false;
+        }
+      }
+    }
+
+    for (auto &unit : code.GetJumpRecord()) {
+      size_t key = unit.first;
+
+      if (key >= size || unit.second.empty() ||
+        !compare(code[key].first.GetKeywordValue(), kKeywordIf, kKeywordCase)) {
+        msg = "Invalid jump record at " + to_string(key);
+        return false;
+      }
+
+      size_t end = code[key].first.option.nest_end;
+      size_t last = key;
+
+      for (auto target : unit.second) {
+        if (target <= last || target >= end || !IsLineHead(code, target) ||
+          !IsBranchCommand(code[GetLineTail(code, target)])) {
+          msg = "Invalid branch target " + to_string(target) + " of " + to_string(key);
+          return false;
+        }
+
+        last = target;
+      }
+    }
+
+    return true;
+  }
+
+  string DumpArgument(const Argument &arg) {
+    string result;
+
+    if (!arg.option.domain.empty()) {
+      result.append(arg.option.domain_type == kArgumentReturnStack ?
+        "<rs>" : arg.option.domain);
+      result.append(".");
+    }
+
+    switch (arg.GetType()) {
+    case kArgumentLiteral:result.append(arg.GetData()); break;
+    case kArgumentObjectStack:result.append("$" + arg.GetData()); break;
+    case kArgumentReturnStack:result.append("<rs>"); break;
+    default:result.append("_"); break;
+    }
+
+    return result;
+  }
+
+  string DumpVMCode(VMCode &code) {
+    string result;
+    char buf[64];
+
+    for (size_t idx = 0; idx < code.size(); ++idx) {
+      auto &request = code[idx].first;
+      auto &option = request.option;
+
+      snprintf(buf, sizeof(buf), "%6zu  line %-5zu ", idx, request.idx);
+      result.append(buf);
+
+      if (request.type == kRequestFunction) {
+        auto &domain = request.GetInterfaceDomain();
+        if (!domain.IsPlaceholder()) result.append(DumpArgument(domain) + ".");
+        result.append(request.GetInterfaceId() + "()");
+      }
+      else {
+        result.append(lexical::GetKeywordName(request.GetKeywordValue()));
+      }
+
+      for (auto &unit : code[idx].second) {
+        result.append(" " + DumpArgument(unit));
+      }
+
+      if (option.nest_end != 0) result.append(" ;nest_end=" + to_string(option.nest_end));
+      if (option.jump_target != 0) result.append(" ;jump_target=" + to_string(option.jump_target));
+      if (option.nest_root != kKeywordNull) result.append(" ;nest=" + to_string(option.nest));
+      if (option.escape_depth != 0) result.append(" ;escape_depth=" + to_string(option.escape_depth));
+      if (option.void_call) result.append(" ;void_call");
+
+      switch (option.operand_type) {
+      case kPlainInt:result.append(" ;operand=" + kTypeIdInt); break;
+      case kPlainFloat:result.append(" ;operand=" + kTypeIdFloat); break;
+      case kPlainBool:result.append(" ;operand=" + kTypeIdBool); break;
+      default:break;
+      }
+
+      if (auto it = code.GetJumpRecord().find(idx); it != code.GetJumpRecord().end()) {
+        result.append(" ;branches=");
+        for (auto target : it->second) {
+          result.append(to_string(target));
+          if (target != it->second.back()) result.append(",");
+        }
+      }
+
+      result.append("\n");
+    }
+
+    return result;
+  }
+
+  PassManager::PassManager(size_t level, bool imported) :
+    passes_(), report_coverage_(false) {
+    if (level >= 1) AddPass("fold_constants", FoldConstantExpressions);
+    if (level >= 2) AddPass("dead_branches", EliminateDeadBranches);
+
+    if (level >= 3 && !imported) {
+      AddPass("specialize_operators", SpecializeOperators);
+      report_coverage_ = true;
+    }
+  }
+
+  bool PassManager::Run(VMCode &code, const string &path, StandardLogger *logger) {
+    string msg;
+    char buf[32];
+
+    for (auto &unit : passes_) {
+      auto begin = std::chrono::steady_clock::now();
+      size_t changed = unit.pass(code);
+      auto end = std::chrono::steady_clock::now();
+
+      if (optimizer_verbose) {
+        snprintf(buf, sizeof(buf), "%.3f",
+          std::chrono::duration<double, std::milli>(end - begin).count());
+        AppendMessage(path + ":pass '" + unit.id + "' changed " + to_string(changed) +
+          " instruction(s) in " + buf + " ms", kStateNormal, logger);
+      }
+
+      if (!VerifyVMCode(code, msg)) {
+        AppendMessage("Invalid VMCode after pass '" + unit.id + "' - " + msg,
+          kStateError, logger);
+        return false;
+      }
+    }
+
+    if (report_coverage_) {
+      auto [total, specialized] = GetSpecializationCoverage(code);
+
+      if (total != 0) {
+        snprintf(buf, sizeof(buf), "%.1f", 100.0 * specialized / total);
+        AppendMessage(path + ":guarded fast path on " + to_string(specialized) + " of " +
+          to_string(total) + " operator(s) (" + buf + "%)", kStateNormal, logger);
+      }
+    }
+
+    //Targets are resolved after all passes because passes may move commands
+    size_t resolved = ResolveJumpTargets(code);
+
+    if (optimizer_verbose) {
+      AppendMessage(path + ":resolved " + to_string(resolved) + " jump target(s)",
+        kStateNormal, logger);
+    }
+
+    if (!VerifyVMCode(code, msg)) {
+      AppendMessage("Invalid VMCode after resolving jump targets - " + msg,
+        kStateError, logger);
+      return false;
+    }
+
+    return true;
+  }
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include "trace.h"
+/*
+  Compile-time passes over VMCode generated by VMCodeFactory.
+  Passes keep nest/jump record indexes valid after removing commands, and
+  PassManager verifies these indexes after each pass. Jump targets are
+  resolved after the last pass regardless of optimization level.
+*/
+namespace kagami {
+  //Fold operators over literal arguments into the argument of next command.
+  //Returns count of folded commands.
+  size_t FoldConstantExpressions(VMCode &code);
+
+  //Remove if/elif/case branches which can't be reached with literal conditions.
+  //Returns count of removed commands.
+  size_t EliminateDeadBranches(VMCode &code);
+
+  //Store destinations of branches, break and continue into instructions,
+  //so runtime can jump without looking up jump records.
+  //Returns count of resolved commands.
+  size_t ResolveJumpTargets(VMCode &code);
+
+  //Infer plain types of variables from literals, operators and return value
+  //constraints of functions, then mark operators with inferred operand types.
+  //Inference is name based and ignores scopes, so marked operators are guarded
+  //fast paths: Machine still compares operand type ids before using them.
+  //Returns count of marked commands.
+  size_t SpecializeOperators(VMCode &code);
+
+  //Count of operators which are able to be specialized, and ones marked with
+  //a guarded fast path
+  pair<size_t, size_t> GetSpecializationCoverage(VMCode &code);
+
+  //Check nest and jump record indexes, msg receives the first broken one
+  bool VerifyVMCode(VMCode &code, string &msg);
+  string DumpVMCode(VMCode &code);
+
+  //Returns count of changed commands
+  using VMCodePass = size_t(*)(VMCode &code);
+
+  struct PassUnit {
+    string id;
+    VMCodePass pass;
+  };
+
+  class PassManager {
+  private:
+    vector<PassUnit> passes_;
+    bool report_coverage_;
+
+  public:
+    PassManager() : passes_(), report_coverage_(false) {}
+    //Module code runs in root scope of its importer, so types of names
+    //can't be inferred from module code alone.
+    PassManager(size_t level, bool imported = false);
+
+    void AddPass(string id, VMCodePass pass) {
+      passes_.emplace_back(PassUnit{ id, pass });
+    }
+
+    bool Run(VMCode &code, const string &path, StandardLogger *logger);
+  };
+
+  const size_t kMaxOptimizationLevel = 3;
+  //Operator specialization is opt-in
+  const size_t kDefaultOptimizationLevel = 2;
+
+  //0 = no pass, 1 = constant folding, 2 = and dead branch elimination,
+  //3 = and operator specialization
+  void SetOptimizationLevel(size_t level);
+  size_t GetOptimizationLevel();
+  //Write VMCode to stdout after passes
+  void SetVMCodeDump(bool enable);
+  bool IsVMCodeDumpEnabled();
+  //Write pass statistics and timing into log
+  void SetOptimizerVerbose(bool verbose);
+}
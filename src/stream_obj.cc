@@ -33,6 +33,39 @@ namespace kagami {
     return Message().SetObject(result);
   }
 
+  //Buffer grows by chunk, size from script may be far beyond file length
+  constexpr size_t kReadChunkSize = 64 * 1024;
+
+  //Read at most size bytes into bytes object
+  Message InStreamRead(ObjectMap &p) {
+    auto tc = TypeChecking({ Expect("size", kTypeIdInt) }, p);
+    if (TC_FAIL(tc)) return TC_ERROR(tc);
+
+    InStream &ifs = p.Cast<InStream>(kStrMe);
+    auto size = p.Cast<int64_t>("size");
+
+    if (!ifs.Good()) {
+      return Message("Invalid instream.", kStateError);
+    }
+
+    if (size < 0) return Message("Invalid size", kStateError);
+
+    auto dest = make_shared<ByteArray>();
+    auto remaining = static_cast<size_t>(size);
+
+    while (remaining > 0) {
+      size_t offset = dest->size();
+      size_t chunk = std::min(remaining, kReadChunkSize);
+      dest->resize(offset + chunk);
+      size_t count = ifs.Read(dest->data() + offset, chunk);
+      dest->resize(offset + count);
+      if (count < chunk) break;
+      remaining -= count;
+    }
+
+    return Message().SetObject(Object(dest, kTypeIdBytes));
+  }
+
   Message InStreamEOF(ObjectMap &p) {
     InStream &ifs = p.Cast<InStream>(kStrMe);
     return Message().SetObject(ifs.eof());
@@ -67,6 +100,10 @@ namespace kagami {
       string str = obj.Cast<string>();
       result = ofs.Write(str);
     }
+    else if (obj.GetTypeId() == kTypeIdBytes) {
+      auto &base = obj.Cast<ByteArray>();
+      result = ofs.Write(base.data(), base.size());
+    }
     else {
       result = false;
     }
@@ -85,6 +122,7 @@ namespace kagami {
       .InitMethods(
         {
           FunctionImpl(InStreamGet, "", "get"),
+          FunctionImpl(InStreamRead, "size", "read"),
           FunctionImpl(InStreamEOF, "", "eof"),
           FunctionImpl(StreamFamilyState<InStream>, "", "good"),
         }
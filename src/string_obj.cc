@@ -1,4 +1,5 @@
 #include "string_obj.h"
+#include "kernels.h"
 
 namespace kagami {
   inline bool IsStringFamily(Object &obj) {
@@ -137,12 +138,398 @@ namespace kagami {
     return Message();
   }
 
+  //string_view
+  Message StringViewGetElement(ObjectMap &p) {
+    auto tc = TypeChecking({ Expect("index", kTypeIdInt) }, p);
+    if (TC_FAIL(tc)) return TC_ERROR(tc);
+
+    auto view = p.Cast<StringSlice>(kStrMe).View();
+    auto idx = p.Cast<int64_t>("index");
+
+    if (size_t(idx) >= view.size()) return Message("Index is out of range", kStateError);
+
+    return Message().SetObject(string(1, view[idx]));
+  }
+
+  Message StringViewGetSize(ObjectMap &p) {
+    auto &slice = p.Cast<StringSlice>(kStrMe);
+    return Message().SetObject(static_cast<int64_t>(slice.size()));
+  }
+
+  Message StringViewSubStr(ObjectMap &p) {
+    auto tc = TypeChecking(
+      {
+        Expect("start", kTypeIdInt),
+        Expect("size", kTypeIdInt)
+      }, p
+    );
+
+    if (TC_FAIL(tc)) return TC_ERROR(tc);
+
+    auto &slice = p.Cast<StringSlice>(kStrMe);
+    auto view = slice.View();
+    int64_t start = p.Cast<int64_t>("start");
+    int64_t size = p.Cast<int64_t>("size");
+
+    if (start < 0 || size < 0 || size_t(start) > view.size() ||
+      size_t(size) > view.size() - size_t(start)) {
+      return Message("Invalid index/size", kStateError);
+    }
+
+    //Sub-slice refers to the same source string, no content is copied
+    return Message().SetObject(Object(make_shared<StringSlice>(
+      slice.Slice(size_t(start), size_t(size))), kTypeIdStringView));
+  }
+
+  Message StringViewToString(ObjectMap &p) {
+    return Message().SetObject(string(p.Cast<StringSlice>(kStrMe).View()));
+  }
+
+  Message StringViewCompare(ObjectMap &p) {
+    auto &rhs = p[kStrRightHandSide];
+    auto lhs = p.Cast<StringSlice>(kStrMe).View();
+    bool result = false;
+
+    if (rhs.GetTypeId() == kTypeIdString) {
+      result = (lhs == string_view(rhs.Cast<string>()));
+    }
+    else if (rhs.GetTypeId() == kTypeIdStringView) {
+      result = (lhs == rhs.Cast<StringSlice>().View());
+    }
+
+    return Message().SetObject(result);
+  }
+
+  bool StringViewComparator(Object &lhs, Object &rhs) {
+    return lhs.Cast<StringSlice>().View() == rhs.Cast<StringSlice>().View();
+  }
+
+  size_t StringViewHasher(shared_ptr<void> ptr) {
+    return std::hash<string_view>()(static_pointer_cast<StringSlice>(ptr)->View());
+  }
+
+  void StringViewSizeIntrinsic(Object &me, ObjectView *, RuntimeFrame &frame) {
+    auto &slice = me.Cast<StringSlice>();
+    frame.RefreshReturnStack(Object(static_cast<int64_t>(slice.size()), kTypeIdInt));
+  }
+
+  /* Search and transform methods for string and string_view */
+  inline int64_t MakeStringIndex(size_t pos) {
+    return pos == string_view::npos ? int64_t(-1) : static_cast<int64_t>(pos);
+  }
+
+  Message StringFind(ObjectMap &p) {
+    string_view self, target;
+    FetchStringView(p[kStrMe], self);
+
+    if (!FetchStringView(p["target"], target)) {
+      return Message("Invalid target string", kStateError);
+    }
+
+    size_t start = 0;
+
+    if (!p["start"].Null()) {
+      if (p["start"].GetTypeId() != kTypeIdInt) return Message("Invalid start index", kStateError);
+      auto value = p.Cast<int64_t>("start");
+      if (value < 0) return Message("Invalid start index", kStateError);
+      start = static_cast<size_t>(value);
+    }
+
+    if (start > self.size()) return Message().SetObject(int64_t(-1));
+
+    auto pos = kernel::FindString(self.data() + start, self.size() - start,
+      target.data(), target.size());
+    if (pos != string_view::npos) pos += start;
+
+    return Message().SetObject(MakeStringIndex(pos));
+  }
+
+  Message StringReverseFind(ObjectMap &p) {
+    string_view self, target;
+    FetchStringView(p[kStrMe], self);
+
+    if (!FetchStringView(p["target"], target)) {
+      return Message("Invalid target string", kStateError);
+    }
+
+    return Message().SetObject(MakeStringIndex(
+      kernel::FindLastString(self.data(), self.size(), target.data(), target.size())));
+  }
+
+  Message StringContains(ObjectMap &p) {
+    string_view self, target;
+    FetchStringView(p[kStrMe], self);
+
+    if (!FetchStringView(p["target"], target)) {
+      return Message("Invalid target string", kStateError);
+    }
+
+    auto pos = kernel::FindString(self.data(), self.size(), target.data(), target.size());
+    return Message().SetObject(pos != string_view::npos);
+  }
+
+  template <bool ends_with>
+  Message StringAffixCheck(ObjectMap &p) {
+    string_view self, affix;
+    FetchStringView(p[kStrMe], self);
+
+    if (!FetchStringView(p["affix"], affix)) {
+      return Message("Invalid affix string", kStateError);
+    }
+
+    bool result = affix.size() <= self.size() && (ends_with ?
+      self.substr(self.size() - affix.size()) == affix :
+      self.substr(0, affix.size()) == affix);
+
+    return Message().SetObject(result);
+  }
+
+  Message StringSplit(ObjectMap &p) {
+    string_view self, delimiter;
+    FetchStringView(p[kStrMe], self);
+
+    if (!FetchStringView(p["delimiter"], delimiter) || delimiter.empty()) {
+      return Message("Invalid delimiter", kStateError);
+    }
+
+    ManagedArray base = make_shared<ObjectArray>();
+    size_t begin = 0;
+
+    while (true) {
+      auto pos = delimiter.size() == 1 ?
+        kernel::FindChar(self.data() + begin, self.size() - begin, delimiter[0]) :
+        kernel::FindString(self.data() + begin, self.size() - begin,
+          delimiter.data(), delimiter.size());
+
+      if (pos == string_view::npos) break;
+
+      base->emplace_back(Object(string(self.substr(begin, pos))));
+      begin += pos + delimiter.size();
+    }
+
+    base->emplace_back(Object(string(self.substr(begin))));
+    return Message().SetObject(Object(base, kTypeIdArray));
+  }
+
+  Message StringReplace(ObjectMap &p) {
+    string_view self, target, replacement;
+    FetchStringView(p[kStrMe], self);
+
+    if (!FetchStringView(p["target"], target) || target.empty()) {
+      return Message("Invalid target string", kStateError);
+    }
+
+    if (!FetchStringView(p["replacement"], replacement)) {
+      return Message("Invalid replacement string", kStateError);
+    }
+
+    string dest;
+    dest.reserve(self.size());
+    size_t begin = 0;
+
+    while (true) {
+      auto pos = kernel::FindString(self.data() + begin, self.size() - begin,
+        target.data(), target.size());
+
+      if (pos == string_view::npos) break;
+
+      dest.append(self.substr(begin, pos)).append(replacement);
+      begin += pos + target.size();
+    }
+
+    dest.append(self.substr(begin));
+    return Message().SetObject(Object(make_shared<string>(std::move(dest)), kTypeIdString));
+  }
+
+  Message StringToBytes(ObjectMap &p) {
+    string_view self;
+    FetchStringView(p[kStrMe], self);
+    auto dest = make_shared<ByteArray>(self.begin(), self.end());
+    return Message().SetObject(Object(dest, kTypeIdBytes));
+  }
+
+  Message StringTrim(ObjectMap &p) {
+    const string_view spaces(" \t\r\n\v\f");
+    string_view self;
+    FetchStringView(p[kStrMe], self);
+
+    auto begin = self.find_first_not_of(spaces);
+    if (begin == string_view::npos) return Message().SetObject(string());
+
+    auto end = self.find_last_not_of(spaces);
+    return Message().SetObject(string(self.substr(begin, end - begin + 1)));
+  }
+
+  //u8string
+  Message NewUTF8String(ObjectMap &p) {
+    auto &src = p["src"];
+    auto &type_id = src.GetTypeId();
+    string_view view;
+    string data;
+
+    if (type_id == kTypeIdUTF8String) {
+      return Message().SetObject(
+        Object(make_shared<UTF8String>(src.Cast<UTF8String>()), kTypeIdUTF8String));
+    }
+
+    if (type_id == kTypeIdWideString) {
+      auto &wstr = src.Cast<wstring>();
+      kernel::EncodeUTF8(wstr.data(), wstr.size(), data);
+    }
+    else if (type_id == kTypeIdBytes) {
+      auto &base = src.Cast<ByteArray>();
+      data.assign(base.begin(), base.end());
+    }
+    else if (FetchStringView(src, view)) {
+      data.assign(view);
+    }
+    else {
+      return Message("Invalid source for u8string - " + type_id, kStateError);
+    }
+
+    if (!kernel::ValidateUTF8(data.data(), data.size())) {
+      return Message("Invalid UTF-8 sequence", kStateError);
+    }
+
+    return Message().SetObject(
+      Object(make_shared<UTF8String>(std::move(data)), kTypeIdUTF8String));
+  }
+
+  Message UTF8StringGetElement(ObjectMap &p) {
+    auto tc = TypeChecking({ Expect("index", kTypeIdInt) }, p);
+    if (TC_FAIL(tc)) return TC_ERROR(tc);
+
+    auto &str = p.Cast<UTF8String>(kStrMe);
+    auto idx = p.Cast<int64_t>("index");
+
+    if (size_t(idx) >= str.size()) return Message("Index is out of range", kStateError);
+
+    return Message().SetObject(string(str.At(idx)));
+  }
+
+  Message UTF8StringCodeAt(ObjectMap &p) {
+    auto tc = TypeChecking({ Expect("index", kTypeIdInt) }, p);
+    if (TC_FAIL(tc)) return TC_ERROR(tc);
+
+    auto &str = p.Cast<UTF8String>(kStrMe);
+    auto idx = p.Cast<int64_t>("index");
+
+    if (size_t(idx) >= str.size()) return Message("Index is out of range", kStateError);
+
+    return Message().SetObject(static_cast<int64_t>(str.CodePointAt(idx)));
+  }
+
+  Message UTF8StringGetSize(ObjectMap &p) {
+    return Message().SetObject(static_cast<int64_t>(p.Cast<UTF8String>(kStrMe).size()));
+  }
+
+  Message UTF8StringByteSize(ObjectMap &p) {
+    return Message().SetObject(
+      static_cast<int64_t>(p.Cast<UTF8String>(kStrMe).Data().size()));
+  }
+
+  Message UTF8StringSubStr(ObjectMap &p) {
+    auto tc = TypeChecking(
+      {
+        Expect("start", kTypeIdInt),
+        Expect("size", kTypeIdInt)
+      }, p
+    );
+
+    if (TC_FAIL(tc)) return TC_ERROR(tc);
+
+    auto &str = p.Cast<UTF8String>(kStrMe);
+    int64_t start = p.Cast<int64_t>("start");
+    int64_t size = p.Cast<int64_t>("size");
+
+    if (start < 0 || size < 0 || size_t(start) > str.size() ||
+      size_t(size) > str.size() - size_t(start)) {
+      return Message("Invalid index/size", kStateError);
+    }
+
+    return Message().SetObject(Object(
+      make_shared<UTF8String>(string(str.Sub(start, size))), kTypeIdUTF8String));
+  }
+
+  Message UTF8StringToString(ObjectMap &p) {
+    return Message().SetObject(p.Cast<UTF8String>(kStrMe).Data());
+  }
+
+  Message UTF8StringToWide(ObjectMap &p) {
+    auto &data = p.Cast<UTF8String>(kStrMe).Data();
+    auto dest = make_shared<wstring>(data.size(), L'\0');
+    dest->resize(kernel::DecodeUTF8(data.data(), data.size(), dest->data()));
+    return Message().SetObject(Object(dest, kTypeIdWideString));
+  }
+
+  Message UTF8StringToBytes(ObjectMap &p) {
+    auto &data = p.Cast<UTF8String>(kStrMe).Data();
+    auto dest = make_shared<ByteArray>(data.begin(), data.end());
+    return Message().SetObject(Object(dest, kTypeIdBytes));
+  }
+
+  Message UTF8StringCompare(ObjectMap &p) {
+    auto &rhs = p[kStrRightHandSide];
+    auto &lhs = p.Cast<UTF8String>(kStrMe).Data();
+    bool result = false;
+
+    if (rhs.GetTypeId() == kTypeIdUTF8String) {
+      result = (lhs == rhs.Cast<UTF8String>().Data());
+    }
+
+    return Message().SetObject(result);
+  }
+
+  bool UTF8StringComparator(Object &lhs, Object &rhs) {
+    return lhs.Cast<UTF8String>().Data() == rhs.Cast<UTF8String>().Data();
+  }
+
+  size_t UTF8StringHasher(shared_ptr<void> ptr) {
+    return std::hash<string>()(static_pointer_cast<UTF8String>(ptr)->Data());
+  }
+
+  size_t UTF8StringSizer(shared_ptr<void> ptr) {
+    auto &str = *static_pointer_cast<UTF8String>(ptr);
+    return sizeof(UTF8String) + str.Data().capacity() + 1 +
+      (str.size() / UTF8String::kIndexStride + 1) * sizeof(size_t);
+  }
+
+  void UTF8StringSizeIntrinsic(Object &me, ObjectView *, RuntimeFrame &frame) {
+    auto &str = me.Cast<UTF8String>();
+    frame.RefreshReturnStack(Object(static_cast<int64_t>(str.size()), kTypeIdInt));
+  }
+
+  void UTF8StringAtIntrinsic(Object &me, ObjectView *args, RuntimeFrame &frame) {
+    auto &str = me.Cast<UTF8String>();
+    auto &index_obj = args[0].Seek();
+
+    if (index_obj.GetTypeId() != kTypeIdInt) {
+      frame.MakeError("Invalid index type");
+      return;
+    }
+
+    auto index = index_obj.Cast<int64_t>();
+    if (size_t(index) >= str.size()) {
+      frame.MakeError("Index is out of range");
+      return;
+    }
+
+    frame.RefreshReturnStack(Object(make_shared<string>(str.At(index)), kTypeIdString));
+  }
+
+  template <typename StringType>
+  size_t StringFamilySizer(shared_ptr<void> ptr) {
+    auto &str = *static_pointer_cast<StringType>(ptr);
+    return sizeof(StringType) + (str.capacity() + 1) * sizeof(typename StringType::value_type);
+  }
+
   void InitBaseTypes() {
     using management::CreateImpl;
     using namespace management::type;
 
     ObjectTraitsSetup(kTypeIdString, PlainDeliveryImpl<string>, PlainHasher<string>)
       .InitComparator(PlainComparator<string>)
+      .InitSizer(StringFamilySizer<string>)
       .InitConstructor(
         FunctionImpl(NewString, "raw_string", "string")
       )
@@ -153,12 +540,22 @@ namespace kagami {
           FunctionImpl(GetStringFamilySize<string>, "", "size"),
           FunctionImpl(StringFamilyConverting<wstring, string>, "", "to_wide"),
           FunctionImpl(StringCompare, kStrRightHandSide, kStrCompare),
-          FunctionImpl(StringToArray, "","to_array")
+          FunctionImpl(StringToArray, "","to_array"),
+          FunctionImpl(StringToBytes, "", "to_bytes"),
+          FunctionImpl(StringFind, "target|start", "find", kParamAutoFill).SetLimit(1),
+          FunctionImpl(StringReverseFind, "target", "rfind"),
+          FunctionImpl(StringContains, "target", "contains"),
+          FunctionImpl(StringAffixCheck<false>, "affix", "starts_with"),
+          FunctionImpl(StringAffixCheck<true>, "affix", "ends_with"),
+          FunctionImpl(StringSplit, "delimiter", "split"),
+          FunctionImpl(StringReplace, "target|replacement", "replace"),
+          FunctionImpl(StringTrim, "", "trim")
         }
     );
 
     ObjectTraitsSetup(kTypeIdWideString, PlainDeliveryImpl<wstring>, PlainHasher<wstring>)
       .InitComparator(PlainComparator<wstring>)
+      .InitSizer(StringFamilySizer<wstring>)
       .InitConstructor(
         FunctionImpl(NewWideString, "raw_string", "wstring")
       )
@@ -173,6 +570,61 @@ namespace kagami {
         }
     );
 
+    //Created by slice(), shares characters with source string
+    ObjectTraitsSetup(kTypeIdStringView, PlainDeliveryImpl<StringSlice>, StringViewHasher)
+      .InitComparator(StringViewComparator)
+      .InitMethods(
+        {
+          FunctionImpl(StringViewGetElement, "index", kStrAt),
+          FunctionImpl(StringViewSubStr, "start|size", "substr"),
+          FunctionImpl(StringViewGetSize, "", "size"),
+          FunctionImpl(StringViewToString, "", "to_string"),
+          FunctionImpl(StringViewCompare, kStrRightHandSide, kStrCompare),
+          FunctionImpl(StringToBytes, "", "to_bytes"),
+          FunctionImpl(StringFind, "target|start", "find", kParamAutoFill).SetLimit(1),
+          FunctionImpl(StringReverseFind, "target", "rfind"),
+          FunctionImpl(StringContains, "target", "contains"),
+          FunctionImpl(StringAffixCheck<false>, "affix", "starts_with"),
+          FunctionImpl(StringAffixCheck<true>, "affix", "ends_with"),
+          FunctionImpl(StringSplit, "delimiter", "split"),
+          FunctionImpl(StringReplace, "target|replacement", "replace"),
+          FunctionImpl(StringTrim, "", "trim")
+        }
+    );
+
+    //Code point based string, see UTF8String
+    ObjectTraitsSetup(kTypeIdUTF8String, PlainDeliveryImpl<UTF8String>, UTF8StringHasher)
+      .InitComparator(UTF8StringComparator)
+      .InitSizer(UTF8StringSizer)
+      .InitConstructor(
+        FunctionImpl(NewUTF8String, "src", "u8string")
+      )
+      .InitMethods(
+        {
+          FunctionImpl(UTF8StringGetElement, "index", kStrAt),
+          FunctionImpl(UTF8StringCodeAt, "index", "code_at"),
+          FunctionImpl(UTF8StringGetSize, "", "size"),
+          FunctionImpl(UTF8StringByteSize, "", "byte_size"),
+          FunctionImpl(UTF8StringSubStr, "start|size", "substr"),
+          FunctionImpl(UTF8StringToString, "", "to_string"),
+          FunctionImpl(UTF8StringToWide, "", "to_wide"),
+          FunctionImpl(UTF8StringToBytes, "", "to_bytes"),
+          FunctionImpl(UTF8StringCompare, kStrRightHandSide, kStrCompare)
+        }
+    );
+
+    CreateIntrinsics(
+      {
+        IntrinsicImpl{ "size", kTypeIdString, 0, StringFamilySizeIntrinsic<string> },
+        IntrinsicImpl{ "substr", kTypeIdString, 2, StringFamilySubStrIntrinsic<string> },
+        IntrinsicImpl{ "size", kTypeIdWideString, 0, StringFamilySizeIntrinsic<wstring> },
+        IntrinsicImpl{ "substr", kTypeIdWideString, 2, StringFamilySubStrIntrinsic<wstring> },
+        IntrinsicImpl{ "size", kTypeIdStringView, 0, StringViewSizeIntrinsic },
+        IntrinsicImpl{ "size", kTypeIdUTF8String, 0, UTF8StringSizeIntrinsic },
+        IntrinsicImpl{ kStrAt, kTypeIdUTF8String, 1, UTF8StringAtIntrinsic }
+      }
+    );
+
     CreateImpl(FunctionImpl(DecimalConvert<2>, "str", "bin"));
     CreateImpl(FunctionImpl(DecimalConvert<8>, "str", "octa"));
     CreateImpl(FunctionImpl(DecimalConvert<16>, "str", "hex"));
@@ -183,5 +635,7 @@ namespace kagami {
 
     EXPORT_CONSTANT(kTypeIdString);
     EXPORT_CONSTANT(kTypeIdWideString);
+    EXPORT_CONSTANT(kTypeIdStringView);
+    EXPORT_CONSTANT(kTypeIdUTF8String);
   }
 }
\ No newline at end of file
@@ -27,6 +27,35 @@ namespace kagami {
     return Message().SetObject(Object(make_shared<StringType>(output), type_id));
   }
 
+  template <typename StringType>
+  void StringFamilySizeIntrinsic(Object &me, ObjectView *, RuntimeFrame &frame) {
+    auto &str = me.Cast<StringType>();
+    frame.RefreshReturnStack(Object(static_cast<int64_t>(str.size()), kTypeIdInt));
+  }
+
+  template <typename StringType>
+  void StringFamilySubStrIntrinsic(Object &me, ObjectView *args, RuntimeFrame &frame) {
+    auto &str = me.Cast<StringType>();
+    auto &start_obj = args[0].Seek();
+    auto &size_obj = args[1].Seek();
+
+    if (start_obj.GetTypeId() != kTypeIdInt || size_obj.GetTypeId() != kTypeIdInt) {
+      frame.MakeError("Invalid index/size type");
+      return;
+    }
+
+    int64_t start = start_obj.Cast<int64_t>();
+    int64_t size = size_obj.Cast<int64_t>();
+
+    if (start < 0 || size > static_cast<int64_t>(str.size() - start)) {
+      frame.MakeError("Invalid index/size");
+      return;
+    }
+
+    frame.RefreshReturnStack(
+      Object(make_shared<StringType>(str.substr(start, size)), me.GetTypeId()));
+  }
+
   template <typename StringType>
   Message StringFamilyGetElement(ObjectMap &p) {
     StringType &str = p.Cast<StringType>(kStrMe);
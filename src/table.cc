@@ -0,0 +1,248 @@
+#include "management.h"
+
+namespace kagami {
+  inline size_t SlotPosition(size_t hash, size_t mask) {
+    uint64_t value = static_cast<uint64_t>(hash) * 0x9E3779B97F4A7C15ULL;
+    return static_cast<size_t>(value ^ (value >> 32)) & mask;
+  }
+
+  ObjectTable::KeyKind ObjectTable::GetKeyKind(const Object &key) {
+    auto &type_id = key.GetTypeId();
+    if (type_id == kTypeIdInt) return kKeyInt;
+    if (type_id == kTypeIdString) return kKeyString;
+    return kKeyGeneric;
+  }
+
+  size_t ObjectTable::HashKey(const Object &key, KeyKind kind) {
+    auto &obj = const_cast<Object &>(key);
+    size_t result = 0;
+
+    switch (kind) {
+    //Identity hash, equal hash value means equal key on 64-bit platforms
+    case kKeyInt:result = static_cast<size_t>(obj.Cast<int64_t>()); break;
+    case kKeyString:result = std::hash<string>()(obj.Cast<string>()); break;
+    default:
+      if (management::type::IsHashable(obj)) {
+        result = management::type::GetHash(obj);
+      }
+      break;
+    }
+
+    return result;
+  }
+
+  bool ObjectTable::KeyEquals(const Object &lhs, KeyKind lhs_kind,
+    const Object &rhs, KeyKind rhs_kind) {
+    if (lhs_kind != rhs_kind) return false;
+
+    auto &lhs_obj = const_cast<Object &>(lhs);
+    auto &rhs_obj = const_cast<Object &>(rhs);
+    bool result = false;
+
+    switch (lhs_kind) {
+    case kKeyInt:
+      result = lhs_obj.Cast<int64_t>() == rhs_obj.Cast<int64_t>();
+      break;
+    case kKeyString:
+      result = lhs_obj.Cast<string>() == rhs_obj.Cast<string>();
+      break;
+    default:
+      //Avoid locking the same object twice in CompareObjects()
+      result = &lhs == &rhs || management::type::CompareObjects(lhs_obj, rhs_obj);
+      break;
+    }
+
+    return result;
+  }
+
+  size_t ObjectTable::FindSlot(const Object &key, KeyKind kind, size_t hash) const {
+    if (slots_.empty()) return kSlotEmpty;
+
+    size_t mask = slots_.size() - 1;
+    size_t pos = SlotPosition(hash, mask);
+
+    while (slots_[pos].index != kSlotEmpty) {
+      auto &slot = slots_[pos];
+
+      if (slot.index != kSlotDeleted && slot.hash == hash && slot.kind == kind) {
+        if (kind == kKeyInt && sizeof(size_t) >= sizeof(int64_t)) return pos;
+        auto &entry = GetEntry(slot.index);
+        if (KeyEquals(entry.value.first, entry.kind, key, kind)) return pos;
+      }
+
+      pos = (pos + 1) & mask;
+    }
+
+    return kSlotEmpty;
+  }
+
+  void ObjectTable::InsertSlot(size_t hash, size_t index, KeyKind kind) {
+    size_t mask = slots_.size() - 1;
+    size_t pos = SlotPosition(hash, mask);
+
+    while (slots_[pos].index != kSlotEmpty && slots_[pos].index != kSlotDeleted) {
+      pos = (pos + 1) & mask;
+    }
+
+    if (slots_[pos].index == kSlotEmpty) used_slots_ += 1;
+    slots_[pos] = Slot{ hash, static_cast<uint32_t>(index), static_cast<uint32_t>(kind) };
+  }
+
+  size_t ObjectTable::CreateEntry(const ObjectPair &value, size_t hash, KeyKind kind) {
+    size_t index = entry_count_;
+
+    if (!free_list_.empty()) {
+      index = free_list_.back();
+      free_list_.pop_back();
+      GetEntry(index).~Entry();
+    }
+    else {
+      if ((entry_count_ & (kChunkSize - 1)) == 0) {
+        chunks_.emplace_back(new EntryStorage[kChunkSize]);
+      }
+
+      entry_count_ += 1;
+    }
+
+    new (&chunks_[index >> kChunkShift][index & (kChunkSize - 1)]) Entry(value, hash, kind);
+    return index;
+  }
+
+  //Destroy key/value in place, so references to them will be notified
+  void ObjectTable::ReleaseEntry(size_t index) {
+    auto &entry = GetEntry(index);
+    entry.~Entry();
+    new (&entry) Entry();
+    free_list_.push_back(index);
+  }
+
+  void ObjectTable::Rehash(size_t slot_count) {
+    slots_.assign(slot_count, Slot{ 0, kSlotEmpty, kKeyGeneric });
+    used_slots_ = 0;
+
+    for (size_t idx = 0; idx < entry_count_; ++idx) {
+      auto &entry = GetEntry(idx);
+      if (entry.alive) InsertSlot(entry.hash, idx, entry.kind);
+    }
+  }
+
+  void ObjectTable::CopyFrom(const ObjectTable &rhs) {
+    reserve(rhs.size_);
+
+    for (size_t idx = 0; idx < rhs.entry_count_; ++idx) {
+      auto &unit = rhs.GetEntry(idx);
+      if (!unit.alive) continue;
+      auto index = CreateEntry(unit.value, unit.hash, unit.kind);
+      InsertSlot(unit.hash, index, unit.kind);
+      size_ += 1;
+    }
+  }
+
+  ObjectTable::iterator ObjectTable::EraseSlot(size_t slot) {
+    size_t index = slots_[slot].index;
+    slots_[slot].index = kSlotDeleted;
+    ReleaseEntry(index);
+    size_ -= 1;
+    return iterator(this, index + 1);
+  }
+
+  ObjectTable::ObjectTable(const ObjectTable &rhs) :
+    chunks_(), entry_count_(0), free_list_(), slots_(), size_(0), used_slots_(0),
+    generation_(0) {
+    CopyFrom(rhs);
+  }
+
+  ObjectTable &ObjectTable::operator=(const ObjectTable &rhs) {
+    if (this != &rhs) {
+      clear();
+      CopyFrom(rhs);
+    }
+
+    return *this;
+  }
+
+  pair<ObjectTable::iterator, bool> ObjectTable::insert(const ObjectPair &value) {
+    auto kind = GetKeyKind(value.first);
+    auto hash = HashKey(value.first, kind);
+    auto slot = FindSlot(value.first, kind, hash);
+
+    if (slot != kSlotEmpty) {
+      return make_pair(iterator(this, slots_[slot].index), false);
+    }
+
+    //Keep load factor(including deleted slots) under 0.75
+    if ((used_slots_ + 1) * 4 > slots_.size() * 3) {
+      size_t slot_count = kMinimumSlots;
+      while (slot_count * 3 < (size_ + 1) * 4 * 2) slot_count *= 2;
+      Rehash(slot_count);
+    }
+
+    auto index = CreateEntry(value, hash, kind);
+    InsertSlot(hash, index, kind);
+    size_ += 1;
+    return make_pair(iterator(this, index), true);
+  }
+
+  Object &ObjectTable::operator[](const Object &key) {
+    auto it = find(key);
+
+    if (it == end()) {
+      it = insert(ObjectPair(key, Object())).first;
+    }
+
+    return it->second;
+  }
+
+  ObjectTable::iterator ObjectTable::find(const Object &key) {
+    auto kind = GetKeyKind(key);
+    auto slot = FindSlot(key, kind, HashKey(key, kind));
+    if (slot == kSlotEmpty) return end();
+    return iterator(this, slots_[slot].index);
+  }
+
+  size_t ObjectTable::erase(const Object &key) {
+    auto kind = GetKeyKind(key);
+    auto slot = FindSlot(key, kind, HashKey(key, kind));
+    if (slot == kSlotEmpty) return 0;
+    EraseSlot(slot);
+    return 1;
+  }
+
+  ObjectTable::iterator ObjectTable::erase(iterator it) {
+    size_t index = it.GetIndex();
+    size_t mask = slots_.size() - 1;
+    size_t pos = SlotPosition(GetEntry(index).hash, mask);
+
+    while (slots_[pos].index != index) {
+      pos = (pos + 1) & mask;
+    }
+
+    return EraseSlot(pos);
+  }
+
+  void ObjectTable::clear() {
+    for (size_t idx = 0; idx < entry_count_; ++idx) {
+      GetEntry(idx).~Entry();
+    }
+
+    chunks_.clear();
+    entry_count_ = 0;
+    free_list_.clear();
+    slots_.clear();
+    size_ = 0;
+    used_slots_ = 0;
+    generation_ += 1;
+  }
+
+  void ObjectTable::reserve(size_t count) {
+    size_t slot_count = kMinimumSlots;
+    while (slot_count * 3 < count * 4) slot_count *= 2;
+    if (slot_count > slots_.size()) Rehash(slot_count);
+  }
+
+  size_t ObjectTable::allocated_bytes() const {
+    return chunks_.size() * kChunkSize * sizeof(EntryStorage)
+      + slots_.capacity() * sizeof(Slot)
+      + free_list_.capacity() * sizeof(size_t);
+  }
+}
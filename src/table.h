@@ -0,0 +1,146 @@
+#pragma once
+#include "object.h"
+/*
+  Open-addressing hash table for script table type.
+  Entries are stored in fixed-size chunks, so references to keys/values
+  stay valid after rehashing. Probing only touches the slot array, which caches the
+  hash value of every entry. Int and string keys are hashed and compared
+  directly without going through object traits.
+  clear() releases all chunks and bumps the generation of table, iterators
+  created before it are no longer valid and must be checked with IsValid().
+*/
+namespace kagami {
+  class ObjectTable {
+  public:
+    using value_type = ObjectPair;
+
+  private:
+    enum KeyKind { kKeyInt, kKeyString, kKeyGeneric };
+
+    struct Entry {
+      ObjectPair value;
+      size_t hash;
+      KeyKind kind;
+      bool alive;
+
+      Entry() : value(), hash(0), kind(kKeyGeneric), alive(false) {}
+      Entry(const ObjectPair &value, size_t hash, KeyKind kind) :
+        value(value), hash(hash), kind(kind), alive(true) {}
+    };
+
+    struct Slot {
+      size_t hash;
+      uint32_t index;
+      uint32_t kind;
+    };
+
+    static constexpr uint32_t kSlotEmpty = ~uint32_t(0);
+    static constexpr uint32_t kSlotDeleted = ~uint32_t(0) - 1;
+    static constexpr size_t kMinimumSlots = 8;
+    static constexpr size_t kChunkShift = 6;
+    static constexpr size_t kChunkSize = size_t(1) << kChunkShift;
+
+    using EntryStorage = std::aligned_storage_t<sizeof(Entry), alignof(Entry)>;
+
+    vector<unique_ptr<EntryStorage[]>> chunks_;
+    size_t entry_count_;
+    vector<size_t> free_list_;
+    vector<Slot> slots_;
+    size_t size_;
+    size_t used_slots_;
+    size_t generation_;
+
+  public:
+    class iterator {
+    private:
+      ObjectTable *base_;
+      size_t index_;
+      size_t generation_;
+
+      void SkipDeadEntries() {
+        while (index_ < base_->entry_count_ && !base_->GetEntry(index_).alive) ++index_;
+      }
+
+    public:
+      iterator() : base_(nullptr), index_(0), generation_(0) {}
+      iterator(ObjectTable *base, size_t index) :
+        base_(base), index_(index), generation_(base->generation_) {
+        SkipDeadEntries();
+      }
+
+      ObjectPair &operator*() const { return base_->GetEntry(index_).value; }
+      ObjectPair *operator->() const { return &base_->GetEntry(index_).value; }
+
+      iterator &operator++() {
+        ++index_;
+        SkipDeadEntries();
+        return *this;
+      }
+
+      iterator operator++(int) {
+        iterator temp(*this);
+        ++(*this);
+        return temp;
+      }
+
+      bool operator==(const iterator &rhs) const
+      { return base_ == rhs.base_ && index_ == rhs.index_; }
+      bool operator!=(const iterator &rhs) const
+      { return !operator==(rhs); }
+
+      size_t GetIndex() const { return index_; }
+
+      bool IsValid() const {
+        return base_ == nullptr || base_->generation_ == generation_;
+      }
+
+      bool IsEnd() const { return index_ >= base_->entry_count_; }
+    };
+
+  private:
+    Entry &GetEntry(size_t index) {
+      return *std::launder(reinterpret_cast<Entry *>(
+        &chunks_[index >> kChunkShift][index & (kChunkSize - 1)]));
+    }
+
+    const Entry &GetEntry(size_t index) const {
+      return *std::launder(reinterpret_cast<const Entry *>(
+        &chunks_[index >> kChunkShift][index & (kChunkSize - 1)]));
+    }
+
+    static KeyKind GetKeyKind(const Object &key);
+    static size_t HashKey(const Object &key, KeyKind kind);
+    static bool KeyEquals(const Object &lhs, KeyKind lhs_kind,
+      const Object &rhs, KeyKind rhs_kind);
+
+    size_t FindSlot(const Object &key, KeyKind kind, size_t hash) const;
+    void InsertSlot(size_t hash, size_t index, KeyKind kind);
+    size_t CreateEntry(const ObjectPair &value, size_t hash, KeyKind kind);
+    void ReleaseEntry(size_t index);
+    void Rehash(size_t slot_count);
+    void CopyFrom(const ObjectTable &rhs);
+    iterator EraseSlot(size_t slot);
+
+  public:
+    ObjectTable() : chunks_(), entry_count_(0), free_list_(), slots_(),
+      size_(0), used_slots_(0), generation_(0) {}
+
+    ~ObjectTable() { clear(); }
+    ObjectTable(const ObjectTable &rhs);
+    ObjectTable &operator=(const ObjectTable &rhs);
+
+    pair<iterator, bool> insert(const ObjectPair &value);
+    Object &operator[](const Object &key);
+    iterator find(const Object &key);
+    size_t erase(const Object &key);
+    iterator erase(iterator it);
+    void clear();
+    void reserve(size_t count);
+    size_t allocated_bytes() const;
+
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, entry_count_); }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+  };
+}
@@ -24,6 +24,7 @@ namespace kagami {
     bool is_constraint; //for fnexpr
 
     string domain;
+    SymbolId domain_symbol;
     ArgumentType domain_type;
 
     ArgumentOption() : 
@@ -33,6 +34,7 @@ namespace kagami {
       assert_chain_tail(false),
       is_constraint(false),
       domain(), 
+      domain_symbol(kSymbolNull),
       domain_type(kArgumentNull) {}
   };
 
@@ -43,8 +45,13 @@ namespace kagami {
     bool use_last_assert;
     size_t nest;
     size_t nest_end;
+    //Destination of if/elif/when/case when current branch is not taken
+    size_t jump_target;
     size_t escape_depth;
     Keyword nest_root;
+    //Inferred plain type of both operands, set by type inference pass.
+    //Machine checks it against actual operands before using it
+    PlainType operand_type;
 
     RequestOption() : 
       void_call(false), 
@@ -53,15 +60,21 @@ namespace kagami {
       use_last_assert(false),
       nest(0),
       nest_end(0),
+      jump_target(0),
       escape_depth(0),
-      nest_root(kKeywordNull) {}
+      nest_root(kKeywordNull),
+      operand_type(kNotPlainType) {}
   };
 
   class Argument {
   private:
     string data_;
+    //Interned data_, only for object stack arguments and identifiers
+    SymbolId symbol_;
     ArgumentType type_;
     StringType token_type_;
+    //Constant object of literal, cached by machine at first fetch
+    mutable Object *constant_;
 
   public:
     ArgumentOption option;
@@ -69,8 +82,10 @@ namespace kagami {
   public:
     Argument() :
       data_(),
+      symbol_(kSymbolNull),
       type_(kArgumentNull),
       token_type_(kStringTypeNull),
+      constant_(nullptr),
       option() {}
 
     Argument(
@@ -78,23 +93,33 @@ namespace kagami {
       ArgumentType type,
       StringType token_type) :
       data_(data),
+      //Literal values are never looked up by name
+      symbol_(type == kArgumentObjectStack ||
+        (type == kArgumentLiteral && token_type == kStringTypeIdentifier) ?
+        InternSymbol(data) : kSymbolNull),
       type_(type),
       token_type_(token_type),
+      constant_(nullptr),
       option() {}
 
     void SetDomain(string id, ArgumentType type) {
       option.domain = id;
+      option.domain_symbol = id.empty() ? kSymbolNull : InternSymbol(id);
       option.domain_type = type;
     }
 
-    auto &GetData() { return data_; }
-    auto &GetType() { return type_; }
-    StringType GetStringType() { return token_type_; }
+    const string &GetData() const { return data_; }
+    SymbolId GetSymbol() const { return symbol_; }
+    Object *GetConstant() const { return constant_; }
+    void SetConstant(Object *ptr) const { constant_ = ptr; }
+    ArgumentType GetType() const { return type_; }
+    StringType GetStringType() const { return token_type_; }
     bool IsPlaceholder() const { return type_ == kArgumentNull; }
   };
 
   struct FunctionInfo {
     string id;
+    SymbolId symbol;
     Argument domain;
   };
 
@@ -114,7 +139,7 @@ namespace kagami {
       option() {}
 
     Request(string token, Argument domain = Argument()) :
-      data_(FunctionInfo{ token, domain }),
+      data_(FunctionInfo{ token, InternSymbol(token), domain }),
       idx(0),
       type(kRequestFunction),
       option() {}
@@ -125,20 +150,30 @@ namespace kagami {
       type(kRequestNull),
       option() {}
 
-    string GetInterfaceId() {
+    const string &GetInterfaceId() const {
+      static const string empty;
       if (type == kRequestFunction) {
         return std::get<FunctionInfo>(data_).id;
       }
 
-      return string();
+      return empty;
     }
 
-    Argument GetInterfaceDomain() {
+    SymbolId GetInterfaceSymbol() const {
+      if (type == kRequestFunction) {
+        return std::get<FunctionInfo>(data_).symbol;
+      }
+
+      return kSymbolNull;
+    }
+
+    const Argument &GetInterfaceDomain() const {
+      static const Argument placeholder;
       if (type == kRequestFunction) {
         return std::get<FunctionInfo>(data_).domain;
       }
 
-      return Argument();
+      return placeholder;
     }
 
     Keyword GetKeywordValue() {
@@ -167,13 +202,14 @@ namespace kagami {
     VMCode(VMCode *source) : deque<Command>(), source_(source) {}
     VMCode(const VMCode &rhs) : deque<Command>(rhs), source_(rhs.source_),
       jump_record_(rhs.jump_record_) {}
-    VMCode(const VMCode &&rhs) : VMCode(rhs) {}
+    VMCode(VMCode &&rhs) : deque<Command>(std::move(rhs)), source_(rhs.source_),
+      jump_record_(std::move(rhs.jump_record_)) {}
 
     void AddJumpRecord(size_t index, list<size_t> record) {
       jump_record_.emplace(make_pair(index, record));
     }
 
-    bool FindJumpRecord(size_t index, stack<size_t> &dest);
+    auto &GetJumpRecord() { return jump_record_; }
   };
 
   using VMCodePointer = VMCode * ;
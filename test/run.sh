@@ -0,0 +1,26 @@
+#!/bin/sh
+# Runs regression scripts and compares their output with expected files.
+# Script output and error messages are written to NAME.expected in order.
+# Usage: run.sh [path of kagami executable]
+KAGAMI=${1:-kagami}
+DIR=$(dirname "$0")
+TMP=${TMPDIR:-/tmp}/kagami_test.$$
+failed=0
+
+for script in "$DIR"/*.kagami; do
+  name=$(basename "$script" .kagami)
+  rm -f "$TMP.out"
+  "$KAGAMI" -script="$script" -vm_stdout="$TMP.out" 2> "$TMP.err" > /dev/null
+  cat "$TMP.out" "$TMP.err" > "$TMP.result" 2> /dev/null
+
+  if cmp -s "$TMP.result" "$DIR/$name.expected"; then
+    echo "pass $name"
+  else
+    echo "FAIL $name"
+    diff "$DIR/$name.expected" "$TMP.result"
+    failed=1
+  fi
+done
+
+rm -f "$TMP.out" "$TMP.err" "$TMP.result"
+exit $failed